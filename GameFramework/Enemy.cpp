@@ -1,12 +1,21 @@
 #include "Enemy.h"
-#include "CGameApp.h"
 
-extern CGameApp g_App;
+// Pixels per second, the old per frame step at 60 frames per second
+static const double ENEMY_SPEED = 0.8 * 60.0;
 
-Enemy::Enemy(const BackBuffer *pBackBuffer)
+// Seconds between two shots
+static const float SHOOT_INTERVAL = 5.0f;
+
+Enemy::Enemy()
+{
+}
+
+Enemy::Enemy(const Vec2& position) : mPosition(position), mPrevPosition(position)
+{
+}
+
+Enemy::Enemy(const Vec2& position, float cooldown) : mPosition(position), mPrevPosition(position), shootCooldown(cooldown)
 {
-	m_pSprite = new Sprite("data/enemy.bmp", RGB(0xff, 0x00, 0xff));
-	m_pSprite->setBackBuffer(pBackBuffer);
 }
 
 
@@ -14,17 +23,17 @@ Enemy::~Enemy()
 {
 }
 
-void Enemy::move()
+void Enemy::move(float dt)
 {
-	this->m_pSprite->mPosition.x += .8;
+	this->mPosition.x += ENEMY_SPEED * dt;
 }
 
-void Enemy::shoot()
+bool Enemy::shoot()
 {
-	if (shootCooldown < 5) {
-		Bullet bullet(g_App.m_pBBuffer);
-		bullet.m_pSprite->mPosition = this->m_pSprite->mPosition;
-		g_App.bullets3.push_back(bullet);
-		shootCooldown = 300;
+	if (shootCooldown <= 0) {
+		shootCooldown = SHOOT_INTERVAL;
+		return true;
 	}
+
+	return false;
 }
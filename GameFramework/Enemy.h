@@ -1,16 +1,20 @@
 #pragma once
-#include "Main.h"
-#include "Sprite.h"
+#include "Vec2.h"
 
 class Enemy
 {
 public:
-	Enemy(const BackBuffer *pBackBuffer);
+	Enemy();
+	Enemy(const Vec2& position);
+	Enemy(const Vec2& position, float cooldown);
 	~Enemy();
 
-	Sprite*					m_pSprite;
-	int shootCooldown = 200;
-	void move();
-	void shoot();
+	Vec2 mPosition;
+	Vec2 mPrevPosition;			// Position before the last step, to draw in between
+	float shootCooldown = 3.25f;	// Seconds to the next shot
+
+	// dt is the step length in seconds
+	void move(float dt);
+	bool shoot();
 
 };
@@ -0,0 +1,152 @@
+// AudioEngine.h
+// Plays sounds on a thread of its own. The thread mixes the voices a
+// 10 ms block at a time into a ring of 16 bit frames kept a few blocks
+// ahead of the output, and hands the output whatever it takes: the output
+// sets the pace, the ring keeps it fed when the thread is late.
+//
+// play() and the other voice calls only queue a request, the audio thread
+// applies the queued requests before its next block. The requests go
+// through a lock free ring from the one thread making them to the audio
+// thread, so the game never waits on the mixer: when the ring is full the
+// request is dropped and counted instead. The time taken to
+// mix each block goes into a histogram, against the 10 ms the block lasts
+// that is the CPU the sound costs.
+//
+// Streams read ahead on the audio thread between blocks, never while a
+// block is mixed, so a slow disk shows as an underrun rather than a late
+// block.
+//
+// Started without a thread, the engine mixes on the calling thread as
+// render() asks: the headless driver writes the sound of a run to a file
+// in step with the simulation that way.
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+#include "AudioMixer.h"
+#include "AudioOutput.h"
+#include "FrameStats.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// What the mixer did so far.
+struct AudioStats
+{
+	AudioStats() : blocks(0), peakVoices(0), droppedVoices(0), commands(0), underruns(0) { }
+
+	unsigned long blocks;
+	int peakVoices;
+	unsigned long droppedVoices;		// Plays refused, every voice busy
+	unsigned long commands;				// Requests applied
+	unsigned long underruns;			// Blocks a stream could not fill
+	FrameHistogram mixTimes;			// Seconds to mix a block
+};
+
+class AudioEngine
+{
+public:
+	enum
+	{
+		SAMPLE_RATE = 44100,
+		CHANNELS = 2,
+		BLOCK_FRAMES = SAMPLE_RATE / 100,	// 10 ms
+		RING_BLOCKS = 3,
+		// Requests waiting for the audio thread. The busiest load measured,
+		// 20000 a second, posts about 170 per 120 Hz frame; this holds six
+		// such frames, so the thread can miss a few wakeups in a row
+		// without a request being dropped.
+		COMMAND_CAPACITY = 1024
+	};
+
+	AudioEngine();
+	~AudioEngine();
+
+	// Opens the output, which the engine then owns, and starts the audio
+	// thread, or lets render() mix when threaded is false. Returns false
+	// (and deletes the output) when it cannot be opened.
+	bool start(AudioOutput *output, bool threaded = true);
+
+	// Stops the thread, applies the requests left, mixes what render()
+	// left in the ring into the output and closes it.
+	void stop();
+
+	bool started() const { return mOutput != 0; }
+	bool threaded() const { return mThread.joinable(); }
+
+	// Voice requests, see AudioMixer, all from the same thread. play()
+	// returns the id of the voice, 0 when the request did not fit.
+	VoiceId play(const SoundHandle &sound, float volume = 1.0f, float pan = 0.0f, bool loop = false);
+	// Plays a stream opened at SAMPLE_RATE, the engine takes it over: the
+	// caller must not touch it after.
+	VoiceId playStream(const StreamHandle &stream, float volume = 1.0f, float pan = 0.0f);
+	void stopVoice(VoiceId id);
+	void stopAllVoices();
+	void setVolume(VoiceId id, float volume);
+	void setPan(VoiceId id, float pan);
+
+	// Mixes frames frames on the calling thread and writes them, when
+	// started without a thread.
+	void render(int frames);
+
+	// A copy of the counters, safe while the thread runs.
+	AudioStats stats() const;
+
+	// The request ring, read without waiting on the audio thread.
+	int commandDepth() const { return mCommands.depth(); }
+	int peakCommandDepth() const { return mCommands.peakDepth(); }
+	unsigned long commandsPosted() const { return mCommands.pushed(); }
+	unsigned long commandOverflows() const { return mCommands.overflows(); }
+
+	static double blockSeconds() { return (double)BLOCK_FRAMES / SAMPLE_RATE; }
+
+private:
+	struct Command
+	{
+		enum Type { PLAY, PLAY_STREAM, STOP, STOP_ALL, SET_VOLUME, SET_PAN };
+
+		Type type;
+		VoiceId id;
+		SoundHandle sound;
+		StreamHandle stream;
+		float volume;
+		float pan;
+		bool loop;
+	};
+
+	bool post(Command &command);
+	void applyCommands();
+
+	void run();
+	void mixBlock();
+	int drain();
+	int ringFree() const { return RING_FRAMES - (int)(mWritten - mRead); }
+
+	AudioEngine(const AudioEngine&);
+	AudioEngine& operator=(const AudioEngine&);
+
+private:
+	enum { RING_FRAMES = RING_BLOCKS * BLOCK_FRAMES };
+
+	AudioMixer mMixer;
+	AudioOutput *mOutput;
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+
+	// Requests of the game thread waiting for the next block
+	SpscQueue<Command> mCommands;
+	Command mApplying;						// Taken by the audio thread
+	VoiceId mNextVoice;
+	unsigned long mApplied;
+
+	// Mixed frames, [mRead, mWritten) counted from the start
+	std::vector<float> mMixBuffer;
+	std::vector<int16_t> mRing;
+	uint64_t mWritten;
+	uint64_t mRead;
+
+	mutable std::mutex mStatsMutex;
+	AudioStats mStats;
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,91 @@
+// AudioMixer.h
+// Adds up the voices playing into blocks of stereo float samples. A voice
+// is a cached sound played from the start, once or looping, with its own
+// volume and pan; any number of them play the same sound at once. Sounds
+// at the rate of the mixer, as a SoundCache made for it loads them, are
+// added frame for frame; others are stepped through at the ratio of the
+// rates with linear interpolation.
+//
+// A voice can also play an AudioStream, read as it plays; prefetch()
+// tops every stream up and is meant to run outside the mix.
+//
+// Voices are named by ids the caller makes up, so the one asking for a
+// sound can stop it or change it later without waiting for an answer.
+// The mixer is not thread safe, the audio engine owns it.
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+#include "SoundCache.h"
+#include "AudioStream.h"
+#include <stdint.h>
+
+typedef uint32_t VoiceId;					// 0 is no voice
+
+class AudioMixer
+{
+public:
+	enum { MAX_VOICES = 64 };
+
+	explicit AudioMixer(int sampleRate);
+
+	// Starts the sound on a new voice. volume scales the samples, pan goes
+	// from -1 (left) to 1 (right): the far side fades out while the near
+	// one keeps the volume, centered sounds play at full volume on both.
+	// Returns false when the sound is empty or every voice is busy.
+	bool play(VoiceId id, const SoundHandle &sound, float volume, float pan, bool loop);
+
+	// Same for a stream opened at the rate of the mixer, which loops or
+	// not as it was opened.
+	bool playStream(VoiceId id, const StreamHandle &stream, float volume, float pan);
+	void stop(VoiceId id);
+	void stopAll();
+	void setVolume(VoiceId id, float volume);
+	void setPan(VoiceId id, float pan);
+	bool playing(VoiceId id) const { return find(id) >= 0; }
+
+	// Overwrites out with frames stereo frames, left then right. Voices
+	// reaching the end of a sound played once are freed.
+	void mix(float *out, int frames);
+
+	// Reads ahead in the streams playing. Returns the frames added.
+	int prefetch();
+
+	int sampleRate() const { return mSampleRate; }
+	int voiceCount() const { return mVoiceCount; }
+	unsigned long droppedCount() const { return mDropped; }
+	unsigned long underrunCount() const { return mUnderruns; }
+
+private:
+	struct Voice
+	{
+		VoiceId id;
+		SoundHandle sound;
+		StreamHandle stream;				// Instead of the sound
+		uint64_t position;					// Frames of the sound, 32.32 fixed point
+		uint64_t step;						// Per mixed frame
+		float volume;
+		float pan;
+		float gainLeft;
+		float gainRight;
+		bool loop;
+	};
+
+	int find(VoiceId id) const;
+	void updateGains(Voice &voice);
+	void remove(int i);
+
+	// Adds the voice to out, returns false when it ended.
+	bool mixVoice(Voice &voice, float *out, int frames);
+	bool mixStream(Voice &voice, float *out, int frames);
+
+	AudioMixer(const AudioMixer&);
+	AudioMixer& operator=(const AudioMixer&);
+
+private:
+	int mSampleRate;
+	Voice mVoices[MAX_VOICES];				// Packed at [0, mVoiceCount)
+	int mVoiceCount;
+	unsigned long mDropped;					// Plays refused, no voice free
+	unsigned long mUnderruns;				// Blocks a stream could not fill
+};
+
+#endif // AUDIOMIXER_H
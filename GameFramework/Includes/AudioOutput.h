@@ -0,0 +1,131 @@
+// AudioOutput.h
+// Where the mixed sound goes. The audio thread writes 16 bit frames, the
+// channels of a frame next to each other, as fast as the output takes
+// them, and waits for room when it is full: the output sets the pace.
+//
+// The game plays through the sound card (waveOut on Windows). The null
+// and WAV file outputs are for the headless driver, the benchmarks and
+// machines without a sound card: they take the frames at the rate a
+// device playing them would, or all at once when not real time.
+#ifndef AUDIOOUTPUT_H
+#define AUDIOOUTPUT_H
+#include "Platform.h"
+#ifdef _WIN32
+#include <MMSystem.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+class AudioOutput
+{
+public:
+	virtual ~AudioOutput() { }
+
+	virtual bool open(int sampleRate, int channels) = 0;
+	virtual void close() = 0;
+
+	// Takes up to count frames, returns how many it took: 0 when it is
+	// full.
+	virtual int write(const int16_t *frames, int count) = 0;
+
+	// Waits up to ms milliseconds for room to write.
+	virtual void wait(int ms) = 0;
+
+	virtual const char* name() const = 0;
+};
+
+// Takes frames at the pace of a device playing them, a few blocks ahead,
+// or without limit.
+class PacedAudioOutput : public AudioOutput
+{
+public:
+	virtual void wait(int ms);
+
+protected:
+	explicit PacedAudioOutput(bool realtime);
+
+	void startClock(int sampleRate, int channels);
+
+	// Frames that may be written now, at most count.
+	int room(int count);
+	void consumed(int frames) { mWritten += frames; }
+	int sampleRate() const { return mSampleRate; }
+
+	int mChannels;
+
+private:
+	bool mRealtime;
+	int mSampleRate;
+	uint64_t mWritten;
+	std::chrono::steady_clock::time_point mStart;
+};
+
+// Drops the frames.
+class NullAudioOutput : public PacedAudioOutput
+{
+public:
+	explicit NullAudioOutput(bool realtime = true) : PacedAudioOutput(realtime) { }
+
+	virtual bool open(int sampleRate, int channels);
+	virtual void close() { }
+	virtual int write(const int16_t *frames, int count);
+	virtual const char* name() const { return "null"; }
+};
+
+// Writes the frames to a 16 bit PCM WAV file.
+class WavFileAudioOutput : public PacedAudioOutput
+{
+public:
+	explicit WavFileAudioOutput(const char *szFileName, bool realtime = false);
+	virtual ~WavFileAudioOutput();
+
+	virtual bool open(int sampleRate, int channels);
+	virtual void close();
+	virtual int write(const int16_t *frames, int count);
+	virtual const char* name() const { return "wav file"; }
+
+private:
+	std::string mFileName;
+	FILE *mpFile;
+	uint32_t mDataBytes;
+};
+
+#ifdef _WIN32
+// Plays the frames on the default sound card through waveOut, with a few
+// buffers queued ahead.
+class WaveOutAudioOutput : public AudioOutput
+{
+public:
+	enum { BUFFER_COUNT = 4 };
+
+	// Each buffer holds bufferFrames frames.
+	explicit WaveOutAudioOutput(int bufferFrames);
+	virtual ~WaveOutAudioOutput();
+
+	virtual bool open(int sampleRate, int channels);
+	virtual void close();
+	virtual int write(const int16_t *frames, int count);
+	virtual void wait(int ms);
+	virtual const char* name() const { return "waveOut"; }
+
+private:
+	HWAVEOUT mDevice;
+	HANDLE mEvent;							// Set when a buffer is done
+	WAVEHDR mHeaders[BUFFER_COUNT];
+	std::vector<int16_t> mBuffers[BUFFER_COUNT];
+	int mBufferFrames;
+	int mChannels;
+	int mNext;								// Buffer filled next, in queue order
+	int mFill;								// Frames in it so far
+};
+#endif
+
+// The output of the platform, not opened yet: the sound card on Windows,
+// a real time null output elsewhere. blockFrames is the size of the
+// blocks the mixer makes.
+AudioOutput* createAudioOutput(int blockFrames);
+
+#endif // AUDIOOUTPUT_H
@@ -0,0 +1,103 @@
+// AudioStream.h
+// A WAV file played as it is read rather than loaded whole, for music.
+// The file is mapped into memory and decoded a piece at a time into a
+// small ring of frames at the mixer rate, so the memory a stream holds
+// is the same for a jingle and an hour long track.
+//
+// open() reads the header and fills the ring on the calling thread. From
+// then on the stream belongs to the audio thread: prefetch() tops the
+// ring up outside the mix, read() takes frames from it inside the mix
+// and never touches the file. When the mix asks for frames the ring does
+// not have yet, read() gives what it has and counts an underrun.
+//
+// Like the cache, a stream keeps at most the front pair of channels and
+// converts to the mixer rate with a Resampler, carrying the filter over
+// from one piece to the next and across the loop point.
+#ifndef AUDIOSTREAM_H
+#define AUDIOSTREAM_H
+#include "MappedFile.h"
+#include "Resampler.h"
+#include "WavFile.h"
+#include <memory>
+#include <vector>
+
+class AudioStream
+{
+public:
+	enum
+	{
+		RING_FRAMES = 16384,				// About 370 ms at 44.1 kHz
+		CHUNK_FRAMES = 4096					// Input frames decoded at most per piece
+	};
+
+	explicit AudioStream(int sampleRate);
+	~AudioStream();
+
+	// Opens the file and fills the ring. False if it cannot be mapped or
+	// is not a WAV file the reader knows.
+	bool open(const char *szFileName, bool loop);
+	void close();
+
+	// Decodes pieces of the file while the ring has room for them.
+	// Returns the frames added.
+	int prefetch();
+
+	// Copies up to frames frames, channels() floats each, to out. Returns
+	// how many. Fewer than asked before the end is an underrun.
+	int read(float *out, int frames);
+
+	// Played to the end, nothing more to read.
+	bool finished() const { return mEnded && mRingCount == 0; }
+
+	int channels() const { return mChannels; }
+	int sampleRate() const { return mSampleRate; }
+	int fileRate() const { return mFormat.sampleRate; }
+	int buffered() const { return mRingCount; }
+	unsigned long underruns() const { return mUnderruns; }
+	unsigned long framesRead() const { return mFramesRead; }
+
+	// Heap the stream holds, the mapped file aside.
+	size_t residentBytes() const;
+
+private:
+	// Decodes and converts one piece. Returns the frames added.
+	int decodePiece();
+	void push(const float *frames, int count);
+
+	AudioStream(const AudioStream&);
+	AudioStream& operator=(const AudioStream&);
+
+private:
+	MappedFile mFile;
+	WavFormat mFormat;
+	const uint8_t *mData;					// The data chunk in the mapping
+	size_t mDataSize;
+	size_t mNextByte;						// Where the next piece starts
+	size_t mTotalFrames;					// In the file, without the padding of ADPCM
+	size_t mFramesLeft;
+	size_t mPieceBytes;						// Whole blocks
+	int mPieceOutput;						// Most frames a piece adds to the ring
+	int mChannels;							// Kept, 1 or 2
+	bool mLoop;
+	bool mEnded;							// The last frames are in the ring
+
+	// Decoding and conversion
+	int mSampleRate;
+	Resampler mResampler;
+	ResamplePosition mPosition;
+	std::vector<float> mDecoded;			// A piece as read, every channel
+	std::vector<float> mPadded[2];			// Per channel input the filter reads
+	std::vector<float> mConverted;			// A piece at the mixer rate
+
+	// Frames at the mixer rate, [mRingRead, mRingRead + mRingCount)
+	std::vector<float> mRing;
+	int mRingRead;
+	int mRingCount;
+
+	unsigned long mUnderruns;
+	unsigned long mFramesRead;
+};
+
+typedef std::shared_ptr<AudioStream> StreamHandle;
+
+#endif // AUDIOSTREAM_H
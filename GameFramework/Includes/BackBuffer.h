@@ -3,19 +3,62 @@
 // August 24, 2004.
 #ifndef BACKBUFFER_H
 #define BACKBUFFER_H
-#include "main.h"
+#include "Platform.h"
+#include "Surface.h"
+#include "PresentTarget.h"
+#include "DirtyRegion.h"
 
 class BackBuffer
 {
 public:
+#ifdef _WIN32
+	// Renders into a DIB section and presents to the window.
 	BackBuffer(HWND hWnd, int width, int height);
+#endif
+	// Renders into system memory and presents to pTarget, which the
+	// back buffer takes ownership of.
+	BackBuffer(int width, int height, PresentTarget *pTarget);
 	~BackBuffer();
 
+	// Only the region that changed since the last frame is cleared by
+	// reset() and shown by present(): what was drawn in the last frame,
+	// what is drawn in this one and what was invalidated.
 	void present();
 	void reset();
 
-	HDC getDC() const { return mhDC; }
-	HWND getHWND() const { return mhWnd; }
+	// Repaints the whole frame / an area of it on the next reset(), for
+	// when something else than the sprites changed (the window was
+	// uncovered, the background scrolled).
+	void invalidate();
+	void invalidate(int x, int y, int w, int h);
+
+	// Sprites report the area they draw to.
+	void markDrawn(int x, int y, int w, int h) { mDrawn.add(x, y, w, h); }
+
+	// The area reset() cleared, which has to be drawn again.
+	const DirtyRegion& damage() const { return mDamage; }
+
+	// Pixels touched by reset() and present().
+	struct Stats
+	{
+		unsigned long frames;
+		unsigned long fullFrames;			// Frames that fell back to the whole frame
+		long clearedPixels;					// In the last frame
+		long presentedPixels;
+		unsigned long long totalCleared;	// Since the back buffer was created
+		unsigned long long totalPresented;
+	};
+	const Stats& stats() const { return mStats; }
+
+	// The 32-bit frame everything is drawn into.
+	Surface& getSurface() { return mSurface; }
+	const Surface& getSurface() const { return mSurface; }
+	PresentTarget* getTarget() const { return mpTarget; }
+
+#ifdef _WIN32
+	HDC getDC() const { return mpGdiTarget ? mpGdiTarget->getDC() : 0; }
+	HWND getHWND() const { return mpGdiTarget ? mpGdiTarget->getHWND() : 0; }
+#endif
 
 	int width() const { return mWidth; }
 	int height() const { return mHeight; }
@@ -31,12 +74,19 @@ private:
 	BackBuffer(const BackBuffer& rhs);
 	BackBuffer& operator=(const BackBuffer& rhs);
 
+	void init(int width, int height, PresentTarget *pTarget);
+
 private:
-	HWND mhWnd;
-	HDC mhDC;
-	HBITMAP mhSurface;
-	HBITMAP mhOldObject;
+	Surface mSurface;
+	PresentTarget *mpTarget;
+#ifdef _WIN32
+	GdiPresentTarget *mpGdiTarget;
+#endif
 	int mWidth;
 	int mHeight;
+
+	DirtyRegion mDamage;	// To repair and present in this frame
+	DirtyRegion mDrawn;		// Drawn in this frame, to repair in the next
+	Stats mStats;
 };
-#endif // BACKBUFFER_H
\ No newline at end of file
+#endif // BACKBUFFER_H
@@ -0,0 +1,44 @@
+// Background.h
+// Horizontally scrolling backdrop. The image is decoded once into a
+// surface in the back buffer format, drawing copies only the window that
+// is visible, wrapping around the right edge of the image.
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+#include "Surface.h"
+
+class ScrollingBackground
+{
+public:
+	ScrollingBackground();
+
+	bool load(const char *szFileName);
+
+	// Scroll speed, in pixels per second to the left.
+	void setSpeed(float pixelsPerSecond) { mSpeed = pixelsPerSecond; }
+	float speed() const { return mSpeed; }
+
+	// Advances the scroll position by dt seconds.
+	void update(float dt);
+
+	// Fills the target from its top left corner. Rows below the image are
+	// left untouched.
+	void draw(Surface &target) const;
+
+	// Same, limited to the w x h area at (x, y) of the target.
+	void draw(Surface &target, int x, int y, int w, int h) const;
+
+	// Horizontal offset of the image, in [0, width).
+	float offset() const { return mOffset; }
+	const Surface& image() const { return mImage; }
+
+private:
+	ScrollingBackground(const ScrollingBackground& rhs);
+	ScrollingBackground& operator=(const ScrollingBackground& rhs);
+
+private:
+	Surface mImage;
+	float mSpeed;
+	float mOffset;
+};
+
+#endif // BACKGROUND_H
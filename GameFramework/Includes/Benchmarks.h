@@ -0,0 +1,26 @@
+//-----------------------------------------------------------------------------
+// File: Benchmarks.h
+//
+// Desc: Micro benchmarks for the hot paths of the game, run from the
+//	headless driver with "-bench name". Each benchmark checks that the
+//	optimized paths give the same results as the reference before timing.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _BENCHMARKS_H_
+#define _BENCHMARKS_H_
+
+//-----------------------------------------------------------------------------
+// Name : RunBenchmark ()
+// Desc : Runs the named benchmark ("all" runs every one). Returns false if
+//		the name is unknown or the results did not match.
+//-----------------------------------------------------------------------------
+bool RunBenchmark( const char* szName, unsigned long ulIterations );
+
+//-----------------------------------------------------------------------------
+// Name : ListBenchmarks ()
+// Desc : Prints the names of the available benchmarks.
+//-----------------------------------------------------------------------------
+void ListBenchmarks( );
+
+#endif // _BENCHMARKS_H_
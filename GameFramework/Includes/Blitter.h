@@ -0,0 +1,79 @@
+// Blitter.h
+// Sprite compositing kernels for 32-bit surfaces. The masked blit does
+// what SRCAND with the mask followed by SRCPAINT with the image used to
+// do, in a single pass over the destination:
+//
+//		dst = (dst & mask) | image
+//
+// Rows are processed by a scalar, an SSE2 or an AVX2 kernel. The best
+// one the CPU supports is picked on first use, setBlitKernel() forces one
+// (the benchmark uses it to compare them).
+//
+// Color keyed images are drawn from a SpanList built once at load time:
+// the runs of opaque pixels of every row, copied with memcpy, so the
+// transparent pixels are never read.
+#ifndef BLITTER_H
+#define BLITTER_H
+#include "Surface.h"
+#include <vector>
+
+enum BlitKernel
+{
+	BLIT_SCALAR,
+	BLIT_SSE2,
+	BLIT_AVX2,
+	BLIT_KERNEL_COUNT
+};
+
+// Composites the w x h block at (srcX, srcY) of image through mask into
+// dst with its upper-left corner at (x, y), clipped to dst.
+void blitMasked(Surface &dst, int x, int y,
+				const Surface &image, const Surface &mask,
+				int srcX, int srcY, int w, int h);
+
+// Clips the block against dst and the source size. Returns false if
+// nothing is left to draw.
+bool clipBlit(const Surface &dst, int srcWidth, int srcHeight,
+			  int &x, int &y, int &srcX, int &srcY, int &w, int &h);
+
+// Opaque runs of a color keyed image.
+class SpanList
+{
+public:
+	struct Span
+	{
+		int start;		// First opaque pixel of the run
+		int length;		// Number of opaque pixels
+	};
+
+	SpanList() : mHeight(0) { }
+
+	// Collects the runs of pixels of image that are not the key color.
+	void build(const Surface &image, uint32_t key);
+	void clear();
+
+	bool empty() const { return mHeight == 0; }
+	int height() const { return mHeight; }
+	size_t spanCount() const { return mSpans.size(); }
+
+	const Span* rowBegin(int y) const { return mSpans.data() + mRowStart[y]; }
+	const Span* rowEnd(int y) const { return mSpans.data() + mRowStart[y + 1]; }
+
+private:
+	std::vector<Span> mSpans;
+	std::vector<int> mRowStart;		// Index of the first span of each row, plus an end marker
+	int mHeight;
+};
+
+// Copies the opaque pixels of the w x h block at (srcX, srcY) of image
+// into dst with its upper-left corner at (x, y), clipped to dst.
+void blitSpans(Surface &dst, int x, int y,
+			   const Surface &image, const SpanList &spans,
+			   int srcX, int srcY, int w, int h);
+
+bool isBlitKernelSupported(BlitKernel kernel);
+void setBlitKernel(BlitKernel kernel);
+BlitKernel getBlitKernel();
+const char* getBlitKernelName(BlitKernel kernel);
+
+#endif // BLITTER_H
@@ -0,0 +1,67 @@
+// BmpFile.h
+// Reads uncompressed Windows bitmaps without GDI. The file is mapped into
+// memory and its rows are converted straight from the mapping into the
+// 32-bit pixels the caller keeps, 0xAARRGGBB in memory order B, G, R, A,
+// with no copy of the file or of the image in between.
+//
+// 1, 4 and 8 bpp images go through their palette, 24 bpp rows are spread
+// to four bytes a pixel by a shuffle kernel and 32 bpp rows are copied.
+// Rows may be stored bottom-up or top-down and are padded to four bytes,
+// decode() gives them in the order the caller asks for. The best kernel
+// the CPU supports is picked on first use, setBmpKernel() forces one.
+#ifndef BMPFILE_H
+#define BMPFILE_H
+#include "MappedFile.h"
+#include <stddef.h>
+#include <stdint.h>
+
+enum BmpKernel
+{
+	BMP_SCALAR,
+	BMP_SSSE3,
+	BMP_KERNEL_COUNT
+};
+
+class BmpFile
+{
+public:
+	BmpFile();
+
+	// Maps the file and reads its headers. False when it cannot be mapped
+	// or is not an uncompressed 1, 4, 8, 24 or 32 bpp bitmap.
+	bool open(const char *szFileName);
+	void close();
+
+	bool isOpen() const { return mPixels != 0; }
+	int width() const { return mWidth; }
+	int height() const { return mHeight; }
+	int bitsPerPixel() const { return mBitsPerPixel; }
+	bool topDown() const { return mTopDown; }
+
+	// Writes every pixel to pixels, rows pitch pixels apart, with alpha in
+	// the top byte. The first row written is the top of the image when
+	// topDown is set, the bottom one otherwise.
+	void decode(uint32_t *pixels, int pitch, bool topDown, uint8_t alpha) const;
+
+private:
+	BmpFile(const BmpFile&);
+	BmpFile& operator=(const BmpFile&);
+
+private:
+	MappedFile mFile;
+	const uint8_t *mPixels;					// First row stored in the file
+	const uint8_t *mPalette;				// B, G, R, unused per entry
+	int mPaletteSize;
+	size_t mStride;							// Bytes per stored row, padding included
+	int mWidth;
+	int mHeight;
+	int mBitsPerPixel;
+	bool mTopDown;							// Stored top row first
+};
+
+bool isBmpKernelSupported(BmpKernel kernel);
+void setBmpKernel(BmpKernel kernel);
+BmpKernel getBmpKernel();
+const char* getBmpKernelName(BmpKernel kernel);
+
+#endif // BMPFILE_H
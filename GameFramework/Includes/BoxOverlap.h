@@ -0,0 +1,73 @@
+// BoxOverlap.h
+// Batch overlap tests of axis aligned boxes. The boxes are given as four
+// packed arrays of edges, so one box is tested against 4 (SSE2) or 8 (AVX)
+// others per instruction, the results come back as a bit mask or a list
+// of indices.
+//
+// Edges are inclusive: boxes that only touch overlap, like boxesOverlap()
+// says, which every kernel matches exactly. The best kernel the CPU
+// supports is picked on first use, setOverlapKernel() forces one.
+#ifndef BOXOVERLAP_H
+#define BOXOVERLAP_H
+#include <stdint.h>
+#include <vector>
+
+enum OverlapKernel
+{
+	OVERLAP_SCALAR,
+	OVERLAP_SSE2,
+	OVERLAP_AVX,
+	OVERLAP_KERNEL_COUNT
+};
+
+// count boxes, box i spans [left[i], right[i]] x [top[i], bottom[i]].
+struct BoxList
+{
+	const float *left;
+	const float *top;
+	const float *right;
+	const float *bottom;
+	int count;
+};
+
+struct OverlapPair
+{
+	int a;
+	int b;
+};
+
+// The reference test, every kernel gives the same answer.
+inline bool boxesOverlap(float left1, float top1, float right1, float bottom1,
+						 float left2, float top2, float right2, float bottom2)
+{
+	return !(right1 < left2 || right2 < left1 || bottom1 < top2 || bottom2 < top1);
+}
+
+// Moves box 1 by (dx, dy) past box 2, which stands still (give the
+// motion of one relative to the other when both move). That is the
+// segment the center of box 1 follows against box 2 grown by half of
+// box 1 on every side. True when they touch somewhere along the move,
+// enter and leave are then the fractions of the move [0, 1] where they
+// start and stop touching, enter is 0 when they overlap from the start.
+bool sweepBoxes(float left1, float top1, float right1, float bottom1, float dx, float dy,
+				float left2, float top2, float right2, float bottom2, float &enter, float &leave);
+
+// Tests the box against every box of the list. Bit i % 32 of hits[i / 32]
+// is set when box i overlaps, hits holds (count + 31) / 32 words. Returns
+// the number of overlaps.
+int overlapMask(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits);
+
+// Same, writing the indices of the overlapping boxes in increasing order
+// to indices, which holds count of them. Returns how many were written.
+int overlapIndices(float left, float top, float right, float bottom, const BoxList &boxes, int *indices);
+
+// Appends every overlapping pair of a box of a and a box of b, ordered by
+// a then b. Returns the number added.
+int overlapPairs(const BoxList &a, const BoxList &b, std::vector<OverlapPair> &pairs);
+
+bool isOverlapKernelSupported(OverlapKernel kernel);
+void setOverlapKernel(OverlapKernel kernel);
+OverlapKernel getOverlapKernel();
+const char* getOverlapKernelName(OverlapKernel kernel);
+
+#endif // BOXOVERLAP_H
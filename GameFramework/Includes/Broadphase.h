@@ -0,0 +1,124 @@
+// Broadphase.h
+// Uniform grid over the playfield for the collision checks. Every step the
+// boxes are added and the grid is rebuilt from scratch with a counting
+// sort, no allocation once the arrays have grown. The boxes are copied
+// into the grid grouped by cell, then by layer, so the boxes of one layer
+// in a cell are a packed run scanned in a straight line. A pair query only
+// looks at boxes sharing a cell, so its cost follows the number of
+// neighbours rather than the product of the two sets, and each run is
+// tested against a box by the batch overlap kernel.
+//
+// Each box carries an id given by the caller, usually an index in its own
+// storage, and a layer saying what kind of object it is. Queries
+// ask for the pairs between two layers: the boxes of the smaller layer are
+// walked and only the cells they cover are looked at, so a few ships
+// against thousands of shots costs a few cells.
+//
+// A bit matrix says which layers interact. queryInteracting() asks for
+// every pair of layers that do at once, layers that interact with nothing
+// are not even added, so pairs that can never matter never reach a test.
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+#include <stdint.h>
+#include <vector>
+
+struct BroadphasePair
+{
+	int a;			// Id of the box in the first layer of the query
+	int b;			// Id of the box in the second layer
+	int layerA;
+	int layerB;
+};
+
+// What the last build and the queries since did.
+struct BroadphaseStats
+{
+	int boxes;
+	int cells;
+	int occupiedCells;
+	int entries;					// Box references in the cells, a box spans one or more
+	int maxCellEntries;
+	int layerPairs;					// Pairs of layers queried
+	unsigned long pairsTested;		// Box tests made by the queries
+	unsigned long pairsFound;
+};
+
+class Broadphase
+{
+public:
+	enum { MAX_LAYERS = 32 };
+
+	// The grid covers [left, right] x [top, bottom], boxes outside of it are
+	// put in the edge cells. Layers go from 0 to layers - 1, at most
+	// MAX_LAYERS; each cell keeps a run per layer, so only ask for the ones
+	// in use.
+	Broadphase(float left, float top, float right, float bottom, float cellSize, int layers = MAX_LAYERS);
+
+	// Drops every box, the next ones go into a new build.
+	void clear();
+
+	// The interaction matrix, symmetric. Every layer interacts with every
+	// other one and with itself until told otherwise. Change it before
+	// adding the boxes of a build.
+	void setInteraction(int layerA, int layerB, bool interact);
+	void clearInteractions();
+	bool interacts(int layerA, int layerB) const { return (mInteractions[layerIndex(layerA)] >> layerIndex(layerB)) & 1; }
+
+	// Boxes of a layer that interacts with nothing are dropped.
+	void add(int id, int layer, float left, float top, float right, float bottom);
+	void addCentered(int id, int layer, float x, float y, float width, float height);
+
+	// Sorts the boxes added since clear() into the cells.
+	void build();
+
+	// Appends to pairs every overlapping pair of a box in layerA and a box
+	// in layerB, once. Touching edges overlap. Returns the number added,
+	// none when the layers do not interact.
+	int query(int layerA, int layerB, std::vector<BroadphasePair> &pairs);
+
+	// Same for every pair of layers that interact, layerA <= layerB, in
+	// increasing order of layerA then layerB.
+	int queryInteracting(std::vector<BroadphasePair> &pairs);
+
+	const BroadphaseStats& stats() const { return mStats; }
+	int columns() const { return mColumns; }
+	int rows() const { return mRows; }
+	float cellSize() const { return mCellSize; }
+
+private:
+	Broadphase(const Broadphase&);
+	Broadphase& operator=(const Broadphase&);
+
+	int layerIndex(int layer) const { return layer < 0 ? 0 : layer >= mLayers ? mLayers - 1 : layer; }
+	int column(float x) const;
+	int row(float y) const;
+
+private:
+	float mLeft, mTop;
+	float mCellSize, mInvCellSize;
+	int mColumns, mRows;
+	int mLayers;
+	uint32_t mInteractions[MAX_LAYERS];			// Bit b of layer a set when they interact
+
+	// The boxes, one array per field
+	std::vector<float> mBoxLeft, mBoxTop, mBoxRight, mBoxBottom;
+	std::vector<int> mBoxId;
+	std::vector<unsigned char> mBoxLayer;
+	std::vector<unsigned short> mBoxCells[4];	// First column, first row, last column, last row
+
+	// Layer l of cell c is the run [mRunStart[c * mLayers + l], mRunStart[c * mLayers + l + 1])
+	// of the entries, a copy of the box and its index
+	std::vector<int> mRunStart;
+	std::vector<float> mEntryLeft, mEntryTop, mEntryRight, mEntryBottom;
+	std::vector<int> mEntryBox;
+
+	// Layer l holds mLayerBoxes[mLayerStart[l], mLayerStart[l + 1])
+	int mLayerStart[MAX_LAYERS + 1];
+	std::vector<int> mLayerBoxes;
+
+	std::vector<int> mCursor;
+	std::vector<int> mHits;						// Overlapping entries of a run, as long as the longest
+	BroadphaseStats mStats;
+};
+
+#endif // BROADPHASE_H
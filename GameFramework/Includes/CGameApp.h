@@ -14,12 +14,10 @@
 //-----------------------------------------------------------------------------
 #include "Main.h"
 #include "CTimer.h"
-#include "CPlayer.h"
+#include "CGameWorld.h"
+#include "CGameRenderer.h"
+#include "CGameAudio.h"
 #include "BackBuffer.h"
-#include "ImageFile.h"
-#include "../Bullet.h"
-#include "../Enemy.h"
-#include <list>
 #include <string>
 #include <vector>
 #include <stdio.h>
@@ -58,10 +56,6 @@ public:
 	USHORT					Width;
 	USHORT					Height;
 	BackBuffer*				m_pBBuffer;
-	std::list<Bullet>	    bullets;
-	std::list<Bullet>		bullets2;
-	std::list<Bullet>		bullets3;
-	std::list<Enemy>		enemies;
 	HWND					m_hWnd;			 // Main window HWND
 	
 private:
@@ -76,12 +70,10 @@ private:
 	void		AnimateObjects	( );
 	void		DrawObjects	   ( );
 	void		ProcessInput	  ( );
+	void		ProcessEvents	 ( );
 	void        Save_game();
 	void        Load_game();
 
-
-	int CGameApp::Sprite_Collide(Sprite * object1, Sprite * object2);
-	void DrawBackground();
 	
 	//-------------------------------------------------------------------------
 	// Private Static Functions For This Class
@@ -93,6 +85,8 @@ private:
 	//-------------------------------------------------------------------------
 	CTimer				  m_Timer;			// Game timer
 	ULONG				   m_LastFrameRate;	// Used for making sure we update only when fps changes.
+	ULONG					m_LastFrameP99;		// Title shows it, in tenths of ms
+	float					m_fFrameRateLimit;	// Frames per second drawn at most, the display refresh rate
 	
 	HICON				   m_hIcon;			// Window Icon
 	HMENU				   m_hMenu;			// Window Menu
@@ -107,12 +101,13 @@ private:
 	POINT				   m_OldCursorPos;	 // Old cursor position for tracking
 	HINSTANCE				m_hInstance;
 
-	CImageFile				m_imgBackground;
-	CImageFile				m_imgBackground1;
 
 
-	CPlayer*				m_pPlayer;
-	CPlayer*				m_pPlayer2;
+	CGameWorld				m_World;			// Game rules and state
+	SWorldInput				m_Input;			// Input gathered for the next step
+	float					m_fStepTime;		// Frame time not simulated yet, less than a step
+	CGameRenderer			m_Renderer;			// Draws m_World
+	CGameAudio				m_Audio;			// Plays the sounds of m_World
 };
 
 #endif // _CGAMEAPP_H_
\ No newline at end of file
@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// File: CGameAudio.h
+//
+// Desc: Plays the sounds of the events a CGameWorld raises. The sounds are
+//	   decoded once into a cache and mixed by an AudioEngine on its own
+//	   thread, so any number of them overlap and the game never waits on
+//	   the sound card. Music is streamed from its file rather than
+//	   loaded. It has no dependency on Win32 so the headless driver can
+//	   write the sound of a run to a file with it.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _CGAMEAUDIO_H_
+#define _CGAMEAUDIO_H_
+
+//-----------------------------------------------------------------------------
+// CGameAudio Specific Includes
+//-----------------------------------------------------------------------------
+#include "CGameWorld.h"
+#include "SoundCache.h"
+#include "AudioEngine.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameAudio (Class)
+// Desc : Owns the sounds of the game and the engine mixing them.
+//-----------------------------------------------------------------------------
+class CGameAudio
+{
+public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+			 CGameAudio();
+	virtual ~CGameAudio();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+	bool		Load			( AudioOutput* pOutput, bool bThreaded = true );
+	void		Release			( );
+
+	bool		PlayMusic		( const char* szFileName, bool bLoop = true );
+	void		StopMusic		( );
+
+	void		PlayEvents		( const CGameWorld& World );
+	void		Render			( float dt );
+
+	const SoundCache&	Sounds	( ) const { return m_Sounds; }
+	const AudioEngine&	Engine	( ) const { return m_Engine; }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+	void		PlayJet			( const CGameWorld& World, int iPlayer, const SoundHandle& Sound );
+	static float PlayerPan		( const CGameWorld& World, int iPlayer );
+
+	//-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+	SoundCache				m_Sounds;			// Every sound, decoded and converted to the mixer rate once
+	SoundHandle				m_JetStart;
+	SoundHandle				m_JetStop;
+	SoundHandle				m_JetCabin;
+	SoundHandle				m_Explosion;
+
+	AudioEngine				m_Engine;
+	VoiceId					m_JetVoices[CGameWorld::PLAYER_COUNT];	// Engine sound of each ship, a new one cuts it
+	VoiceId					m_MusicVoice;
+	double					m_dRenderFrames;	// Frames Render() owes the output, less than one
+};
+
+#endif // _CGAMEAUDIO_H_
@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+// File: CGameRenderer.h
+//
+// Desc: Draws the state of a CGameWorld into a back buffer. It turns the
+//	   world objects into render commands, then submits them, so the
+//	   simulation never draws. It has no dependency on Win32 so the
+//	   headless driver can render with it too.
+//
+//	   The world moves in fixed steps, frames fall in between: objects are
+//	   drawn at fAlpha of the way from their position before the last step
+//	   to the current one.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _CGAMERENDERER_H_
+#define _CGAMERENDERER_H_
+
+//-----------------------------------------------------------------------------
+// CGameRenderer Specific Includes
+//-----------------------------------------------------------------------------
+#include "CGameWorld.h"
+#include "ImageCache.h"
+#include "RenderQueue.h"
+#include "TileRenderer.h"
+#include "Background.h"
+#include "BackBuffer.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameRenderer (Class)
+// Desc : Owns the images of the game and draws the world with them.
+//-----------------------------------------------------------------------------
+class CGameRenderer
+{
+public:
+	//-------------------------------------------------------------------------
+	// Constants
+	//-------------------------------------------------------------------------
+	// Draw order, bullets fly over the ships
+	enum ELayer
+	{
+		LAYER_PLAYERS,
+		LAYER_ENEMIES,
+		LAYER_BULLETS
+	};
+
+	// Headings baked for the ships, any angle shows the nearest one. The
+	// ships only ever face the four quarter turns, so only those are kept
+	enum { PLAYER_ROTATIONS = 4 };
+
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+			 CGameRenderer();
+	virtual ~CGameRenderer();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+	bool		Load			( );
+	void		Release			( );
+	void		ApplySpriteSizes( CGameWorld& World ) const;
+	void		SetRenderThreads( int iThreads ) { m_Tiles.setThreadCount(iThreads); }
+
+	void		Update			( float dt );
+	void		BuildCommands	( const CGameWorld& World, RenderQueue& Queue, float fAlpha = 1.0f );
+	void		Draw			( const CGameWorld& World, BackBuffer& BBuffer, float fAlpha = 1.0f );
+	void		Render			( const CGameWorld& World, BackBuffer& BBuffer, float fAlpha = 1.0f );
+
+	const ImageCache&	Images	( ) const { return m_Images; }
+	const RenderQueue&	Queue	( ) const { return m_Queue; }
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+	void		DrawBackground	( BackBuffer& BBuffer );
+
+	//-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+	ImageCache				m_Images;			// Every image, decoded once
+	RotationHandle			m_PlayerRotations;	// The ship at every heading
+	ImageHandle				m_ExplosionImage;
+	ImageHandle				m_EnemyImage;
+	ImageHandle				m_ProjectileImages[CGameWorld::PROJECTILE_IMAGE_COUNT];
+
+	ScrollingBackground		m_Background;
+	int						m_iBackgroundX;		// Scroll offset shown in the back buffer
+	RenderQueue				m_Queue;
+	TileRenderer			m_Tiles;			// Draws m_Queue with more than one thread
+};
+
+#endif // _CGAMERENDERER_H_
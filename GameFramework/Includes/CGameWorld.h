@@ -0,0 +1,194 @@
+//-----------------------------------------------------------------------------
+// File: CGameWorld.h
+//
+// Desc: Platform neutral game simulation. Holds the world state (players,
+//	enemies, bullets, lives) and advances it one step at a time from a
+//	set of inputs. It has no dependency on Win32 so it can be driven by the
+//	windowed front end (CGameApp) or by the headless driver.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _CGAMEWORLD_H_
+#define _CGAMEWORLD_H_
+
+//-----------------------------------------------------------------------------
+// CGameWorld Specific Includes
+//-----------------------------------------------------------------------------
+#include "Vec2.h"
+#include "CPlayer.h"
+#include "ProjectilePool.h"
+#include "SlotMap.h"
+#include "Broadphase.h"
+#include "CollisionMask.h"
+#include "../Enemy.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Structure Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : SPlayerInput (Struct)
+// Desc : Input for one player for one simulation step. The held direction
+//		is a combination of CPlayer::DIRECTION flags, the rest are one shot
+//		actions (key presses) that are consumed by the step.
+//-----------------------------------------------------------------------------
+struct SPlayerInput
+{
+	unsigned long	ulDirection;
+	bool			bFire;
+	bool			bRotateLeft;
+	bool			bRotateRight;
+	bool			bExplode;
+
+	SPlayerInput() : ulDirection(0), bFire(false), bRotateLeft(false), bRotateRight(false), bExplode(false) { }
+};
+
+//-----------------------------------------------------------------------------
+// Name : SWorldInput (Struct)
+// Desc : Input for all players for one simulation step.
+//-----------------------------------------------------------------------------
+struct SWorldInput
+{
+	SPlayerInput	Players[2];
+};
+
+//-----------------------------------------------------------------------------
+// Name : SGameEvent (Struct)
+// Desc : Something that happened during a step that the front end may want
+//		to present (sounds, explosions, end of match).
+//-----------------------------------------------------------------------------
+struct SGameEvent
+{
+	enum EType
+	{
+		EVENT_JET_START,
+		EVENT_JET_STOP,
+		EVENT_JET_CABIN,
+		EVENT_EXPLOSION,
+		EVENT_GAME_OVER
+	};
+
+	EType			eType;
+	int				iPlayer;		// Player the event refers to (winner for game over)
+};
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameWorld (Class)
+// Desc : The game rules. Owns every simulated object and steps them. Speeds
+//		and timers are in seconds, so any step length works, but the game
+//		runs it at STEP_TIME whatever the frame rate.
+//-----------------------------------------------------------------------------
+class CGameWorld
+{
+public:
+	//-------------------------------------------------------------------------
+	// Constants
+	//-------------------------------------------------------------------------
+	enum { PLAYER_COUNT = 2 };
+	enum { MAX_ENEMIES = 64 };									// Enemy storage, reserved up front
+	enum { PLAYFIELD_WIDTH = 1440, PLAYFIELD_HEIGHT = 900 };	// Shots leaving it are dropped
+
+	// Images of the projectiles, the renderer maps them to bitmaps
+	enum EProjectileImage
+	{
+		PROJECTILE_BULLET,
+		PROJECTILE_IMAGE_COUNT
+	};
+
+	// What an object is to the collision checks
+	enum ECollisionLayer
+	{
+		COLLISION_PLAYER1,
+		COLLISION_PLAYER2,
+		COLLISION_ENEMY,
+		COLLISION_PLAYER1_SHOT,					// Shot layers follow the projectile owners
+		COLLISION_PLAYER2_SHOT,
+		COLLISION_ENEMY_SHOT,
+		COLLISION_LAYER_COUNT
+	};
+
+	static const float		STEP_TIME;		// Seconds simulated by a step, 120 steps per second
+
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors for This Class.
+	//-------------------------------------------------------------------------
+			 CGameWorld();
+	virtual ~CGameWorld();
+
+	//-------------------------------------------------------------------------
+	// Public Functions for This Class
+	//-------------------------------------------------------------------------
+	void		Reset		( );
+	void		Step		( const SWorldInput& Input, float dt );
+	void		SetSpriteSizes( const Vec2& ShipSize, const Vec2& EnemySize, const Vec2& BulletSize );
+	void		SetCollisionMasks( const std::vector<CollisionMask>& ShipMasks, const CollisionMask& EnemyMask,
+								   const CollisionMask& BulletMask );
+
+	bool		Save		( const char* szFileName ) const;
+	bool		Load		( const char* szFileName );
+
+	CPlayer&	Player		( int iIndex ) { return m_Players[iIndex]; }
+	const CPlayer& Player	( int iIndex ) const { return m_Players[iIndex]; }
+	const std::vector<SGameEvent>& Events( ) const { return m_Events; }
+	bool		IsGameOver	( ) const { return m_bGameOver; }
+	int			Winner		( ) const { return m_iWinner; }
+	unsigned long StepCount	( ) const { return m_StepCount; }
+	const BroadphaseStats& CollisionStats( ) const { return m_Broadphase.stats(); }
+
+	const Vec2&	EnemySize	( ) const { return m_EnemySize; }
+	const Vec2&	BulletSize	( ) const { return m_BulletSize; }
+
+	ProjectilePool			projectiles;	// Every shot, of the players and the enemies
+	SlotMap<Enemy>			enemies;		// Packed, reached from outside through handles
+
+private:
+	//-------------------------------------------------------------------------
+	// Private Functions for This Class
+	//-------------------------------------------------------------------------
+	void		ProcessInput	( const SWorldInput& Input, float dt );
+	void		UpdatePlayers	( float dt );
+	void		UpdateEnemies	( float dt );
+	void		UpdateProjectiles( float dt );
+	void		BuildBroadphase	( );
+	void		ResolveCollisions( );
+	void		CullObjects		( );
+	void		SavePositions	( );
+	void		ExplodePlayer	( int iPlayer );
+	void		PushEvent		( SGameEvent::EType eType, int iPlayer );
+
+	const CollisionMask* ShipMask( int iPlayer ) const;
+
+	static int	Sprite_Collide	( const Vec2& Pos1, const Vec2& Size1, const Vec2& Pos2, const Vec2& Size2 );
+	static bool	Pixels_Collide	( const Vec2& Pos1, const CollisionMask* pMask1, const Vec2& Pos2, const CollisionMask* pMask2 );
+	static bool	Swept_Collide	( const Vec2& From1, const Vec2& To1, const Vec2& Size1, const CollisionMask* pMask1,
+								  const Vec2& From2, const Vec2& To2, const Vec2& Size2, const CollisionMask* pMask2,
+								  float& fTime );
+
+	//-------------------------------------------------------------------------
+	// Private Variables For This Class
+	//-------------------------------------------------------------------------
+	CPlayer					m_Players[PLAYER_COUNT];
+	Vec2					m_EnemySize;
+	Vec2					m_BulletSize;
+
+	// Opaque pixels of the images, the ship ones for headings all the way
+	// round. Empty masks leave the box tests alone.
+	std::vector<CollisionMask> m_ShipMasks;
+	CollisionMask			m_EnemyMask;
+	CollisionMask			m_BulletMask;
+
+	Broadphase				m_Broadphase;		// Every object of the step, rebuilt each step
+	std::vector<BroadphasePair> m_Pairs;		// Candidate pairs of the step, of every layer
+	std::vector<char>		m_ShotHit;			// Player hit by each shot this step plus one, 0 for none
+	std::vector<float>		m_ShotTime;			// Fraction of the step the hit happens at
+
+	std::vector<SGameEvent>	m_Events;			// Events raised by the last step
+	bool					m_bGameOver;
+	int						m_iWinner;
+	unsigned long			m_StepCount;
+};
+
+#endif // _CGAMEWORLD_H_
@@ -2,7 +2,8 @@
 // File: CPlayer.cpp
 //
 // Desc: This file stores the player object class. This class performs tasks
-//	   such as player movement, some minor physics as well as rendering.
+//	   such as player movement, some minor physics and sound state handling.
+//	   It is platform neutral, rendering is done by the front end.
 //
 // Original design by Adam Hoult & Gary Simmons. Modified by Mihai Popescu.
 //-----------------------------------------------------------------------------
@@ -13,9 +14,7 @@
 //-----------------------------------------------------------------------------
 // CPlayer Specific Includes
 //-----------------------------------------------------------------------------
-#include "Main.h"
-#include "Sprite.h"
-#include "../Bullet.h"
+#include "Vec2.h"
 
 //-----------------------------------------------------------------------------
 // Main Class Definitions
@@ -30,12 +29,12 @@ public:
 	//-------------------------------------------------------------------------
 	// Enumerators
 	//-------------------------------------------------------------------------
-	enum DIRECTION 
-	{ 
-		DIR_FORWARD	 = 1, 
-		DIR_BACKWARD	= 2, 
-		DIR_LEFT		= 4, 
-		DIR_RIGHT	   = 8, 
+	enum DIRECTION
+	{
+		DIR_FORWARD	 = 1,
+		DIR_BACKWARD	= 2,
+		DIR_LEFT		= 4,
+		DIR_RIGHT	   = 8,
 	};
 
 	enum ESpeedStates
@@ -44,45 +43,74 @@ public:
 		SPEED_STOP
 	};
 
+	enum ESoundCue
+	{
+		SOUND_NONE,
+		SOUND_JET_START,
+		SOUND_JET_STOP,
+		SOUND_JET_CABIN
+	};
+
+	//-------------------------------------------------------------------------
+	// Constants
+	//-------------------------------------------------------------------------
+	static const int		EXPLOSION_FRAMES = 16;		// Frames in explosion.bmp
+	static const float		EXPLOSION_FRAME_TIME;		// Seconds per explosion frame
+	static const float		ACCELERATION;				// Pixels per second per second a held key adds
+	static const float		FIRE_INTERVAL;				// Seconds between two shots
+
 	//-------------------------------------------------------------------------
 	// Constructors & Destructors for This Class.
 	//-------------------------------------------------------------------------
-			 CPlayer(const BackBuffer *pBackBuffer);
+			 CPlayer();
 	virtual ~CPlayer();
 
 	//-------------------------------------------------------------------------
 	// Public Functions for This Class.
 	//-------------------------------------------------------------------------
-	void					Update( float dt );
-	void					Draw();
-	void					Move(ULONG ulDirection);
+	ESoundCue				Update( float dt );
+	void					Move(unsigned long ulDirection, float dt);
 	Vec2&					Position();
 	Vec2&					Velocity();
+	const Vec2&				Position() const { return mPosition; }
+	const Vec2&				Velocity() const { return mVelocity; }
+	const Vec2&				PreviousPosition() const { return mPrevPosition; }
+	void					SavePosition() { mPrevPosition = mPosition; }
+	Vec2					Size() const;
+	const Vec2&				BaseSize() const { return mBaseSize; }
+	void					SetBaseSize(const Vec2& size) { mBaseSize = size; }
 
 	void					Explode();
 	bool					AdvanceExplosion();
-	void					Shoot();
-	void					Shoot2();
+	bool					IsExploding() const { return m_bExplosion; }
+	int						GetExplosionFrame() const { return m_iExplosionFrame; }
+	const Vec2&				ExplosionPosition() const { return mExplosionPosition; }
+	bool					Shoot();
 	void					RotateRight();
 	void					RotateLeft();
-	int fireCooldown = 10;
-	Sprite*					m_pSprite;
+	DIRECTION				Heading() const { return mNewDirection; }
+	double					HeadingAngle() const;
+	float fireCooldown = 0.1f;		// Seconds to the next shot
 	int lives;
 	void DecreaseLives();
-	
+
 
 private:
 	//-------------------------------------------------------------------------
 	// Private Variables for This Class.
 	//-------------------------------------------------------------------------
-	
+	Vec2					mPosition;
+	Vec2					mPrevPosition;		// Position before the current step
+	Vec2					mVelocity;
+	Vec2					mBaseSize;			// Size when facing forward
+
 	ESpeedStates			m_eSpeedState;
 	float					m_fTimer;
-	
+
 	bool					m_bExplosion;
-	AnimatedSprite*			m_pExplosionSprite;
 	int						m_iExplosionFrame;
-	const BackBuffer * mBackBuffer;
+	float					m_fExplosionTimer;
+	Vec2					mExplosionPosition;
 	DIRECTION mNewDirection;
 };
 
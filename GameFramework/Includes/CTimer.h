@@ -3,7 +3,8 @@
 //
 // Desc: This class handles all timing functionality. This includes counting
 //	the number of frames per second, to scaling vectors and values
-//	relative to the time that has passed since the previous frame.
+//	relative to the time that has passed since the previous frame. Frame
+//	times go into histograms (FrameProfiler) so the hitches show.
 //
 // Original design by Adam Hoult & Gary Simmons. Modified by Mihai Popescu.
 //-----------------------------------------------------------------------------
@@ -15,11 +16,8 @@
 // CTimer Specific Includes
 //-----------------------------------------------------------------------------
 #include "Main.h"
-
-//-----------------------------------------------------------------------------
-// Definitions, Macros & Constants
-//-----------------------------------------------------------------------------
-const ULONG MAX_SAMPLE_COUNT = 50; // Maximum frame time sample count
+#include "FramePacer.h"
+#include "FrameStats.h"
 
 //-----------------------------------------------------------------------------
 // Main Class Declarations
@@ -45,6 +43,11 @@ public:
 	void			Tick( float fLockFPS = 0.0f );
 	unsigned long	GetFrameRate( LPTSTR lpszString = NULL, size_t size = 0 ) const;
 	float			GetTimeElapsed() const;
+	float			GetFrameTime() const;
+
+	// Frame time percentiles, and the phases the front end times with it
+	FrameProfiler&			Profiler() { return m_Profiler; }
+	const FrameProfiler&	Profiler() const { return m_Profiler; }
 
 private:
 	//------------------------------------------------------------
@@ -52,17 +55,19 @@ private:
 	//------------------------------------------------------------
 	bool			m_PerfHardware;			 // Has Performance Counter
 	float			m_TimeScale;				// Amount to scale counter
-	float			m_TimeElapsed;			  // Time elapsed since previous frame
+	float			m_TimeElapsed;			  // Average time elapsed since previous frame
+	float			m_FrameTimeElapsed;		 // Time elapsed since previous frame, not averaged
 	__int64			m_CurrentTime;			  // Current Performance Counter
 	__int64			m_LastTime;				 // Performance Counter last frame
 	__int64			m_PerfFreq;				 // Performance Frequency
 
-	float			m_FrameTime[MAX_SAMPLE_COUNT];
-	ULONG			m_SampleCount;
+	FrameProfiler	m_Profiler;				 // Frame and phase time histograms
 
 	unsigned long	m_FrameRate;				// Stores current framerate
 	unsigned long	m_FPSFrameCount;			// Elapsed frames in any given second
 	float			m_FPSTimeElapsed;		// How much time has passed during FPS sample
+
+	FramePacer		m_Pacer;					// Waits out the frame when it is locked
 	
 	//------------------------------------------------------------
 	// Private Functions For This Class
@@ -0,0 +1,56 @@
+// CollisionMask.h
+// One bit per pixel of a sprite, set where it is opaque, packed 64 pixels
+// to a word with the leftmost pixel in the lowest bit. Two sprites whose
+// boxes overlap really touch when some row of one, shifted to line up
+// with the other, shares a bit with it: a few shifts and ANDs per row
+// instead of a test per pixel.
+//
+// The masks are made from the sprite images when they are loaded, and
+// from every frame of a rotation set, so the test follows the heading.
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class Surface;
+
+class CollisionMask
+{
+public:
+	CollisionMask() : mWidth(0), mHeight(0), mWordsPerRow(0) { }
+
+	// width x height pixels, all clear.
+	void create(int width, int height);
+	void clear();
+
+	// Opaque where the mask keeps nothing of what is under it (masked
+	// images are drawn as dst = (dst & mask) | image), or where the image
+	// is not the key color.
+	void buildFromMask(const Surface &mask);
+	void buildFromKey(const Surface &image, uint32_t key);
+
+	void set(int x, int y) { mBits[(size_t)y * mWordsPerRow + (x >> 6)] |= (uint64_t)1 << (x & 63); }
+	bool test(int x, int y) const { return (mBits[(size_t)y * mWordsPerRow + (x >> 6)] >> (x & 63)) & 1; }
+
+	bool empty() const { return mBits.empty(); }
+	int width() const { return mWidth; }
+	int height() const { return mHeight; }
+	int wordsPerRow() const { return mWordsPerRow; }
+	const uint64_t* row(int y) const { return mBits.data() + (size_t)y * mWordsPerRow; }
+	size_t bytes() const { return mBits.size() * sizeof(uint64_t); }
+
+	// Number of opaque pixels.
+	int count() const;
+
+	// True when a with its upper-left corner at (ax, ay) and b at (bx, by)
+	// have an opaque pixel in the same place.
+	static bool overlap(const CollisionMask &a, int ax, int ay, const CollisionMask &b, int bx, int by);
+
+private:
+	int mWidth, mHeight;
+	int mWordsPerRow;
+	std::vector<uint64_t> mBits;		// Bits past the width of a row are clear
+};
+
+#endif // COLLISIONMASK_H
@@ -0,0 +1,52 @@
+// DirtyRegion.h
+// The parts of a frame that changed, as a short list of rectangles.
+// Rectangles that overlap, or lie so close that one rectangle around both
+// costs no more pixels, are merged as they are added. When the list
+// covers more than a threshold of the frame it turns into the whole
+// frame, one big copy being cheaper than many small ones by then.
+#ifndef DIRTYREGION_H
+#define DIRTYREGION_H
+#include "Platform.h"
+#include <vector>
+
+class DirtyRegion
+{
+public:
+	// Past this many rectangles the closest ones are merged.
+	enum { MAX_RECTS = 32 };
+
+	DirtyRegion();
+
+	// Rectangles are clipped to 0, 0, width, height.
+	void setBounds(int width, int height);
+
+	// Fraction of the frame area past which the region is the whole frame.
+	void setFullThreshold(float fraction) { mFullThreshold = fraction; }
+
+	void add(int x, int y, int w, int h);
+	void add(const DirtyRegion &other);
+	void addAll();
+	void clear();
+
+	bool empty() const { return mRects.empty(); }
+	bool isFull() const { return mFull; }
+
+	int count() const { return (int)mRects.size(); }
+	const RECT& rect(int i) const { return mRects[i]; }
+
+	// Pixels covered, rectangles never overlap.
+	long area() const { return mArea; }
+
+private:
+	void insert(RECT rc);
+
+private:
+	std::vector<RECT> mRects;
+	int mWidth;
+	int mHeight;
+	long mArea;
+	float mFullThreshold;
+	bool mFull;
+};
+
+#endif // DIRTYREGION_H
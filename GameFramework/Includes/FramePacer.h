@@ -0,0 +1,47 @@
+// FramePacer.h
+// Waits for the next frame without keeping a core busy. Most of the wait
+// is slept away, only the last part of it, the margin, spins on the clock:
+// the scheduler wakes a sleeping thread up late, by an amount that depends
+// on the OS and on the load. Every sleep measures how late it woke up and
+// the margin follows, growing at once after a late wake-up and shrinking
+// slowly while the sleeps are on time.
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	// Seconds on a monotonic clock.
+	static double now();
+
+	// Returns at the deadline (a now() time), at once if it has passed.
+	void waitUntil(double deadline);
+
+	// Sleeping only and spinning only, the benchmark compares them.
+	void sleepUntil(double deadline);
+	static void spinUntil(double deadline);
+
+	double margin() const { return mMargin; }
+	double maxOvershoot() const { return mMaxOvershoot; }
+	unsigned long sleepCount() const { return mSleeps; }
+
+private:
+	void sleepFor(double seconds);
+	void adaptMargin(double overshoot);
+
+	FramePacer(const FramePacer& rhs);
+	FramePacer& operator=(const FramePacer& rhs);
+
+private:
+	double mMargin;				// Seconds spun before a deadline
+	double mMaxOvershoot;		// Latest wake-up seen, in seconds
+	unsigned long mSleeps;
+#ifdef _WIN32
+	void *mTimer;				// High resolution waitable timer, 0 if the OS has none
+#endif
+};
+
+#endif // FRAMEPACER_H
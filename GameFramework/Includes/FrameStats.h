@@ -0,0 +1,102 @@
+// FrameStats.h
+// Frame time statistics. An average frame rate hides the hitches, so the
+// times go into histograms that answer percentiles instead: the buckets
+// are logarithmic like an HDR histogram, 16 per power of two from 1 us
+// up, so any time is kept within 6.25% in a few KB, whatever the count.
+//
+// FrameProfiler keeps one histogram per phase of the frame, for the
+// whole run and for a rolling window of the last few seconds.
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+#include <stdint.h>
+
+class FrameHistogram
+{
+public:
+	enum
+	{
+		SUB_BUCKETS = 16,									// Buckets per power of two
+		OCTAVES = 28,										// Up to 2^32 us, about 70 minutes
+		BUCKET_COUNT = SUB_BUCKETS + SUB_BUCKETS * OCTAVES
+	};
+
+	FrameHistogram();
+
+	void clear();
+	void add(double seconds);
+	void add(const FrameHistogram &rhs);
+
+	uint32_t count() const { return mCount; }
+	double mean() const { return mCount ? mSum / mCount : 0.0; }
+	double maximum() const { return mMax; }
+
+	// Time under which p percent of the samples fall, in seconds.
+	double percentile(double p) const;
+
+	uint32_t bucket(int i) const { return mCounts[i]; }
+	static double bucketLow(int i);
+	static double bucketHigh(int i);
+
+private:
+	static int bucketOf(double seconds);
+
+private:
+	uint32_t mCounts[BUCKET_COUNT];
+	uint32_t mCount;
+	double mSum;
+	double mMax;
+};
+
+class FrameProfiler
+{
+public:
+	enum Phase
+	{
+		PHASE_FRAME,				// The whole frame, start to start
+		PHASE_INPUT,
+		PHASE_SIMULATION,
+		PHASE_DRAW,
+		PHASE_PRESENT,
+		PHASE_COUNT
+	};
+
+	// The rolling window is made of slices of frame time, the oldest one
+	// is dropped as a new one starts.
+	enum { WINDOW_SLICES = 8 };
+	static const double SLICE_TIME;
+
+	FrameProfiler();
+
+	void clear();
+
+	// Times a phase of the current frame with the profiler clock.
+	void begin(Phase phase);
+	void end(Phase phase);
+
+	void record(Phase phase, double seconds);
+
+	// Closes the frame, it took frameSeconds from start to start.
+	void endFrame(double frameSeconds);
+
+	// The last WINDOW_SLICES * SLICE_TIME seconds, and the whole run.
+	const FrameHistogram& window(Phase phase) const;
+	const FrameHistogram& total(Phase phase) const { return mTotal[phase]; }
+
+	static const char* phaseName(Phase phase);
+
+	// One row per phase with the count, mean and percentiles in ms, for
+	// the window and for the whole run. Returns false if the file cannot
+	// be written.
+	bool writeCsv(const char *szFileName) const;
+
+private:
+	FrameHistogram mSlices[PHASE_COUNT][WINDOW_SLICES];
+	FrameHistogram mTotal[PHASE_COUNT];
+	mutable FrameHistogram mWindow[PHASE_COUNT];		// Sum of the slices, made on demand
+	mutable bool mWindowValid[PHASE_COUNT];
+	double mPhaseStart[PHASE_COUNT];
+	int mSlice;
+	double mSliceTime;									// Frame time in the current slice
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,109 @@
+// ImageCache.h
+// Decoded sprite images, loaded once per file and shared by every sprite
+// drawing them. Handles are reference counted and point to const data, a
+// cached image never changes after it is loaded, so any number of sprites
+// can hold the same one.
+//
+// Sprites that turn get a RotationSet: frames of one image baked at evenly
+// spaced angles when it is loaded, so drawing any heading is a lookup.
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+#include "Platform.h"
+#include "Surface.h"
+#include "Blitter.h"
+#include "CollisionMask.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The pixels of a sprite: an image with either a mask or a color key.
+struct SpriteImage
+{
+	SpriteImage() : id(0), transparentColor(0) { }
+
+	bool masked() const { return !mask.empty(); }
+
+	// Memory held by the pixels, the opaque runs and the collision mask.
+	size_t bytes() const;
+
+	unsigned int id;				// Creation order in the cache, 0 for images made elsewhere
+	Surface image;
+	Surface mask;					// Empty for color keyed images
+	uint32_t transparentColor;		// Color key, as a surface pixel
+	SpanList spans;					// Opaque runs of a color keyed image
+	CollisionMask collision;		// Opaque pixels, for the hit tests
+
+private:
+	SpriteImage(const SpriteImage& rhs);
+	SpriteImage& operator=(const SpriteImage& rhs);
+};
+
+typedef std::shared_ptr<const SpriteImage> ImageHandle;
+
+// Frames of an image turned by 0, 1, ... count - 1 steps of 2 PI / count,
+// counterclockwise on screen. Every frame is a masked image, sized to hold
+// the turned source, with its own collision mask.
+struct RotationSet
+{
+	// The frame closest to the angle, in radians.
+	const ImageHandle& frame(double radians) const;
+
+	size_t count() const { return frames.size(); }
+	size_t bytes() const;
+
+	std::vector<ImageHandle> frames;
+};
+
+typedef std::shared_ptr<const RotationSet> RotationHandle;
+
+// Turns source by radians (counterclockwise on screen) about its center
+// into frame, a masked image. Pixels are sampled, not filtered, so quarter
+// turns are exact.
+void bakeRotation(const SpriteImage &source, double radians, SpriteImage &frame);
+
+class ImageCache
+{
+public:
+	ImageCache();
+
+	// Returns the image of the files, decoding them on the first request
+	// only. A file that fails to load, or a mask that does not match the
+	// size of its image, gives a null handle and is tried again next time.
+	ImageHandle load(const char *szImageFile, const char *szMaskFile);
+	ImageHandle load(const char *szImageFile, COLORREF crTransparentColor);
+
+	// Returns count frames of the image turned all the way round, baked on
+	// the first request only. Null when the image cannot be loaded.
+	RotationHandle loadRotations(const char *szImageFile, const char *szMaskFile, int count);
+	RotationHandle loadRotations(const char *szImageFile, COLORREF crTransparentColor, int count);
+
+	// Drops the images no handle refers to anymore.
+	void purge();
+	void clear();
+
+	size_t size() const { return mImages.size() + mRotations.size(); }
+	unsigned long hits() const { return mHits; }
+	unsigned long misses() const { return mMisses; }
+	size_t residentBytes() const { return mResidentBytes; }
+
+private:
+	ImageHandle find(const std::string &key);
+	ImageHandle insert(const std::string &key, const std::shared_ptr<SpriteImage> &image);
+	RotationHandle findRotations(const std::string &key);
+	RotationHandle bakeRotations(const std::string &key, const SpriteImage &source, int count);
+
+	// The cache owns the images, handing out copies of these.
+	ImageCache(const ImageCache& rhs);
+	ImageCache& operator=(const ImageCache& rhs);
+
+private:
+	std::map<std::string, ImageHandle> mImages;
+	std::map<std::string, RotationHandle> mRotations;
+	unsigned long mHits;
+	unsigned long mMisses;
+	size_t mResidentBytes;
+	unsigned int mNextId;			// Id of the last image created
+};
+
+#endif // IMAGECACHE_H
@@ -3,6 +3,7 @@
 // by Mihai Popescu
 // March 2009
 #include "main.h"
+#include "Surface.h"
 
 
 typedef BYTE (*RGBQUAD_TO_BYTE)(const RGBQUAD &q);
@@ -38,6 +39,7 @@ public:
 
 	bool LoadBitmapFromFile(const char* szFileName, HDC hdc);
 	virtual void Paint(HDC hdc, int x, int y);
+	virtual void Paint(Surface &target, int x, int y);
 
 	LONG Height() const { return height; }
 	LONG Width() const { return width; }
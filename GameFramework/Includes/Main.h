@@ -21,6 +21,7 @@
 #include <tchar.h>
 #include <stdio.h>
 #include <math.h>
+#include "Vec2.h"
 
 
 //-----------------------------------------------------------------------------
@@ -30,11 +31,5 @@
 #define C1_TRANSPARENT	1
 
 
-#define EPS 1e-3 // epsilon (the smallest float value used)
-#define PI 3.14159265358979323846
-#define DEG2RAD(deg) (PI * (deg) / 180.0)
-#define RAD2DEG(rad) ((rad) * 180.0 / PI)
-
-
 
 #endif // _MAIN_H_
\ No newline at end of file
@@ -0,0 +1,49 @@
+// MappedFile.h
+// A file opened read only and mapped into memory. Its pages are read
+// from disk the first time they are touched and can be dropped again by
+// the OS, so a large file costs address space rather than heap: reading
+// it front to back keeps the memory of the process flat.
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Maps the whole file. False when it cannot be opened or is empty.
+	bool open(const char *szFileName);
+	void close();
+
+	bool isOpen() const { return mData != 0; }
+	const uint8_t* data() const { return mData; }
+	size_t size() const { return mSize; }
+
+	// Tells the OS the bytes will be read soon, so it starts reading them
+	// in. Only a hint, the bytes can be read without it.
+	void prefetch(size_t offset, size_t bytes) const;
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+private:
+	const uint8_t *mData;
+	size_t mSize;
+#ifdef _WIN32
+	void *mFile;							// HANDLEs
+	void *mMapping;
+#else
+	int mFile;
+#endif
+};
+
+// Key the caches keep what they load from szFileName under. Paths name
+// the same file whatever their case on Windows, so they get one key.
+std::string makeFileKey(const char *szFileName);
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+// File: Platform.h
+//
+// Desc: Lets the rendering code build without Win32. On Windows this is
+//	just Main.h, elsewhere it provides the few Win32 types and macros that
+//	the shared code uses.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+#ifdef _WIN32
+
+#include "Main.h"
+
+#else // !_WIN32
+
+//-----------------------------------------------------------------------------
+// Portable Includes
+//-----------------------------------------------------------------------------
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "Vec2.h"
+
+//-----------------------------------------------------------------------------
+// Win32 types used by the shared code
+//-----------------------------------------------------------------------------
+typedef unsigned char	BYTE;
+typedef unsigned long	ULONG;
+typedef unsigned long	COLORREF;
+
+typedef struct tagRECT
+{
+	long	left;
+	long	top;
+	long	right;
+	long	bottom;
+} RECT;
+
+typedef struct tagPOINT
+{
+	long	x;
+	long	y;
+} POINT;
+
+#define RGB(r,g,b) ((COLORREF)(((BYTE)(r)|((unsigned short)((BYTE)(g))<<8))|(((unsigned long)(BYTE)(b))<<16)))
+#define GetRValue(rgb) ((BYTE)(rgb))
+#define GetGValue(rgb) ((BYTE)(((unsigned short)(rgb)) >> 8))
+#define GetBValue(rgb) ((BYTE)((rgb)>>16))
+
+#endif // _WIN32
+
+#endif // _PLATFORM_H_
@@ -0,0 +1,86 @@
+// PresentTarget.h
+// Where BackBuffer::present() sends a finished frame.
+#ifndef PRESENTTARGET_H
+#define PRESENTTARGET_H
+#include "Surface.h"
+#include "DirtyRegion.h"
+
+class PresentTarget
+{
+public:
+	virtual ~PresentTarget() { }
+
+	// Gives the target a chance to provide the memory the frame is
+	// rendered into (a DIB section for instance). Returns false to let
+	// the back buffer allocate it in system memory.
+	virtual bool createSurface(Surface& /*surface*/, int /*width*/, int /*height*/) { return false; }
+
+	// Shows / stores the finished frame.
+	virtual void present(const Surface &surface) = 0;
+
+	// Shows the parts of the frame in region, the rest did not change
+	// since the last frame. Targets that cannot update part of a frame
+	// present all of it.
+	virtual void present(const Surface &surface, const DirtyRegion& /*region*/) { present(surface); }
+
+	unsigned long frameCount() const { return mFrameCount; }
+
+protected:
+	PresentTarget() : mFrameCount(0) { }
+
+	unsigned long mFrameCount;
+};
+
+// Drops every frame. Used to run the renderer with no display at all.
+class NullPresentTarget : public PresentTarget
+{
+public:
+	virtual void present(const Surface &surface);
+};
+
+// Appends every frame to a file as raw 32-bit rows (B, G, R, A bytes,
+// top-down, no padding). A path on a tmpfs (/dev/shm) or a named pipe
+// makes this a shared memory sink for another process.
+class FilePresentTarget : public PresentTarget
+{
+public:
+	FilePresentTarget(const char *szFileName);
+	virtual ~FilePresentTarget();
+
+	bool isOpen() const { return mpFile != 0; }
+	virtual void present(const Surface &surface);
+
+private:
+	FilePresentTarget(const FilePresentTarget& rhs);
+	FilePresentTarget& operator=(const FilePresentTarget& rhs);
+
+	FILE *mpFile;
+};
+
+#ifdef _WIN32
+// Renders into a 32 bpp DIB section and blits it to the window.
+class GdiPresentTarget : public PresentTarget
+{
+public:
+	GdiPresentTarget(HWND hWnd);
+	virtual ~GdiPresentTarget();
+
+	virtual bool createSurface(Surface &surface, int width, int height);
+	virtual void present(const Surface &surface);
+	virtual void present(const Surface &surface, const DirtyRegion &region);
+
+	HDC getDC() const { return mhDC; }
+	HWND getHWND() const { return mhWnd; }
+
+private:
+	GdiPresentTarget(const GdiPresentTarget& rhs);
+	GdiPresentTarget& operator=(const GdiPresentTarget& rhs);
+
+	HWND mhWnd;
+	HDC mhDC;
+	HBITMAP mhSurface;
+	HBITMAP mhOldObject;
+};
+#endif // _WIN32
+
+#endif // PRESENTTARGET_H
@@ -0,0 +1,79 @@
+// ProjectilePool.h
+// Every shot in flight, stored as a structure of arrays: one array per
+// field, all allocated once for a fixed capacity. Spawning appends at the
+// end and removing moves the last projectile into the hole, so both are
+// O(1), the live projectiles stay packed at [0, size()) and the update is
+// a few straight loops over floats the compiler vectorizes.
+//
+// Indices are not stable, a removal moves the last projectile: remove
+// while walking the pool by looking at the same index again.
+#ifndef PROJECTILEPOOL_H
+#define PROJECTILEPOOL_H
+#include "Vec2.h"
+#include <vector>
+
+class ProjectilePool
+{
+public:
+	enum { DEFAULT_CAPACITY = 4096 };
+
+	// Who fired, which decides what the projectile can hit.
+	enum Owner
+	{
+		OWNER_PLAYER1,
+		OWNER_PLAYER2,
+		OWNER_ENEMY,
+		OWNER_COUNT
+	};
+
+	explicit ProjectilePool(int capacity = DEFAULT_CAPACITY);
+
+	// Adds a projectile at (x, y) moving at (vx, vy) pixels per second for
+	// lifetime seconds. image is an index the renderer maps to an image.
+	// Returns its index, or -1 when the pool is full (the shot is dropped).
+	int spawn(float x, float y, float vx, float vy, float lifetime, Owner owner, unsigned short image);
+
+	// Removes projectile i, the last one takes its index.
+	void remove(int i);
+	void clear();
+
+	// Moves and ages every projectile by dt seconds.
+	void update(float dt);
+
+	// Removes the projectiles whose lifetime ran out or whose center left
+	// the rectangle. Returns how many went.
+	int cull(float left, float top, float right, float bottom);
+
+	// Keeps the current positions as the previous ones, the renderer draws
+	// in between.
+	void savePositions();
+
+	int size() const { return mSize; }
+	int capacity() const { return (int)mX.size(); }
+	bool empty() const { return mSize == 0; }
+	bool full() const { return mSize == capacity(); }
+	unsigned long droppedCount() const { return mDropped; }
+
+	Vec2 position(int i) const { return Vec2((double)mX[i], (double)mY[i]); }
+	Vec2 previousPosition(int i) const { return Vec2((double)mPrevX[i], (double)mPrevY[i]); }
+	Vec2 velocity(int i) const { return Vec2((double)mVX[i], (double)mVY[i]); }
+	float lifetime(int i) const { return mLifetime[i]; }
+	Owner owner(int i) const { return (Owner)mOwner[i]; }
+	unsigned short image(int i) const { return mImage[i]; }
+
+	// The packed fields, size() long, for batch processing.
+	const float* xs() const { return mX.data(); }
+	const float* ys() const { return mY.data(); }
+
+private:
+	std::vector<float> mX, mY;
+	std::vector<float> mPrevX, mPrevY;
+	std::vector<float> mVX, mVY;
+	std::vector<float> mLifetime;			// Seconds left
+	std::vector<unsigned char> mOwner;
+	std::vector<unsigned short> mImage;
+	int mSize;
+	unsigned long mDropped;					// Spawns refused because the pool was full
+};
+
+#endif // PROJECTILEPOOL_H
@@ -0,0 +1,71 @@
+// RenderQueue.h
+// Retained list of the sprites to draw in a frame. The game fills it with
+// one command per object (image, frame, position, layer), then submit()
+// drops what is off screen, sorts the rest by layer and image and draws
+// them in batches of the same image.
+//
+// Layers are drawn in increasing order. Within a layer commands of the
+// same image keep the order they were added in, commands of different
+// images are drawn image by image: objects that must cover others go in
+// a higher layer.
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+#include "Vec2.h"
+#include "BackBuffer.h"
+#include "ImageCache.h"
+#include <vector>
+
+struct RenderCommand
+{
+	const SpriteImage *image;	// Kept alive by whoever queued it until submit()
+	int layer;
+	int x, y;					// Upper-left corner in the back buffer
+	int srcX, srcY;				// Frame of the image to draw
+	int w, h;
+	unsigned int order;			// Position in the queue, keeps the sort stable
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Queues the whole image centered on position.
+	void add(const ImageHandle &image, const Vec2 &position, int layer);
+
+	// Queues the w x h frame at (srcX, srcY) of the image centered on
+	// position.
+	void add(const ImageHandle &image, const Vec2 &position, int layer,
+			 int srcX, int srcY, int w, int h);
+
+	// Sorts the commands and draws them into the back buffer, then
+	// empties the queue.
+	void submit(BackBuffer &backBuffer);
+
+	// Puts the commands in submit order, dropping those outside a
+	// width x height frame. Used by submit(), and by renderers that draw
+	// the commands themselves.
+	void sort(int width, int height);
+
+	void clear();
+
+	size_t size() const { return mCommands.size(); }
+	const RenderCommand& command(size_t i) const { return mCommands[i]; }
+
+	// Counts of the last sort() / submit().
+	size_t drawnCount() const { return mDrawn; }
+	size_t culledCount() const { return mCulled; }
+	size_t batchCount() const { return mBatches; }
+
+private:
+	RenderQueue(const RenderQueue& rhs);
+	RenderQueue& operator=(const RenderQueue& rhs);
+
+private:
+	std::vector<RenderCommand> mCommands;
+	size_t mDrawn;
+	size_t mCulled;
+	size_t mBatches;
+};
+
+#endif // RENDERQUEUE_H
@@ -0,0 +1,85 @@
+// Resampler.h
+// Converts sounds from one sample rate to another with a polyphase
+// windowed sinc filter. Every output frame sits at a fraction of the way
+// between two input frames; the filter for that fraction is blended from
+// the two nearest of PHASES precomputed ones and applied to the TAPS
+// input frames around it. Going down in rate, the filter also cuts what
+// the new rate cannot hold instead of folding it back as noise.
+//
+// It is meant to run once per sound, when the sound is loaded, so the
+// mixer then plays every sound at its own rate without converting; a
+// stream converts a piece at a time as it reads ahead instead. The
+// best kernel the CPU supports is picked on first use,
+// setResampleKernel() forces one.
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum ResampleKernel
+{
+	RESAMPLE_SCALAR,
+	RESAMPLE_SSE2,
+	RESAMPLE_KERNEL_COUNT
+};
+
+// Where the next output frame sits in the input: frame whole frames and
+// fraction / up of one past the start, up as given by the two rates.
+struct ResamplePosition
+{
+	ResamplePosition() : frame(0), fraction(0) { }
+
+	uint64_t frame;
+	uint64_t fraction;
+};
+
+class Resampler
+{
+public:
+	enum
+	{
+		TAPS = 64,							// Input frames per output frame
+		HALF_TAPS = TAPS / 2,
+		PHASES = 256						// Filters between two input frames
+	};
+
+	Resampler(int inputRate, int outputRate);
+
+	int inputRate() const { return mInputRate; }
+	int outputRate() const { return mOutputRate; }
+
+	// Frames made from frames input frames.
+	size_t outputFrames(size_t frames) const;
+
+	// Converts frames frames of channels interleaved channels into out,
+	// which holds outputFrames(frames) of them. Past both ends the input
+	// is taken as silence.
+	void process(const float *in, size_t frames, int channels, float *out) const;
+
+	// Converting in pieces, one channel at a time. padded holds HALF_TAPS
+	// frames before the frame position counts from, then the input. Both
+	// give the output frames paddedFrames of it are enough for, run()
+	// makes count of them into out, every stride floats, and moves
+	// position past them. Drop frames from the front by taking them off
+	// position.frame too.
+	size_t available(const ResamplePosition &position, size_t paddedFrames) const;
+	void run(const float *padded, ResamplePosition &position, size_t count, float *out, int stride) const;
+
+	// Equal rates, the frames can be copied as they are.
+	bool passThrough() const { return mUp == mDown; }
+
+private:
+	int mInputRate;
+	int mOutputRate;
+	uint64_t mUp;							// The rates divided by their
+	uint64_t mDown;							// greatest common divisor
+	std::vector<float> mFilters;			// PHASES + 1 rows of TAPS
+};
+
+bool isResampleKernelSupported(ResampleKernel kernel);
+void setResampleKernel(ResampleKernel kernel);
+ResampleKernel getResampleKernel();
+const char* getResampleKernelName(ResampleKernel kernel);
+
+#endif // RESAMPLER_H
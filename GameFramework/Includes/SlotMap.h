@@ -0,0 +1,182 @@
+// SlotMap.h
+// Objects kept packed in one array for iteration, reached from outside
+// through handles that survive the packing. A handle names a slot and the
+// generation the slot had when the object went in; removing the object
+// bumps the generation, so an old handle to a reused slot is told apart
+// from the new object instead of silently reaching it. Generations are odd
+// while the slot holds an object and even while it is free, so no handle
+// reaches a free slot either.
+//
+// All the storage is reserved for a fixed capacity up front, adding an
+// object builds it in place and never allocates.
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+struct SlotHandle
+{
+	uint32_t index;
+	uint32_t generation;					// Odd for a live object, 0 the null handle
+
+	SlotHandle() : index(0), generation(0) { }
+	SlotHandle(uint32_t i, uint32_t g) : index(i), generation(g) { }
+
+	bool isNull() const { return generation == 0; }
+	bool operator==(const SlotHandle &rhs) const { return index == rhs.index && generation == rhs.generation; }
+	bool operator!=(const SlotHandle &rhs) const { return !(*this == rhs); }
+};
+
+template <typename T>
+class SlotMap
+{
+public:
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	explicit SlotMap(int capacity);
+
+	// Builds an object from args in place. Returns the null handle when
+	// the map is full.
+	template <typename... Args>
+	SlotHandle emplace(Args&&... args);
+
+	// Removes the object, the last one in the packed array takes its
+	// place. Returns false for a null or stale handle.
+	bool remove(SlotHandle handle);
+	void clear();
+
+	// The object, or 0 when the handle is null or stale.
+	T* get(SlotHandle handle);
+	const T* get(SlotHandle handle) const;
+	bool contains(SlotHandle handle) const { return get(handle) != 0; }
+
+	// Packed access, i in [0, size()). Removing moves the last object, so
+	// remove while walking by looking at the same index again.
+	T& at(int i) { return mItems[i]; }
+	const T& at(int i) const { return mItems[i]; }
+	SlotHandle handleAt(int i) const { return SlotHandle(mSlotOf[i], mSlots[mSlotOf[i]].generation); }
+	void removeAt(int i);
+
+	iterator begin() { return mItems.data(); }
+	iterator end() { return mItems.data() + mItems.size(); }
+	const_iterator begin() const { return mItems.data(); }
+	const_iterator end() const { return mItems.data() + mItems.size(); }
+
+	int size() const { return (int)mItems.size(); }
+	int capacity() const { return (int)mSlots.size(); }
+	bool empty() const { return mItems.empty(); }
+	bool full() const { return size() == capacity(); }
+
+private:
+	SlotMap(const SlotMap&);
+	SlotMap& operator=(const SlotMap&);
+
+	struct Slot
+	{
+		uint32_t item;						// Index in mItems, or the next free slot
+		uint32_t generation;				// Odd while in use, even while free
+	};
+
+	std::vector<T> mItems;					// Packed objects
+	std::vector<uint32_t> mSlotOf;			// Slot of each packed object
+	std::vector<Slot> mSlots;
+	uint32_t mFreeSlot;						// Head of the free slot list
+};
+
+template <typename T>
+SlotMap<T>::SlotMap(int capacity) : mFreeSlot(0)
+{
+	if( capacity < 1 )
+		capacity = 1;
+
+	mItems.reserve(capacity);
+	mSlotOf.reserve(capacity);
+	mSlots.resize(capacity);
+
+	// Every slot free, chained in order.
+	for( int i = 0; i < capacity; ++i )
+	{
+		mSlots[i].item = i + 1;
+		mSlots[i].generation = 0;
+	}
+}
+
+template <typename T>
+template <typename... Args>
+SlotHandle SlotMap<T>::emplace(Args&&... args)
+{
+	if( full() )
+		return SlotHandle();
+
+	uint32_t slot = mFreeSlot;
+	mFreeSlot = mSlots[slot].item;
+
+	mSlots[slot].item = (uint32_t)mItems.size();
+	++mSlots[slot].generation;
+	mItems.emplace_back(std::forward<Args>(args)...);
+	mSlotOf.push_back(slot);
+
+	return SlotHandle(slot, mSlots[slot].generation);
+}
+
+template <typename T>
+bool SlotMap<T>::remove(SlotHandle handle)
+{
+	if( !contains(handle) )
+		return false;
+
+	removeAt(mSlots[handle.index].item);
+	return true;
+}
+
+template <typename T>
+void SlotMap<T>::removeAt(int i)
+{
+	uint32_t slot = mSlotOf[i];
+	uint32_t last = (uint32_t)mItems.size() - 1;
+
+	if( (uint32_t)i != last )
+	{
+		mItems[i] = std::move(mItems[last]);
+		mSlotOf[i] = mSlotOf[last];
+		mSlots[mSlotOf[i]].item = i;
+	}
+
+	mItems.pop_back();
+	mSlotOf.pop_back();
+
+	// Even again, wrapping to 0 included, so the handles it gave are stale
+	++mSlots[slot].generation;
+
+	mSlots[slot].item = mFreeSlot;
+	mFreeSlot = slot;
+}
+
+template <typename T>
+void SlotMap<T>::clear()
+{
+	while( !mItems.empty() )
+		removeAt(size() - 1);
+}
+
+template <typename T>
+T* SlotMap<T>::get(SlotHandle handle)
+{
+	if( handle.index >= mSlots.size() || !(handle.generation & 1) || mSlots[handle.index].generation != handle.generation )
+		return 0;
+
+	return &mItems[mSlots[handle.index].item];
+}
+
+template <typename T>
+const T* SlotMap<T>::get(SlotHandle handle) const
+{
+	if( handle.index >= mSlots.size() || !(handle.generation & 1) || mSlots[handle.index].generation != handle.generation )
+		return 0;
+
+	return &mItems[mSlots[handle.index].item];
+}
+
+#endif // SLOTMAP_H
@@ -0,0 +1,73 @@
+// SoundCache.h
+// Decoded sounds, read once per file and shared by every voice playing
+// them. Like the images, a cached sound never changes after it is loaded,
+// so the audio thread reads the samples while the game thread holds the
+// handle.
+//
+// A cache made for a mixer rate converts every sound to that rate as it
+// loads it, and keeps at most the first two channels (front left and
+// right), so playing a sound costs the same whatever file it came from.
+// Mono sounds stay mono, the mixer spreads them over both sides.
+#ifndef SOUNDCACHE_H
+#define SOUNDCACHE_H
+#include <stddef.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Float samples, the channels of a frame next to each other.
+struct Sound
+{
+	Sound() : sampleRate(0), channels(0) { }
+
+	bool empty() const { return samples.empty(); }
+	size_t frames() const { return channels ? samples.size() / channels : 0; }
+	double seconds() const { return sampleRate ? (double)frames() / sampleRate : 0.0; }
+	size_t bytes() const { return samples.size() * sizeof(float); }
+
+	int sampleRate;
+	int channels;
+	std::vector<float> samples;
+
+private:
+	Sound(const Sound& rhs);
+	Sound& operator=(const Sound& rhs);
+};
+
+typedef std::shared_ptr<const Sound> SoundHandle;
+
+class SoundCache
+{
+public:
+	// At sampleRate 0 the sounds keep the rate of their file.
+	explicit SoundCache(int sampleRate = 0);
+
+	// Returns the sound of the file, decoding it on the first request only.
+	// A file that fails to load gives an empty sound (and is not retried).
+	SoundHandle load(const char *szFileName);
+
+	// Drops the sounds no handle refers to anymore.
+	void purge();
+	void clear();
+
+	size_t size() const { return mSounds.size(); }
+	unsigned long hits() const { return mHits; }
+	unsigned long misses() const { return mMisses; }
+	size_t residentBytes() const { return mResidentBytes; }
+	int sampleRate() const { return mSampleRate; }
+
+private:
+	// The cache owns the sounds, handing out copies of these.
+	SoundCache(const SoundCache& rhs);
+	SoundCache& operator=(const SoundCache& rhs);
+
+private:
+	std::map<std::string, SoundHandle> mSounds;
+	int mSampleRate;
+	unsigned long mHits;
+	unsigned long mMisses;
+	size_t mResidentBytes;
+};
+
+#endif // SOUNDCACHE_H
@@ -4,24 +4,28 @@
 #ifndef SPRITE_H
 #define SPRITE_H
 
-#include "main.h"
+#include "Platform.h"
 #include "Vec2.h"
 #include "BackBuffer.h"
+#include "ImageCache.h"
 
 class Sprite
 {
 public:
-	Sprite(int imageID, int maskID);
-	Sprite(const char *szImageFile, const char *szMaskFile);
-	Sprite(const char *szImageFile, COLORREF crTransparentColor);
+	// The image comes from an ImageCache, sprites only share it.
+	explicit Sprite(const ImageHandle &image);
 
 	virtual ~Sprite();
 
-	int width(){ return mImageBM.bmWidth; }
-	int height(){ return mImageBM.bmHeight; }
+	int width(){ return mpImage->image.width(); }
+	int height(){ return mpImage->image.height(); }
 	void update(float dt);
 
-	void setBackBuffer(const BackBuffer *pBackBuffer);
+	// Switching images is as cheap as copying the handle.
+	void setImage(const ImageHandle &image);
+	const ImageHandle& image() const { return mpImage; }
+
+	void setBackBuffer(BackBuffer *pBackBuffer);
 	virtual void draw();
 
 public:
@@ -30,26 +34,16 @@ public:
 	Vec2 mPosition;
 	Vec2 mVelocity;
 
-private:
-	// Make copy constructor and assignment operator private
-	// so client cannot copy Sprites. We do this because
-	// this class is not designed to be copied because it
-	// is not efficient--copying bitmaps is slow (lots of memory).
-	Sprite(const Sprite& rhs);
-	Sprite& operator=(const Sprite& rhs);
-
 protected:
-	HBITMAP mhImage;
-	HBITMAP mhMask;
-	BITMAP mImageBM;
-	BITMAP mMaskBM;
+	ImageHandle mpImage;
+	BackBuffer *mpBackBuffer;
 
-	HDC mhSpriteDC;
-	const BackBuffer *mpBackBuffer;
-
-	COLORREF mcTransparentColor;
 	void drawTransparent();
 	void drawMask();
+
+	// Draws the w x h block at (srcX, srcY) of the image with its upper-left
+	// corner at (x, y) in the back buffer, clipped to the back buffer.
+	void composite(int x, int y, int srcX, int srcY, int w, int h);
 };
 
 // AnimatedSprite
@@ -59,7 +53,7 @@ class AnimatedSprite : public Sprite
 {
 public:
 	//NOTE: The animation is on a single row.
-	AnimatedSprite(const char *szImageFile, const char *szMaskFile, const RECT& rcFirstFrame, int iFrameCount);
+	AnimatedSprite(const ImageHandle &image, const RECT& rcFirstFrame, int iFrameCount);
 	virtual ~AnimatedSprite() { }
 
 public:
@@ -0,0 +1,127 @@
+// SpscQueue.h
+// Fixed size ring passing items from one thread to one other without
+// locks. push() and pop() each finish in a bounded number of steps
+// whatever the other thread does: a full queue refuses the item and
+// counts it as an overflow rather than waiting for room.
+//
+// Only the producer thread may call push(), only the consumer pop().
+// Each side owns one index and reads the other's with acquire ordering,
+// so an item is fully written before the consumer can see it and fully
+// taken before the producer writes over its slot. The indices sit on
+// cache lines of their own so the two threads do not fight over one.
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <atomic>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue
+{
+public:
+	// The capacity is rounded up to a power of two.
+	explicit SpscQueue(int capacity);
+
+	// Producer side. Returns false, counting an overflow, when full.
+	bool push(const T &item);
+	bool push(T &&item);
+
+	// Consumer side. Moves the oldest item into item, false when empty.
+	bool pop(T &item);
+
+	// Items waiting, exact on either side, a snapshot from anywhere else.
+	int depth() const { return (int)(mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire)); }
+	int capacity() const { return (int)mItems.size(); }
+
+	// Counters kept by the producer, readable from any thread.
+	unsigned long pushed() const { return mPushed.load(std::memory_order_relaxed); }
+	unsigned long overflows() const { return mOverflows.load(std::memory_order_relaxed); }
+	int peakDepth() const { return mPeakDepth.load(std::memory_order_relaxed); }
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator=(const SpscQueue&);
+
+	template <typename U>
+	bool emplace(U &&item);
+
+	enum { CACHE_LINE = 64 };
+
+	std::vector<T> mItems;
+	uint64_t mMask;
+
+	// Producer's line: where the next item goes and its counters
+	char mPad0[CACHE_LINE];
+	std::atomic<uint64_t> mTail;
+	std::atomic<unsigned long> mPushed;
+	std::atomic<unsigned long> mOverflows;
+	std::atomic<int> mPeakDepth;
+
+	// Consumer's line: the oldest item
+	char mPad1[CACHE_LINE];
+	std::atomic<uint64_t> mHead;
+	char mPad2[CACHE_LINE];
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(int capacity)
+	: mTail(0), mPushed(0), mOverflows(0), mPeakDepth(0), mHead(0)
+{
+	size_t size = 1;
+	while( size < (size_t)capacity )
+		size <<= 1;
+
+	mItems.resize(size);
+	mMask = size - 1;
+}
+
+template <typename T>
+bool SpscQueue<T>::push(const T &item)
+{
+	return emplace(item);
+}
+
+template <typename T>
+bool SpscQueue<T>::push(T &&item)
+{
+	return emplace(std::move(item));
+}
+
+template <typename T>
+template <typename U>
+bool SpscQueue<T>::emplace(U &&item)
+{
+	const uint64_t tail = mTail.load(std::memory_order_relaxed);
+	const uint64_t head = mHead.load(std::memory_order_acquire);
+	if( tail - head == mItems.size() )
+	{
+		mOverflows.store(mOverflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	mItems[tail & mMask] = std::forward<U>(item);
+	mTail.store(tail + 1, std::memory_order_release);
+
+	// The consumer may have taken some since, so at worst a little high
+	int depth = (int)(tail + 1 - head);
+	if( depth > mPeakDepth.load(std::memory_order_relaxed) )
+		mPeakDepth.store(depth, std::memory_order_relaxed);
+	mPushed.store(mPushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::pop(T &item)
+{
+	const uint64_t head = mHead.load(std::memory_order_relaxed);
+	if( head == mTail.load(std::memory_order_acquire) )
+		return false;
+
+	// Moved out, so the slot lets go of what the item holds right away
+	item = std::move(mItems[head & mMask]);
+	mHead.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+#endif // SPSCQUEUE_H
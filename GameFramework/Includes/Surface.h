@@ -0,0 +1,72 @@
+// Surface.h
+// 32-bit pixel surface in system memory, used for the back buffer and
+// for the images sprites are drawn from.
+#ifndef SURFACE_H
+#define SURFACE_H
+#include "Platform.h"
+#include <stdint.h>
+#include <vector>
+
+// Pixels are stored as 0xAARRGGBB, which is the memory layout of a
+// 32 bpp DIB (B, G, R, A bytes), so a surface can be handed to GDI as is.
+inline uint32_t makePixel(BYTE r, BYTE g, BYTE b)
+{
+	return 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+}
+
+// Converts a Win32 COLORREF (0x00BBGGRR) to the surface pixel format.
+inline uint32_t colorRefToPixel(COLORREF cr)
+{
+	return makePixel(GetRValue(cr), GetGValue(cr), GetBValue(cr));
+}
+
+class Surface
+{
+public:
+	Surface();
+	Surface(int width, int height);
+	~Surface();
+
+	// Allocates an owned, uninitialized surface.
+	bool create(int width, int height);
+
+	// Wraps memory owned by someone else (a DIB section for instance).
+	// Pitch is in pixels.
+	void attach(uint32_t *pPixels, int width, int height, int pitch);
+
+	void release();
+
+	bool empty() const { return mpPixels == 0; }
+	int width() const { return mWidth; }
+	int height() const { return mHeight; }
+	int pitch() const { return mPitch; }
+
+	uint32_t* pixels() { return mpPixels; }
+	const uint32_t* pixels() const { return mpPixels; }
+	uint32_t* row(int y) { return mpPixels + (size_t)y * mPitch; }
+	const uint32_t* row(int y) const { return mpPixels + (size_t)y * mPitch; }
+
+	void clear(uint32_t color);
+
+private:
+	// Surfaces hold whole images, copying them by accident is slow.
+	Surface(const Surface& rhs);
+	Surface& operator=(const Surface& rhs);
+
+private:
+	std::vector<uint32_t> mStorage;
+	uint32_t *mpPixels;
+	int mWidth;
+	int mHeight;
+	int mPitch;
+};
+
+// Loads a .bmp file into a top-down, fully opaque surface.
+bool loadSurfaceFromFile(const char *szFileName, Surface &surface);
+
+#ifdef _WIN32
+// Copies a GDI bitmap into a top-down, fully opaque surface.
+bool loadSurfaceFromBitmap(HBITMAP hBitmap, Surface &surface);
+#endif
+
+#endif // SURFACE_H
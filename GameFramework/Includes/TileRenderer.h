@@ -0,0 +1,67 @@
+// TileRenderer.h
+// Draws a RenderQueue with several threads. The frame is cut into square
+// tiles, each command is binned into the tiles it overlaps, then a pool of
+// workers composites whole tiles, claiming them from an atomic counter.
+// A tile belongs to a single thread for the frame, so the pixels are
+// written with no locks at all.
+//
+// Every tile draws its commands in queue order through the same blitters
+// as RenderQueue::submit(), so the frame is byte for byte the one a
+// single thread would draw.
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+#include "RenderQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TileRenderer
+{
+public:
+	enum { TILE_SIZE = 64, MAX_THREADS = 16 };
+
+	// threadCount includes the calling thread, 1 draws with no workers.
+	explicit TileRenderer(int threadCount = 1);
+	~TileRenderer();
+
+	void setThreadCount(int threadCount);
+	int threadCount() const { return (int)mWorkers.size() + 1; }
+
+	// Sorts the queue, draws it into the back buffer and empties it.
+	void submit(RenderQueue &queue, BackBuffer &backBuffer);
+
+	// Threads the CPU runs at once.
+	static int hardwareThreads();
+
+private:
+	void startWorkers(int count);
+	void stopWorkers();
+	void workerMain(unsigned long frame);	// Starts after the given frame
+	void drawTiles();
+	void drawTile(int tile);
+
+	TileRenderer(const TileRenderer& rhs);
+	TileRenderer& operator=(const TileRenderer& rhs);
+
+private:
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWake;		// A frame is ready, or the workers must quit
+	std::condition_variable mDone;		// The last worker finished the frame
+	unsigned long mFrame;				// Frames handed to the workers
+	int mBusy;							// Workers still drawing the frame
+	bool mQuit;
+
+	std::atomic<int> mNextTile;
+
+	// The frame being drawn.
+	const RenderQueue *mpQueue;
+	Surface *mpTarget;
+	int mTilesX;
+	int mTilesY;
+	std::vector< std::vector<unsigned int> > mBins;	// Commands overlapping each tile
+};
+
+#endif // TILERENDERER_H
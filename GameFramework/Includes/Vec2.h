@@ -9,6 +9,14 @@
 #ifndef VEC2_H
 #define VEC2_H
 
+//-----------------------------------------------------------------------------
+// Common math defines (shared by the Win32 front end and the simulation)
+//-----------------------------------------------------------------------------
+#define EPS 1e-3 // epsilon (the smallest float value used)
+#define PI 3.14159265358979323846
+#define DEG2RAD(deg) (PI * (deg) / 180.0)
+#define RAD2DEG(rad) ((rad) * 180.0 / PI)
+
 class Vec2
 {
 public:
@@ -41,5 +49,6 @@ public:
 };
 
 Vec2 Polar(double r, double radians);
+Vec2 Lerp(const Vec2& from, const Vec2& to, double t);	// from at t = 0, to at t = 1
 double PrincipleAngle(double radians);
 #endif // VEC2_H
@@ -0,0 +1,65 @@
+// WavFile.h
+// Reads RIFF WAVE files: PCM of 8, 16, 24 or 32 bits, 32 bit float and
+// Microsoft ADPCM, any number of channels. Chunks other than fmt and data
+// (fact, LIST, bext, ...) are skipped wherever they sit in the file, odd
+// sized chunks keep their pad byte. Samples come out as floats in [-1, 1)
+// with the channels of a frame next to each other.
+//
+// The data chunk decodes in pieces of whole blocks, a frame for PCM and
+// up to framesPerBlock frames for ADPCM, so a file can be read a bit at a
+// time as well as at once.
+#ifndef WAVFILE_H
+#define WAVFILE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum WavEncoding
+{
+	WAV_PCM,
+	WAV_FLOAT,
+	WAV_MSADPCM
+};
+
+struct WavFormat
+{
+	enum { MAX_ADPCM_COEFS = 32 };
+
+	WavEncoding encoding;
+	int channels;
+	int sampleRate;
+	int bitsPerSample;
+	int blockAlign;							// Bytes of a block
+	int framesPerBlock;						// 1 but for ADPCM
+
+	// ADPCM predictor coefficient pairs
+	int coefCount;
+	int16_t coef1[MAX_ADPCM_COEFS];
+	int16_t coef2[MAX_ADPCM_COEFS];
+};
+
+// Where the samples of a file are and how they are stored.
+struct WavInfo
+{
+	WavFormat format;
+	size_t dataOffset;						// From the start of the file
+	size_t dataSize;						// Cut to the bytes the file holds
+	size_t frames;							// Without the padding of a last ADPCM block
+};
+
+// Reads the chunks of the size bytes at data. False when they are not a
+// WAVE file in one of the supported encodings.
+bool parseWav(const uint8_t *data, size_t size, WavInfo &info);
+
+// Frames held by size bytes of the data chunk, a last partial ADPCM block
+// included.
+size_t wavFrames(const WavFormat &format, size_t size);
+
+// Decodes size bytes of the data chunk, starting on a block, into out
+// which holds wavFrames() frames. Returns the frames written.
+size_t decodeWav(const WavFormat &format, const uint8_t *bytes, size_t size, float *out);
+
+// Reads and decodes a whole file. False if it cannot be read or parsed.
+bool loadWav(const char *szFileName, WavFormat &format, std::vector<float> &samples);
+
+#endif // WAVFILE_H
@@ -0,0 +1,280 @@
+// AudioEngine.cpp
+// Mixes on a thread of its own into a ring that feeds the output.
+#include "AudioEngine.h"
+#include <chrono>
+
+namespace
+{
+	// Longest wait for the output to make room, the thread then looks at
+	// its requests again
+	const int WAIT_MS = 2;
+
+	inline int16_t toSample(float v)
+	{
+		float scaled = v * 32768.0f;
+		return scaled >= 32767.0f ? 32767 : scaled <= -32768.0f ? -32768 : (int16_t)scaled;
+	}
+}
+
+AudioEngine::AudioEngine()
+	: mMixer(SAMPLE_RATE), mOutput(0), mRunning(false), mCommands(COMMAND_CAPACITY), mNextVoice(0), mApplied(0), mWritten(0), mRead(0)
+{
+	mMixBuffer.resize(BLOCK_FRAMES * CHANNELS);
+	mRing.resize(RING_FRAMES * CHANNELS);
+}
+
+AudioEngine::~AudioEngine()
+{
+	stop();
+}
+
+bool AudioEngine::start(AudioOutput *output, bool threaded)
+{
+	stop();
+
+	if( !output || !output->open(SAMPLE_RATE, CHANNELS) )
+	{
+		delete output;
+		return false;
+	}
+
+	mOutput = output;
+	mWritten = mRead = 0;
+	mApplied = 0;
+	{
+		std::lock_guard<std::mutex> lock(mStatsMutex);
+		mStats = AudioStats();
+	}
+
+	if( threaded )
+	{
+		mRunning = true;
+		mThread = std::thread(&AudioEngine::run, this);
+	}
+	return true;
+}
+
+void AudioEngine::stop()
+{
+	if( mThread.joinable() )
+	{
+		mRunning = false;
+		mThread.join();
+	}
+
+	if( mOutput )
+	{
+		// The last requests still count, though no block plays them
+		applyCommands();
+		{
+			std::lock_guard<std::mutex> lock(mStatsMutex);
+			mStats.commands = mApplied;
+		}
+
+		// Whatever render() mixed ahead
+		while( mRead < mWritten && drain() )
+			;
+
+		mOutput->close();
+		delete mOutput;
+		mOutput = 0;
+	}
+
+	// The thread is gone, this side takes what it left
+	mMixer.stopAll();
+	while( mCommands.pop(mApplying) )
+		;
+	mApplying.sound.reset();
+	mApplying.stream.reset();
+}
+
+VoiceId AudioEngine::play(const SoundHandle &sound, float volume, float pan, bool loop)
+{
+	Command command;
+	command.type = Command::PLAY;
+	command.sound = sound;
+	command.volume = volume;
+	command.pan = pan;
+	command.loop = loop;
+
+	// Made here, so the caller can refer to the voice at once
+	if( ++mNextVoice == 0 )
+		++mNextVoice;
+	command.id = mNextVoice;
+	return post(command) ? mNextVoice : 0;
+}
+
+VoiceId AudioEngine::playStream(const StreamHandle &stream, float volume, float pan)
+{
+	Command command;
+	command.type = Command::PLAY_STREAM;
+	command.stream = stream;
+	command.volume = volume;
+	command.pan = pan;
+	command.loop = false;
+
+	if( ++mNextVoice == 0 )
+		++mNextVoice;
+	command.id = mNextVoice;
+	return post(command) ? mNextVoice : 0;
+}
+
+void AudioEngine::stopVoice(VoiceId id)
+{
+	Command command;
+	command.type = Command::STOP;
+	command.id = id;
+	post(command);
+}
+
+void AudioEngine::stopAllVoices()
+{
+	Command command;
+	command.type = Command::STOP_ALL;
+	command.id = 0;
+	post(command);
+}
+
+void AudioEngine::setVolume(VoiceId id, float volume)
+{
+	Command command;
+	command.type = Command::SET_VOLUME;
+	command.id = id;
+	command.volume = volume;
+	post(command);
+}
+
+void AudioEngine::setPan(VoiceId id, float pan)
+{
+	Command command;
+	command.type = Command::SET_PAN;
+	command.id = id;
+	command.pan = pan;
+	post(command);
+}
+
+void AudioEngine::render(int frames)
+{
+	if( !mOutput || mThread.joinable() )
+		return;
+
+	// Whole blocks, what is left over waits in the ring for the next call
+	while( frames > 0 )
+	{
+		if( mRead == mWritten )
+		{
+			mMixer.prefetch();
+			mixBlock();
+		}
+
+		int index = (int)(mRead % RING_FRAMES);
+		int count = (int)(mWritten - mRead);
+		if( count > RING_FRAMES - index ) count = RING_FRAMES - index;
+		if( count > frames ) count = frames;
+
+		int taken = mOutput->write(&mRing[(size_t)index * CHANNELS], count);
+		if( !taken )
+			break;
+		mRead += taken;
+		frames -= taken;
+	}
+}
+
+AudioStats AudioEngine::stats() const
+{
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	return mStats;
+}
+
+bool AudioEngine::post(Command &command)
+{
+	return mCommands.push(std::move(command));
+}
+
+void AudioEngine::applyCommands()
+{
+	while( mCommands.pop(mApplying) )
+	{
+		const Command &command = mApplying;
+		switch( command.type )
+		{
+		case Command::PLAY:			mMixer.play(command.id, command.sound, command.volume, command.pan, command.loop); break;
+		case Command::PLAY_STREAM:	mMixer.playStream(command.id, command.stream, command.volume, command.pan); break;
+		case Command::STOP:			mMixer.stop(command.id); break;
+		case Command::STOP_ALL:		mMixer.stopAll(); break;
+		case Command::SET_VOLUME:	mMixer.setVolume(command.id, command.volume); break;
+		case Command::SET_PAN:		mMixer.setPan(command.id, command.pan); break;
+		}
+		++mApplied;
+	}
+
+	// The sound goes back to the cache here rather than with the next request
+	mApplying.sound.reset();
+	mApplying.stream.reset();
+}
+
+void AudioEngine::run()
+{
+	while( mRunning )
+	{
+		// Keep the ring full, then give the output what it takes
+		while( ringFree() >= BLOCK_FRAMES )
+			mixBlock();
+
+		// Streams read ahead once the block is out of the way
+		int drained = drain();
+		mMixer.prefetch();
+
+		if( !drained )
+		{
+			// Take the requests while waiting too, so they never pile up
+			// for longer than a wait
+			mOutput->wait(WAIT_MS);
+			applyCommands();
+		}
+	}
+}
+
+void AudioEngine::mixBlock()
+{
+	applyCommands();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	mMixer.mix(mMixBuffer.data(), BLOCK_FRAMES);
+
+	// Blocks never wrap, the ring is a whole number of them
+	int16_t *dst = &mRing[(size_t)(mWritten % RING_FRAMES) * CHANNELS];
+	for( int i = 0; i < BLOCK_FRAMES * CHANNELS; ++i )
+		dst[i] = toSample(mMixBuffer[i]);
+	mWritten += BLOCK_FRAMES;
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	mStats.blocks++;
+	mStats.commands = mApplied;
+	mStats.mixTimes.add(seconds);
+	if( mMixer.voiceCount() > mStats.peakVoices )
+		mStats.peakVoices = mMixer.voiceCount();
+	mStats.droppedVoices = mMixer.droppedCount();
+	mStats.underruns = mMixer.underrunCount();
+}
+
+int AudioEngine::drain()
+{
+	int total = 0;
+	while( mRead < mWritten )
+	{
+		int index = (int)(mRead % RING_FRAMES);
+		int available = (int)(mWritten - mRead);
+		int count = available < RING_FRAMES - index ? available : RING_FRAMES - index;
+
+		int taken = mOutput->write(&mRing[(size_t)index * CHANNELS], count);
+		mRead += taken;
+		total += taken;
+		if( taken < count )
+			break;
+	}
+	return total;
+}
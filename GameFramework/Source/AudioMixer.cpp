@@ -0,0 +1,238 @@
+// AudioMixer.cpp
+// Adds up the voices playing into stereo blocks.
+#include "AudioMixer.h"
+#include <string.h>
+
+namespace
+{
+	const uint64_t ONE = (uint64_t)1 << 32;		// A frame in 32.32 fixed point
+	const float FRACTION_SCALE = 1.0f / 4294967296.0f;
+}
+
+AudioMixer::AudioMixer(int sampleRate)
+	: mSampleRate(sampleRate > 0 ? sampleRate : 1), mVoiceCount(0), mDropped(0), mUnderruns(0)
+{
+}
+
+bool AudioMixer::play(VoiceId id, const SoundHandle &sound, float volume, float pan, bool loop)
+{
+	if( !sound || sound->empty() )
+		return false;
+
+	if( mVoiceCount == MAX_VOICES )
+	{
+		++mDropped;
+		return false;
+	}
+
+	Voice &voice = mVoices[mVoiceCount++];
+	voice.id = id;
+	voice.sound = sound;
+	voice.position = 0;
+	voice.step = ((uint64_t)sound->sampleRate << 32) / mSampleRate;
+	voice.volume = volume;
+	voice.pan = pan;
+	voice.loop = loop;
+	updateGains(voice);
+	return true;
+}
+
+bool AudioMixer::playStream(VoiceId id, const StreamHandle &stream, float volume, float pan)
+{
+	if( !stream || stream->finished() || stream->sampleRate() != mSampleRate )
+		return false;
+
+	if( mVoiceCount == MAX_VOICES )
+	{
+		++mDropped;
+		return false;
+	}
+
+	Voice &voice = mVoices[mVoiceCount++];
+	voice.id = id;
+	voice.stream = stream;
+	voice.position = 0;
+	voice.step = ONE;
+	voice.volume = volume;
+	voice.pan = pan;
+	voice.loop = false;
+	updateGains(voice);
+	return true;
+}
+
+void AudioMixer::stop(VoiceId id)
+{
+	int i = find(id);
+	if( i >= 0 )
+		remove(i);
+}
+
+void AudioMixer::stopAll()
+{
+	while( mVoiceCount )
+		remove(mVoiceCount - 1);
+}
+
+void AudioMixer::setVolume(VoiceId id, float volume)
+{
+	int i = find(id);
+	if( i >= 0 )
+	{
+		mVoices[i].volume = volume;
+		updateGains(mVoices[i]);
+	}
+}
+
+void AudioMixer::setPan(VoiceId id, float pan)
+{
+	int i = find(id);
+	if( i >= 0 )
+	{
+		mVoices[i].pan = pan;
+		updateGains(mVoices[i]);
+	}
+}
+
+void AudioMixer::mix(float *out, int frames)
+{
+	memset(out, 0, (size_t)frames * 2 * sizeof(float));
+
+	// The last voice moves into a removed one, look at it again
+	for( int i = 0; i < mVoiceCount; )
+	{
+		Voice &voice = mVoices[i];
+		if( voice.stream ? mixStream(voice, out, frames) : mixVoice(voice, out, frames) )
+			++i;
+		else
+			remove(i);
+	}
+}
+
+int AudioMixer::prefetch()
+{
+	int added = 0;
+	for( int i = 0; i < mVoiceCount; ++i )
+		if( mVoices[i].stream )
+			added += mVoices[i].stream->prefetch();
+	return added;
+}
+
+int AudioMixer::find(VoiceId id) const
+{
+	for( int i = 0; i < mVoiceCount; ++i )
+		if( mVoices[i].id == id )
+			return i;
+	return -1;
+}
+
+void AudioMixer::updateGains(Voice &voice)
+{
+	float pan = voice.pan < -1 ? -1 : voice.pan > 1 ? 1 : voice.pan;
+	voice.gainLeft = voice.volume * (pan > 0 ? 1 - pan : 1);
+	voice.gainRight = voice.volume * (pan < 0 ? 1 + pan : 1);
+}
+
+void AudioMixer::remove(int i)
+{
+	// Let go of the sound here, the moved voice holds its own
+	mVoices[i].sound.reset();
+	mVoices[i].stream.reset();
+	if( i != mVoiceCount - 1 )
+		mVoices[i] = mVoices[mVoiceCount - 1];
+	mVoices[--mVoiceCount].sound.reset();
+	mVoices[mVoiceCount].stream.reset();
+}
+
+bool AudioMixer::mixVoice(Voice &voice, float *out, int frames)
+{
+	const Sound &sound = *voice.sound;
+	const float *src = sound.samples.data();
+	const int channels = sound.channels;
+	const uint64_t count = sound.frames();
+	const uint64_t length = count << 32;
+	const float gainLeft = voice.gainLeft, gainRight = voice.gainRight;
+
+	// At the mixer rate the voice always sits on a frame
+	if( voice.step == ONE )
+	{
+		uint64_t i = voice.position >> 32;
+		for( int f = 0; f < frames; ++f, ++i )
+		{
+			if( i >= count )
+			{
+				if( !voice.loop )
+				{
+					voice.position = length;
+					return false;
+				}
+				i = 0;
+			}
+
+			const float *a = src + i * channels;
+			out[f * 2] += a[0] * gainLeft;
+			out[f * 2 + 1] += (channels > 1 ? a[1] : a[0]) * gainRight;
+		}
+
+		voice.position = i << 32;
+		return voice.loop || i < count;
+	}
+
+	for( int f = 0; f < frames; ++f )
+	{
+		if( voice.position >= length )
+		{
+			if( !voice.loop )
+				return false;
+			voice.position %= length;
+		}
+
+		// Between this frame and the next, the start follows the end of a loop
+		uint64_t i = voice.position >> 32;
+		uint64_t next = i + 1 < count ? i + 1 : voice.loop ? 0 : i;
+		float t = (uint32_t)voice.position * FRACTION_SCALE;
+
+		const float *a = src + i * channels;
+		const float *b = src + next * channels;
+		float left = a[0] + (b[0] - a[0]) * t;
+		float right = channels > 1 ? a[1] + (b[1] - a[1]) * t : left;
+
+		out[f * 2] += left * gainLeft;
+		out[f * 2 + 1] += right * gainRight;
+		voice.position += voice.step;
+	}
+
+	return voice.loop || voice.position < length;
+}
+
+bool AudioMixer::mixStream(Voice &voice, float *out, int frames)
+{
+	AudioStream &stream = *voice.stream;
+	const int channels = stream.channels();
+	const float gainLeft = voice.gainLeft, gainRight = voice.gainRight;
+
+	// Through a small buffer, the ring may wrap anywhere
+	const int PIECE = 256;
+	float buffer[PIECE * 2];
+	for( int done = 0; done < frames; )
+	{
+		int want = frames - done < PIECE ? frames - done : PIECE;
+		int count = stream.read(buffer, want);
+		for( int f = 0; f < count; ++f )
+		{
+			const float *a = buffer + f * channels;
+			out[(done + f) * 2] += a[0] * gainLeft;
+			out[(done + f) * 2 + 1] += (channels > 1 ? a[1] : a[0]) * gainRight;
+		}
+
+		done += count;
+		if( count < want )
+		{
+			// Silence for the rest, the stream catches up next time
+			if( !stream.finished() )
+				++mUnderruns;
+			break;
+		}
+	}
+
+	return !stream.finished();
+}
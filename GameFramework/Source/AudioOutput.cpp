@@ -0,0 +1,262 @@
+// AudioOutput.cpp
+// The sound card, null and WAV file outputs.
+#include "AudioOutput.h"
+#include <string.h>
+#include <thread>
+
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace
+{
+	// Frames a paced output takes ahead of its clock, like the buffers of a
+	// device: 50 ms
+	const int LEAD_DIVISOR = 20;
+
+	void put16(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+	void put32(uint8_t *p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+
+	// The 44 byte header of a 16 bit PCM WAV file holding dataBytes bytes.
+	void makeWavHeader(uint8_t *header, int sampleRate, int channels, uint32_t dataBytes)
+	{
+		memcpy(header, "RIFF", 4);
+		put32(header + 4, 36 + dataBytes);
+		memcpy(header + 8, "WAVEfmt ", 8);
+		put32(header + 16, 16);
+		put16(header + 20, 1);
+		put16(header + 22, channels);
+		put32(header + 24, sampleRate);
+		put32(header + 28, sampleRate * channels * 2);
+		put16(header + 32, channels * 2);
+		put16(header + 34, 16);
+		memcpy(header + 36, "data", 4);
+		put32(header + 40, dataBytes);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// PacedAudioOutput
+//-----------------------------------------------------------------------------
+PacedAudioOutput::PacedAudioOutput(bool realtime)
+	: mChannels(0), mRealtime(realtime), mSampleRate(0), mWritten(0)
+{
+}
+
+void PacedAudioOutput::startClock(int sampleRate, int channels)
+{
+	mSampleRate = sampleRate;
+	mChannels = channels;
+	mWritten = 0;
+	mStart = std::chrono::steady_clock::now();
+}
+
+int PacedAudioOutput::room(int count)
+{
+	if( !mRealtime )
+		return count;
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+	int64_t allowed = (int64_t)(elapsed * mSampleRate) + mSampleRate / LEAD_DIVISOR - (int64_t)mWritten;
+	return allowed <= 0 ? 0 : allowed < count ? (int)allowed : count;
+}
+
+void PacedAudioOutput::wait(int ms)
+{
+	if( mRealtime )
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+//-----------------------------------------------------------------------------
+// NullAudioOutput
+//-----------------------------------------------------------------------------
+bool NullAudioOutput::open(int sampleRate, int channels)
+{
+	startClock(sampleRate, channels);
+	return true;
+}
+
+int NullAudioOutput::write(const int16_t*, int count)
+{
+	int taken = room(count);
+	consumed(taken);
+	return taken;
+}
+
+//-----------------------------------------------------------------------------
+// WavFileAudioOutput
+//-----------------------------------------------------------------------------
+WavFileAudioOutput::WavFileAudioOutput(const char *szFileName, bool realtime)
+	: PacedAudioOutput(realtime), mFileName(szFileName ? szFileName : ""), mpFile(0), mDataBytes(0)
+{
+}
+
+WavFileAudioOutput::~WavFileAudioOutput()
+{
+	close();
+}
+
+bool WavFileAudioOutput::open(int sampleRate, int channels)
+{
+	close();
+
+	mpFile = fopen(mFileName.c_str(), "wb");
+	if( !mpFile )
+		return false;
+
+	// The sizes are filled in on close
+	uint8_t header[44];
+	makeWavHeader(header, sampleRate, channels, 0);
+	fwrite(header, 1, sizeof(header), mpFile);
+
+	mDataBytes = 0;
+	startClock(sampleRate, channels);
+	return true;
+}
+
+void WavFileAudioOutput::close()
+{
+	if( !mpFile )
+		return;
+
+	// Now the sizes are known
+	uint8_t header[44];
+	makeWavHeader(header, sampleRate(), mChannels, mDataBytes);
+	fseek(mpFile, 0, SEEK_SET);
+	fwrite(header, 1, sizeof(header), mpFile);
+	fclose(mpFile);
+	mpFile = 0;
+}
+
+int WavFileAudioOutput::write(const int16_t *frames, int count)
+{
+	if( !mpFile )
+		return count;
+
+	int taken = room(count);
+	fwrite(frames, sizeof(int16_t) * mChannels, taken, mpFile);
+	mDataBytes += (uint32_t)(taken * mChannels * sizeof(int16_t));
+	consumed(taken);
+	return taken;
+}
+
+#ifdef _WIN32
+//-----------------------------------------------------------------------------
+// WaveOutAudioOutput
+//-----------------------------------------------------------------------------
+WaveOutAudioOutput::WaveOutAudioOutput(int bufferFrames)
+	: mDevice(0), mEvent(0), mBufferFrames(bufferFrames > 0 ? bufferFrames : 1), mChannels(0), mNext(0), mFill(0)
+{
+	memset(mHeaders, 0, sizeof(mHeaders));
+}
+
+WaveOutAudioOutput::~WaveOutAudioOutput()
+{
+	close();
+}
+
+bool WaveOutAudioOutput::open(int sampleRate, int channels)
+{
+	close();
+
+	WAVEFORMATEX format;
+	memset(&format, 0, sizeof(format));
+	format.wFormatTag = WAVE_FORMAT_PCM;
+	format.nChannels = (WORD)channels;
+	format.nSamplesPerSec = sampleRate;
+	format.wBitsPerSample = 16;
+	format.nBlockAlign = (WORD)(channels * 2);
+	format.nAvgBytesPerSec = sampleRate * format.nBlockAlign;
+
+	mEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if( !mEvent )
+		return false;
+
+	if( waveOutOpen(&mDevice, WAVE_MAPPER, &format, (DWORD_PTR)mEvent, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR )
+	{
+		mDevice = 0;
+		CloseHandle(mEvent);
+		mEvent = 0;
+		return false;
+	}
+
+	// Every buffer starts out done, free to fill
+	mChannels = channels;
+	for( int i = 0; i < BUFFER_COUNT; ++i )
+	{
+		mBuffers[i].assign((size_t)mBufferFrames * channels, 0);
+		memset(&mHeaders[i], 0, sizeof(WAVEHDR));
+		mHeaders[i].lpData = (LPSTR)mBuffers[i].data();
+		mHeaders[i].dwBufferLength = (DWORD)(mBuffers[i].size() * sizeof(int16_t));
+		waveOutPrepareHeader(mDevice, &mHeaders[i], sizeof(WAVEHDR));
+		mHeaders[i].dwFlags |= WHDR_DONE;
+	}
+
+	mNext = 0;
+	mFill = 0;
+	return true;
+}
+
+void WaveOutAudioOutput::close()
+{
+	if( !mDevice )
+		return;
+
+	// Reset hands every queued buffer back
+	waveOutReset(mDevice);
+	for( int i = 0; i < BUFFER_COUNT; ++i )
+		waveOutUnprepareHeader(mDevice, &mHeaders[i], sizeof(WAVEHDR));
+	waveOutClose(mDevice);
+	CloseHandle(mEvent);
+
+	mDevice = 0;
+	mEvent = 0;
+}
+
+int WaveOutAudioOutput::write(const int16_t *frames, int count)
+{
+	if( !mDevice )
+		return count;
+
+	int taken = 0;
+	while( taken < count )
+	{
+		WAVEHDR &header = mHeaders[mNext];
+		if( !(header.dwFlags & WHDR_DONE) )
+			break;
+
+		int n = count - taken < mBufferFrames - mFill ? count - taken : mBufferFrames - mFill;
+		memcpy(mBuffers[mNext].data() + (size_t)mFill * mChannels, frames + (size_t)taken * mChannels,
+			   (size_t)n * mChannels * sizeof(int16_t));
+		mFill += n;
+		taken += n;
+
+		// Queue the buffer once full
+		if( mFill == mBufferFrames )
+		{
+			header.dwFlags &= ~WHDR_DONE;
+			waveOutWrite(mDevice, &header, sizeof(WAVEHDR));
+			mNext = (mNext + 1) % BUFFER_COUNT;
+			mFill = 0;
+		}
+	}
+
+	return taken;
+}
+
+void WaveOutAudioOutput::wait(int ms)
+{
+	if( mEvent )
+		WaitForSingleObject(mEvent, ms);
+}
+#endif // _WIN32
+
+AudioOutput* createAudioOutput(int blockFrames)
+{
+#ifdef _WIN32
+	return new WaveOutAudioOutput(blockFrames);
+#else
+	(void)blockFrames;
+	return new NullAudioOutput(true);
+#endif
+}
@@ -0,0 +1,186 @@
+// AudioStream.cpp
+// Music read from a mapped WAV file a piece at a time.
+#include "AudioStream.h"
+#include <string.h>
+
+AudioStream::AudioStream(int sampleRate)
+	: mData(0), mDataSize(0), mNextByte(0), mTotalFrames(0), mFramesLeft(0), mPieceBytes(0), mPieceOutput(0),
+	  mChannels(0), mLoop(false), mEnded(true), mSampleRate(sampleRate > 0 ? sampleRate : 1),
+	  mResampler(mSampleRate, mSampleRate), mRingRead(0), mRingCount(0), mUnderruns(0), mFramesRead(0)
+{
+}
+
+AudioStream::~AudioStream()
+{
+	close();
+}
+
+bool AudioStream::open(const char *szFileName, bool loop)
+{
+	close();
+
+	WavInfo info;
+	if( !szFileName || !mFile.open(szFileName) || !parseWav(mFile.data(), mFile.size(), info) || !info.frames )
+	{
+		close();
+		return false;
+	}
+
+	mFormat = info.format;
+	mData = mFile.data() + info.dataOffset;
+	mDataSize = info.dataSize;
+	mNextByte = 0;
+	mTotalFrames = mFramesLeft = info.frames;
+	mChannels = mFormat.channels < 2 ? 1 : 2;
+	mLoop = loop;
+	mEnded = false;
+	mResampler = Resampler(mFormat.sampleRate, mSampleRate);
+	mPosition = ResamplePosition();
+
+	// Pieces of whole blocks whose frames fill at most half the ring, one
+	// block when a block is more than that
+	size_t frames = (size_t)RING_FRAMES / 2 * mFormat.sampleRate / mSampleRate;
+	if( frames > CHUNK_FRAMES )
+		frames = CHUNK_FRAMES;
+	size_t blocks = frames / mFormat.framesPerBlock;
+	if( blocks < 1 )
+		blocks = 1;
+	mPieceBytes = blocks * mFormat.blockAlign;
+	frames = blocks * mFormat.framesPerBlock;
+
+	// The filter may still hold a few frames of the last piece
+	mPieceOutput = (int)mResampler.outputFrames(frames + Resampler::TAPS + 1) + 1;
+
+	// Sized once, a stream never grows
+	mDecoded.resize(frames * mFormat.channels);
+	for( int c = 0; c < mChannels; ++c )
+	{
+		mPadded[c].reserve(frames + 2 * Resampler::TAPS + 1);
+		mPadded[c].assign(Resampler::HALF_TAPS, 0.0f);
+	}
+	mConverted.resize((size_t)mPieceOutput * mChannels);
+	mRing.resize((size_t)RING_FRAMES * mChannels);
+	mRingRead = mRingCount = 0;
+	mUnderruns = 0;
+	mFramesRead = 0;
+
+	prefetch();
+	return true;
+}
+
+void AudioStream::close()
+{
+	mFile.close();
+	mData = 0;
+	mDataSize = 0;
+	mEnded = true;
+	mRingCount = 0;
+}
+
+int AudioStream::prefetch()
+{
+	int added = 0;
+	while( !mEnded && RING_FRAMES - mRingCount >= mPieceOutput )
+		added += decodePiece();
+
+	// Ask for the next pieces now, so reading them later finds them in
+	if( !mEnded )
+		mFile.prefetch((size_t)(mData - mFile.data()) + mNextByte, mPieceBytes * 2);
+	return added;
+}
+
+int AudioStream::read(float *out, int frames)
+{
+	int count = frames < mRingCount ? frames : mRingCount;
+	int first = count < RING_FRAMES - mRingRead ? count : RING_FRAMES - mRingRead;
+
+	memcpy(out, &mRing[(size_t)mRingRead * mChannels], (size_t)first * mChannels * sizeof(float));
+	memcpy(out + (size_t)first * mChannels, mRing.data(), (size_t)(count - first) * mChannels * sizeof(float));
+
+	mRingRead = (mRingRead + count) % RING_FRAMES;
+	mRingCount -= count;
+	mFramesRead += count;
+
+	if( count < frames && !mEnded )
+		++mUnderruns;
+	return count;
+}
+
+size_t AudioStream::residentBytes() const
+{
+	size_t bytes = (mDecoded.capacity() + mConverted.capacity() + mRing.capacity()) * sizeof(float);
+	for( int c = 0; c < 2; ++c )
+		bytes += mPadded[c].capacity() * sizeof(float);
+	return bytes;
+}
+
+int AudioStream::decodePiece()
+{
+	size_t bytes = mDataSize - mNextByte < mPieceBytes ? mDataSize - mNextByte : mPieceBytes;
+	size_t frames = decodeWav(mFormat, mData + mNextByte, bytes, mDecoded.data());
+	if( frames > mFramesLeft )
+		frames = mFramesLeft;
+	mNextByte += bytes;
+	mFramesLeft -= frames;
+
+	bool end = mFramesLeft == 0 || mNextByte >= mDataSize;
+	if( end && mLoop )
+	{
+		// The start follows on, through the filter too
+		mNextByte = 0;
+		mFramesLeft = mTotalFrames;
+		end = false;
+	}
+
+	if( mResampler.passThrough() )
+	{
+		// Front pair kept in place
+		for( size_t i = 0; i < frames; ++i )
+			for( int c = 0; c < mChannels; ++c )
+				mDecoded[i * mChannels + c] = mDecoded[i * mFormat.channels + c];
+
+		push(mDecoded.data(), (int)frames);
+		mEnded = end;
+		return (int)frames;
+	}
+
+	for( int c = 0; c < mChannels; ++c )
+	{
+		std::vector<float> &padded = mPadded[c];
+		for( size_t i = 0; i < frames; ++i )
+			padded.push_back(mDecoded[i * mFormat.channels + c]);
+
+		// Silence after the end, like the whole file conversion
+		if( end )
+			padded.resize(padded.size() + Resampler::HALF_TAPS, 0.0f);
+	}
+
+	int count = (int)mResampler.available(mPosition, mPadded[0].size());
+	ResamplePosition position;
+	for( int c = 0; c < mChannels; ++c )
+	{
+		position = mPosition;
+		mResampler.run(mPadded[c].data(), position, count, mConverted.data() + c, mChannels);
+	}
+	mPosition = position;
+	push(mConverted.data(), count);
+
+	// The frames before the next output frame's taps are done with
+	size_t done = (size_t)mPosition.frame;
+	for( int c = 0; c < mChannels; ++c )
+		mPadded[c].erase(mPadded[c].begin(), mPadded[c].begin() + done);
+	mPosition.frame -= done;
+
+	mEnded = end;
+	return count;
+}
+
+void AudioStream::push(const float *frames, int count)
+{
+	int write = (mRingRead + mRingCount) % RING_FRAMES;
+	int first = count < RING_FRAMES - write ? count : RING_FRAMES - write;
+
+	memcpy(&mRing[(size_t)write * mChannels], frames, (size_t)first * mChannels * sizeof(float));
+	memcpy(mRing.data(), frames + (size_t)first * mChannels, (size_t)(count - first) * mChannels * sizeof(float));
+	mRingCount += count;
+}
@@ -2,75 +2,105 @@
 // By Frank Luna
 // August 24, 2004.
 #include "BackBuffer.h"
+#include <algorithm>
+#include <string.h>
 
-extern HINSTANCE g_hInst;
-
-
+#ifdef _WIN32
 BackBuffer::BackBuffer(HWND hWnd, int width, int height)
 {
-	// Save a copy of the main window handle.
-	mhWnd = hWnd;
+	mpGdiTarget = new GdiPresentTarget(hWnd);
+	init(width, height, mpGdiTarget);
+}
+#endif
 
-	// Get a handle to the device context associated with
-	// the window.
-	HDC hWndDC = GetDC(hWnd);
+BackBuffer::BackBuffer(int width, int height, PresentTarget *pTarget)
+{
+#ifdef _WIN32
+	mpGdiTarget = 0;
+#endif
+	init(width, height, pTarget);
+}
+
+void BackBuffer::init(int width, int height, PresentTarget *pTarget)
+{
+	mpTarget = pTarget;
 
 	// Save the backbuffer dimensions.
 	mWidth = width;
 	mHeight = height;
 
-	// Create system memory device context that is compatible
-	// with the window one.
-	mhDC = CreateCompatibleDC(hWndDC);
+	// Let the target provide the frame memory if it wants to
+	// (GDI renders straight into a DIB section), otherwise keep
+	// the frame in system memory.
+	if( !mpTarget || !mpTarget->createSurface(mSurface, width, height) )
+		mSurface.create(width, height);
 
-	// Create the backbuffer surface bitmap that is compatible
-	// with the window device context bitmap format. That is
-	// the surface we will render onto.
-	mhSurface = CreateCompatibleBitmap(hWndDC, width, height);
-
-	// Done with window DC.
-	ReleaseDC(hWnd, hWndDC);
+	mDamage.setBounds(width, height);
+	mDrawn.setBounds(width, height);
+	mDamage.addAll();
 
 	// At this point, the back buffer surface is uninitialized,
 	// so lets clear it to some non-zero value. Note that it
 	// needs to be non-zero. If it is zero then it will mess
 	// up our sprite blending logic.
 	reset();
+
+	// Count from the first frame on.
+	memset(&mStats, 0, sizeof(Stats));
 }
 
 void BackBuffer::reset()
 {
-	// Select the backbuffer bitmap into the DC.
-	mhOldObject = (HBITMAP)SelectObject(mhDC, mhSurface);
-
-	// Select a white brush.
-	HBRUSH white = (HBRUSH)GetStockObject(WHITE_BRUSH);
-	HBRUSH oldBrush = (HBRUSH)SelectObject(mhDC, white);
+	// Clear the damaged part of the backbuffer to white.
+	if( mDamage.isFull() )
+		mSurface.clear(0xFFFFFFFF);
+	else
+	{
+		for( int i = 0; i < mDamage.count(); ++i )
+		{
+			const RECT &rc = mDamage.rect(i);
+			for( int y = rc.top; y < rc.bottom; ++y )
+				std::fill(mSurface.row(y) + rc.left, mSurface.row(y) + rc.right, 0xFFFFFFFFu);
+		}
+	}
+
+	mStats.clearedPixels = mDamage.area();
+	mStats.totalCleared += mDamage.area();
+}
 
-	// Clear the backbuffer rectangle.
-	Rectangle(mhDC, 0, 0, mWidth, mHeight);
+void BackBuffer::invalidate()
+{
+	mDamage.addAll();
+}
 
-	// Restore the original brush.
-	SelectObject(mhDC, oldBrush);
+void BackBuffer::invalidate(int x, int y, int w, int h)
+{
+	mDamage.add(x, y, w, h);
 }
 
 BackBuffer::~BackBuffer()
 {
-	SelectObject(mhDC, mhOldObject);
-	DeleteObject(mhSurface);
-	DeleteDC(mhDC);
+	// Release the frame before the target that may own its memory.
+	mSurface.release();
+	delete mpTarget;
 }
 
 void BackBuffer::present()
 {
-	// Get a handle to the device context associated with
-	// the window.
-	HDC hWndDC = GetDC(mhWnd);
-
-	// Copy the backbuffer contents over to the
-	// window client area.
-	BitBlt(hWndDC, 0, 0, mWidth, mHeight, mhDC, 0, 0, SRCCOPY);
-
-	// Always free window DC when done.
-	ReleaseDC(mhWnd, hWndDC);
-}
\ No newline at end of file
+	// What changed is what was repaired plus what was drawn over.
+	mDamage.add(mDrawn);
+
+	if( mpTarget )
+		mpTarget->present(mSurface, mDamage);
+
+	++mStats.frames;
+	if( mDamage.isFull() )
+		++mStats.fullFrames;
+	mStats.presentedPixels = mDamage.area();
+	mStats.totalPresented += mDamage.area();
+
+	// Next frame repairs what this one drew.
+	mDamage.clear();
+	mDamage.add(mDrawn);
+	mDrawn.clear();
+}
@@ -0,0 +1,70 @@
+// Background.cpp
+// Horizontally scrolling backdrop.
+#include "Background.h"
+#include <math.h>
+#include <string.h>
+
+ScrollingBackground::ScrollingBackground() : mSpeed(0.0f), mOffset(0.0f)
+{
+}
+
+bool ScrollingBackground::load(const char *szFileName)
+{
+	mOffset = 0.0f;
+	return loadSurfaceFromFile(szFileName, mImage);
+}
+
+void ScrollingBackground::update(float dt)
+{
+	if( mImage.empty() )
+		return;
+
+	// Keep the offset small so it does not lose precision over a long game.
+	mOffset = fmodf(mOffset + mSpeed * dt, (float)mImage.width());
+	if( mOffset < 0.0f )
+		mOffset += mImage.width();
+}
+
+void ScrollingBackground::draw(Surface &target) const
+{
+	draw(target, 0, 0, target.width(), target.height());
+}
+
+void ScrollingBackground::draw(Surface &target, int x, int y, int w, int h) const
+{
+	if( mImage.empty() )
+		return;
+
+	// Clip against the target and the image rows.
+	if( x < 0 ) { w += x; x = 0; }
+	if( y < 0 ) { h += y; y = 0; }
+	if( x + w > target.width() ) w = target.width() - x;
+	if( y + h > target.height() ) h = target.height() - y;
+	if( y + h > mImage.height() ) h = mImage.height() - y;
+
+	if( w <= 0 || h <= 0 )
+		return;
+
+	// Image column shown at x.
+	int start = ((int)mOffset + x) % mImage.width();
+
+	for( int j = y; j < y + h; ++j )
+	{
+		const uint32_t *src = mImage.row(j);
+		uint32_t *dst = target.row(j) + x;
+
+		// Copy from the offset to the end of the image row, then wrap to
+		// its start until the target row is full.
+		int i = 0, srcX = start;
+		while( i < w )
+		{
+			int count = mImage.width() - srcX;
+			if( count > w - i )
+				count = w - i;
+
+			memcpy(dst + i, src + srcX, count * sizeof(uint32_t));
+			i += count;
+			srcX = 0;
+		}
+	}
+}
@@ -0,0 +1,2102 @@
+//-----------------------------------------------------------------------------
+// File: Benchmarks.cpp
+//
+// Desc: Micro benchmarks for the hot paths of the game, run from the
+//	   headless driver with "-bench name".
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Benchmarks Specific Includes
+//-----------------------------------------------------------------------------
+#include "Benchmarks.h"
+#include "Blitter.h"
+#include "ImageCache.h"
+#include "Background.h"
+#include "BackBuffer.h"
+#include "Sprite.h"
+#include "RenderQueue.h"
+#include "TileRenderer.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "ProjectilePool.h"
+#include "SlotMap.h"
+#include "Broadphase.h"
+#include "BoxOverlap.h"
+#include "SoundCache.h"
+#include "AudioMixer.h"
+#include "AudioEngine.h"
+#include "SpscQueue.h"
+#include "Resampler.h"
+#include "AudioStream.h"
+#include "BmpFile.h"
+#include "../Enemy.h"
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <math.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace
+{
+	//-------------------------------------------------------------------------
+	// Name : CBenchTimer (Class)
+	// Desc : Wall clock stopwatch.
+	//-------------------------------------------------------------------------
+	class CBenchTimer
+	{
+	public:
+		CBenchTimer() : m_Start(std::chrono::steady_clock::now()) { }
+
+		double Seconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point m_Start;
+	};
+
+	//-------------------------------------------------------------------------
+	// Name : CBenchRandom (Class)
+	// Desc : Small deterministic generator so every run draws the same scene.
+	//-------------------------------------------------------------------------
+	class CBenchRandom
+	{
+	public:
+		CBenchRandom(unsigned int uSeed) : m_uState(uSeed) { }
+
+		unsigned int Next()
+		{
+			m_uState ^= m_uState << 13;
+			m_uState ^= m_uState >> 17;
+			m_uState ^= m_uState << 5;
+			return m_uState;
+		}
+
+		int Range(int iMin, int iMax) { return iMin + (int)(Next() % (unsigned int)(iMax - iMin)); }
+
+	private:
+		unsigned int m_uState;
+	};
+
+	//-------------------------------------------------------------------------
+	// Name : MakeSpriteImages ()
+	// Desc : Builds an image / mask pair shaped like the game sprites: an
+	//		opaque ellipse on a black (image) / white (mask) background.
+	//-------------------------------------------------------------------------
+	void MakeSpriteImages(Surface& Image, Surface& Mask, int iWidth, int iHeight, CBenchRandom& Rand)
+	{
+		Image.create(iWidth, iHeight);
+		Mask.create(iWidth, iHeight);
+
+		for (int y = 0; y < iHeight; y++)
+		{
+			for (int x = 0; x < iWidth; x++)
+			{
+				float dx = (x - iWidth * 0.5f) / (iWidth * 0.5f);
+				float dy = (y - iHeight * 0.5f) / (iHeight * 0.5f);
+				bool bInside = dx * dx + dy * dy <= 1.0f;
+
+				Image.row(y)[x] = bInside ? (0xFF000000u | (Rand.Next() & 0xFFFFFF)) : 0xFF000000u;
+				Mask.row(y)[x] = bInside ? 0xFF000000u : 0xFFFFFFFFu;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : MakeBackground ()
+	// Desc : Writes a noise bitmap to a temporary file and loads it into the
+	//		background the way the game does. DIB receives the bottom-up
+	//		32 bpp rows of the file.
+	//-------------------------------------------------------------------------
+	bool MakeBackground(ScrollingBackground& Background, std::vector<uint32_t>& DIB, int iWidth, int iHeight)
+	{
+		CBenchRandom Rand(777);
+		DIB.resize((size_t)iWidth * iHeight);
+		for (size_t i = 0; i < DIB.size(); i++) DIB[i] = Rand.Next() & 0xFFFFFF;
+
+		const char* szFile = "bench_background.bmp";
+		FILE* pFile = fopen(szFile, "wb");
+		if (!pFile)
+		{
+			printf("cannot write %s\n", szFile);
+			return false;
+		}
+		unsigned char Header[54] = { 'B', 'M' };
+		unsigned int Fields[][2] = { { 2, 54 + (unsigned int)DIB.size() * 4 }, { 10, 54 }, { 14, 40 }, { 18, (unsigned int)iWidth },
+									 { 22, (unsigned int)iHeight }, { 26, 1 | (32 << 16) } };
+		for (size_t f = 0; f < sizeof(Fields) / sizeof(Fields[0]); f++)
+			for (int b = 0; b < 4; b++) Header[Fields[f][0] + b] = (unsigned char)(Fields[f][1] >> (8 * b));
+		fwrite(Header, 1, sizeof(Header), pFile);
+		fwrite(&DIB[0], sizeof(uint32_t), DIB.size(), pFile);
+		fclose(pFile);
+
+		bool bLoaded = Background.load(szFile);
+		remove(szFile);
+		if (!bLoaded) printf("cannot load %s\n", szFile);
+
+		return bLoaded;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchBlit ()
+	// Desc : Masked sprite compositing, every kernel against the scalar one.
+	//-------------------------------------------------------------------------
+	bool BenchBlit(unsigned long ulIterations)
+	{
+		const int	SPRITE_COUNT = 600;
+		const int	Sizes[3][2] = { { 37, 30 }, { 100, 143 }, { 128, 128 } };
+
+		CBenchRandom Rand(12345);
+		Surface Images[3], Masks[3];
+		for (int i = 0; i < 3; i++) MakeSpriteImages(Images[i], Masks[i], Sizes[i][0], Sizes[i][1], Rand);
+
+		// A frame full of sprites, some hanging over the edges
+		struct SDraw { int iImage, x, y; };
+		std::vector<SDraw> Draws(SPRITE_COUNT);
+		unsigned long long ullPixels = 0;
+		for (int i = 0; i < SPRITE_COUNT; i++)
+		{
+			Draws[i].iImage = i % 10 == 0 ? 1 + (i / 10) % 2 : 0;
+			Draws[i].x = Rand.Range(-64, 1200);
+			Draws[i].y = Rand.Range(-64, 900);
+			ullPixels += (unsigned long long)Sizes[Draws[i].iImage][0] * Sizes[Draws[i].iImage][1];
+		}
+
+		Surface Frame(1200, 900), Reference(1200, 900);
+		BlitKernel eDefault = getBlitKernel();
+		double dScalarTime = 0;
+		bool bOk = true;
+
+		printf("blit: %d sprites per frame, %lu frames\n", SPRITE_COUNT, ulIterations);
+
+		for (int k = 0; k < BLIT_KERNEL_COUNT; k++)
+		{
+			BlitKernel eKernel = (BlitKernel)k;
+			if (!isBlitKernelSupported(eKernel))
+			{
+				printf("  %-8s not supported on this CPU\n", getBlitKernelName(eKernel));
+				continue;
+			}
+			setBlitKernel(eKernel);
+
+			CBenchTimer Timer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				Frame.clear(0xFFFFFFFF);
+				for (size_t i = 0; i < Draws.size(); i++)
+				{
+					const Surface& Image = Images[Draws[i].iImage];
+					blitMasked(Frame, Draws[i].x, Draws[i].y, Image, Masks[Draws[i].iImage], 0, 0, Image.width(), Image.height());
+				}
+			}
+			double dTime = Timer.Seconds();
+
+			// The scalar kernel is the reference, every other one must match it
+			bool bMatch = true;
+			if (eKernel == BLIT_SCALAR)
+			{
+				memcpy(Reference.pixels(), Frame.pixels(), 1200 * 900 * sizeof(uint32_t));
+				dScalarTime = dTime;
+			}
+			else
+				bMatch = memcmp(Reference.pixels(), Frame.pixels(), 1200 * 900 * sizeof(uint32_t)) == 0;
+
+			bOk = bOk && bMatch;
+			printf("  %-8s %8.3f ms/frame %9.1f Mpixel/s  x%.2f  %s\n", getBlitKernelName(eKernel),
+				   dTime * 1000.0 / ulIterations, ullPixels * ulIterations / dTime / 1e6,
+				   dTime > 0 ? dScalarTime / dTime : 0.0, bMatch ? "ok" : "MISMATCH");
+		}
+
+		setBlitKernel(eDefault);
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchSpans ()
+	// Desc : Color keyed sprites, the per pixel key test against the opaque
+	//		runs found at load time.
+	//-------------------------------------------------------------------------
+	bool BenchSpans(unsigned long ulIterations)
+	{
+		const int		SPRITE_COUNT = 600;
+		const int		Sizes[3][2] = { { 37, 30 }, { 100, 143 }, { 128, 128 } };
+		const uint32_t	KEY = makePixel(0xFF, 0x00, 0xFF);
+
+		// Same shapes as the masked benchmark, with the key color around them
+		CBenchRandom Rand(12345);
+		Surface Images[3], Masks[3];
+		SpanList Spans[3];
+		for (int i = 0; i < 3; i++)
+		{
+			MakeSpriteImages(Images[i], Masks[i], Sizes[i][0], Sizes[i][1], Rand);
+			for (int y = 0; y < Images[i].height(); y++)
+				for (int x = 0; x < Images[i].width(); x++)
+					if (Masks[i].row(y)[x] != 0xFF000000u) Images[i].row(y)[x] = KEY;
+
+			Spans[i].build(Images[i], KEY);
+		}
+
+		struct SDraw { int iImage, x, y; };
+		std::vector<SDraw> Draws(SPRITE_COUNT);
+		for (int i = 0; i < SPRITE_COUNT; i++)
+		{
+			Draws[i].iImage = i % 10 == 0 ? 1 + (i / 10) % 2 : 0;
+			Draws[i].x = Rand.Range(-64, 1200);
+			Draws[i].y = Rand.Range(-64, 900);
+		}
+
+		Surface Frame(1200, 900), Reference(1200, 900);
+		double dTimes[2];
+
+		printf("spans: %d sprites per frame, %lu frames\n", SPRITE_COUNT, ulIterations);
+
+		for (int m = 0; m < 2; m++)
+		{
+			Surface& Target = m == 0 ? Reference : Frame;
+
+			CBenchTimer Timer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				Target.clear(0xFFFFFFFF);
+				for (size_t i = 0; i < Draws.size(); i++)
+				{
+					const Surface& Image = Images[Draws[i].iImage];
+					int x = Draws[i].x, y = Draws[i].y, srcX = 0, srcY = 0, w = Image.width(), h = Image.height();
+
+					if (m == 1)
+					{
+						blitSpans(Target, x, y, Image, Spans[Draws[i].iImage], srcX, srcY, w, h);
+						continue;
+					}
+
+					// What the sprite used to do, test the key on every pixel
+					if (!clipBlit(Target, Image.width(), Image.height(), x, y, srcX, srcY, w, h)) continue;
+					for (int j = 0; j < h; j++)
+					{
+						uint32_t* pDst = Target.row(y + j) + x;
+						const uint32_t* pSrc = Image.row(srcY + j) + srcX;
+						for (int k = 0; k < w; k++)
+							if (pSrc[k] != KEY) pDst[k] = pSrc[k];
+					}
+				}
+			}
+			dTimes[m] = Timer.Seconds();
+		}
+
+		size_t nSpans = Spans[0].spanCount() + Spans[1].spanCount() + Spans[2].spanCount();
+		bool bMatch = memcmp(Reference.pixels(), Frame.pixels(), 1200 * 900 * sizeof(uint32_t)) == 0;
+
+		printf("  key test %8.3f ms/frame\n", dTimes[0] * 1000.0 / ulIterations);
+		printf("  spans    %8.3f ms/frame  x%.2f  %s (%u runs in %d rows)\n", dTimes[1] * 1000.0 / ulIterations,
+			   dTimes[1] > 0 ? dTimes[0] / dTimes[1] : 0.0, bMatch ? "ok" : "MISMATCH",
+			   (unsigned int)nSpans, Spans[0].height() + Spans[1].height() + Spans[2].height());
+
+		return bMatch;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchAssets ()
+	// Desc : Getting the images of a new sprite, decoding the bitmaps every
+	//		time against the image cache. Runs
+	//		on the game data, from the GameFramework folder.
+	//-------------------------------------------------------------------------
+	bool BenchAssets(unsigned long ulIterations)
+	{
+		const char* Files[][2] =
+		{
+			{ "Data/bullet.bmp",	 "Data/bmask.bmp" },
+			{ "Data/PlaneImg.bmp",	 "Data/PlaneMask.bmp" },
+			{ "Data/leftRotate.bmp", "Data/leftPlaneMask.bmp" },
+			{ "Data/downRotate.bmp", "Data/downPlaneMask.bmp" },
+		};
+		const int FILE_COUNT = sizeof(Files) / sizeof(Files[0]);
+
+		Surface Probe;
+		if (!loadSurfaceFromFile(Files[0][0], Probe))
+		{
+			printf("assets: %s not found, run from the GameFramework folder\n", Files[0][0]);
+			return true;
+		}
+
+		printf("assets: %lu sprites\n", ulIterations);
+
+		// Every sprite decodes its own images, like the game used to
+		CBenchTimer DiskTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Surface Image, Mask;
+			loadSurfaceFromFile(Files[n % FILE_COUNT][0], Image);
+			loadSurfaceFromFile(Files[n % FILE_COUNT][1], Mask);
+		}
+		double dDiskTime = DiskTimer.Seconds();
+
+		ImageCache Cache;
+		CBenchTimer CacheTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			ImageHandle Shot = Cache.load(Files[n % FILE_COUNT][0], Files[n % FILE_COUNT][1]);
+		}
+		double dCacheTime = CacheTimer.Seconds();
+
+		printf("  decode   %10.3f us/sprite\n", dDiskTime * 1e6 / ulIterations);
+		printf("  cache    %10.3f us/sprite  x%.0f  (%lu hits, %lu misses, %u images, %u KB resident)\n",
+			   dCacheTime * 1e6 / ulIterations, dCacheTime > 0 ? dDiskTime / dCacheTime : 0.0,
+			   Cache.hits(), Cache.misses(), (unsigned int)Cache.size(), (unsigned int)(Cache.residentBytes() / 1024));
+
+		return Cache.misses() == (unsigned long)(ulIterations < (unsigned long)FILE_COUNT ? ulIterations : FILE_COUNT);
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchBackground ()
+	// Desc : The scrolling backdrop, painting the whole image twice from its
+	//		bottom-up DIB copy against the wraparound blit of the window.
+	//-------------------------------------------------------------------------
+	bool BenchBackground(unsigned long ulIterations)
+	{
+		const int IMAGE_WIDTH = 1440, IMAGE_HEIGHT = 900;
+		const int VIEW_WIDTH = 1280, VIEW_HEIGHT = 900;
+
+		// Bottom-up, alpha-less copy of the image, as CImageFile keeps it
+		std::vector<uint32_t> DIB;
+		ScrollingBackground Background;
+		if (!MakeBackground(Background, DIB, IMAGE_WIDTH, IMAGE_HEIGHT)) return false;
+
+		Background.setSpeed(5.0f / 0.15f);
+
+		Surface Frame(VIEW_WIDTH, VIEW_HEIGHT), Reference(VIEW_WIDTH, VIEW_HEIGHT);
+		double dTimes[2] = { 0, 0 };
+		bool bOk = true;
+
+		printf("background: %dx%d image, %dx%d view, %lu frames\n", IMAGE_WIDTH, IMAGE_HEIGHT, VIEW_WIDTH, VIEW_HEIGHT, ulIterations);
+
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Background.update(1.0f / 60.0f);
+			int iOffset = (int)Background.offset();
+
+			// Old way, the image converted and painted twice, side by side
+			CBenchTimer OldTimer;
+			for (int iCopy = 0; iCopy < 2; iCopy++)
+			{
+				int x = iCopy * IMAGE_WIDTH - iOffset, srcX = 0, w = IMAGE_WIDTH;
+				if (x < 0) { srcX = -x; w += x; x = 0; }
+				if (x + w > VIEW_WIDTH) w = VIEW_WIDTH - x;
+
+				for (int y = 0; y < VIEW_HEIGHT && w > 0; y++)
+				{
+					const uint32_t* pSrc = &DIB[(size_t)(IMAGE_HEIGHT - 1 - y) * IMAGE_WIDTH + srcX];
+					uint32_t* pDst = Reference.row(y) + x;
+					for (int i = 0; i < w; i++) pDst[i] = 0xFF000000u | pSrc[i];
+				}
+			}
+			dTimes[0] += OldTimer.Seconds();
+
+			CBenchTimer NewTimer;
+			Background.draw(Frame);
+			dTimes[1] += NewTimer.Seconds();
+
+			bOk = bOk && memcmp(Reference.pixels(), Frame.pixels(), (size_t)VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint32_t)) == 0;
+		}
+
+		printf("  paint x2 %8.3f ms/frame\n", dTimes[0] * 1000.0 / ulIterations);
+		printf("  window   %8.3f ms/frame  x%.2f  %s\n", dTimes[1] * 1000.0 / ulIterations,
+			   dTimes[1] > 0 ? dTimes[0] / dTimes[1] : 0.0, bOk ? "ok" : "MISMATCH");
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchDirty ()
+	// Desc : Frames of moving sprites, presenting the dirty rectangles
+	//		against clearing and presenting the whole frame, first over a
+	//		still background, then over one scrolling at the game's speed.
+	//		Every whole pixel the backdrop scrolls repaints the frame, like
+	//		CGameRenderer::Draw does. Both back buffers must hold the same
+	//		picture.
+	//-------------------------------------------------------------------------
+	bool BenchDirty(unsigned long ulIterations)
+	{
+		const int	VIEW_WIDTH = 1280, VIEW_HEIGHT = 900;
+		const int	SHIP_COUNT = 5, BULLET_COUNT = 40;
+		const float	SCROLL_SPEED = 5.0f / 0.15f;		// As in CGameRenderer
+		const float	FRAME_TIME = 1.0f / 120.0f;
+
+		std::vector<uint32_t> DIB;
+		ScrollingBackground Background;
+		if (!MakeBackground(Background, DIB, 1440, VIEW_HEIGHT)) return false;
+
+		// The images of a ship and a bullet, as the cache would hold them
+		CBenchRandom Rand(4242);
+		std::shared_ptr<SpriteImage> Ship = std::make_shared<SpriteImage>(), Bullet = std::make_shared<SpriteImage>();
+		MakeSpriteImages(Ship->image, Ship->mask, 100, 143, Rand);
+		MakeSpriteImages(Bullet->image, Bullet->mask, 37, 30, Rand);
+
+		printf("dirty: %d ships and %d bullets, %dx%d view, %lu frames\n", SHIP_COUNT, BULLET_COUNT, VIEW_WIDTH, VIEW_HEIGHT, ulIterations);
+
+		bool bOk = true;
+		for (int s = 0; s < 2; s++)
+		{
+			bool bScroll = s == 1;
+			Background.setSpeed(bScroll ? SCROLL_SPEED : 0.0f);
+			int iBackgroundX = (int)Background.offset();
+
+			BackBuffer	Dirty(VIEW_WIDTH, VIEW_HEIGHT, new NullPresentTarget());
+			BackBuffer	Full(VIEW_WIDTH, VIEW_HEIGHT, new NullPresentTarget());
+			BackBuffer*	pBuffers[2] = { &Full, &Dirty };
+
+			struct SObject { float x, y, vx, vy; bool bShip; };
+			std::vector<SObject> Objects;
+			for (int i = 0; i < SHIP_COUNT + BULLET_COUNT; i++)
+			{
+				SObject Object = { (float)Rand.Range(0, VIEW_WIDTH), (float)Rand.Range(0, VIEW_HEIGHT),
+								   (float)Rand.Range(-6, 7), (float)Rand.Range(-3, 4), i < SHIP_COUNT };
+				Objects.push_back(Object);
+			}
+
+			double dTimes[2] = { 0, 0 };
+			bool bSame = true;
+
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				for (size_t i = 0; i < Objects.size(); i++)
+				{
+					SObject& Object = Objects[i];
+					Object.x += Object.vx;
+					Object.y += Object.vy;
+					if (Object.x < -50 || Object.x > VIEW_WIDTH + 50) Object.vx = -Object.vx;
+					if (Object.y < -50 || Object.y > VIEW_HEIGHT + 50) Object.vy = -Object.vy;
+				}
+
+				Background.update(FRAME_TIME);
+				bool bScrolled = (int)Background.offset() != iBackgroundX;
+				iBackgroundX = (int)Background.offset();
+
+				for (int b = 0; b < 2; b++)
+				{
+					BackBuffer& Buffer = *pBuffers[b];
+					Sprite ShipSprite(Ship), BulletSprite(Bullet);
+					ShipSprite.setBackBuffer(&Buffer);
+					BulletSprite.setBackBuffer(&Buffer);
+
+					CBenchTimer Timer;
+					if (&Buffer == &Full || bScrolled) Buffer.invalidate();
+					Buffer.reset();
+
+					const DirtyRegion& Damage = Buffer.damage();
+					for (int r = 0; r < Damage.count(); r++)
+					{
+						const RECT& rc = Damage.rect(r);
+						Background.draw(Buffer.getSurface(), rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
+					}
+
+					for (size_t i = 0; i < Objects.size(); i++)
+					{
+						Sprite& Object = Objects[i].bShip ? ShipSprite : BulletSprite;
+						Object.mPosition = Vec2(Objects[i].x, Objects[i].y);
+						Object.draw();
+					}
+
+					Buffer.present();
+					dTimes[b] += Timer.Seconds();
+				}
+
+				bSame = bSame && memcmp(Full.getSurface().pixels(), Dirty.getSurface().pixels(), (size_t)VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint32_t)) == 0;
+			}
+
+			printf("  %s\n", bScroll ? "scrolling background" : "still background");
+			for (int b = 0; b < 2; b++)
+			{
+				const BackBuffer::Stats& Stats = pBuffers[b]->stats();
+				printf("  %-8s %8.3f ms/frame  %8llu cleared %8llu presented pixels/frame  %lu/%lu full",
+					   b ? "dirty" : "full", dTimes[b] * 1000.0 / ulIterations,
+					   Stats.totalCleared / Stats.frames, Stats.totalPresented / Stats.frames, Stats.fullFrames, Stats.frames);
+				printf(b ? "  x%.2f  %s\n" : "\n", dTimes[1] > 0 ? dTimes[0] / dTimes[1] : 0.0, bSame ? "ok" : "MISMATCH");
+			}
+			bOk = bOk && bSame;
+		}
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchTiles ()
+	// Desc : A 1200x900 frame packed with sprites, drawn by the render queue
+	//		on one thread, then by the tile renderer on 1 to N threads, and
+	//		with the thread count changed between frames. Every tiled frame
+	//		must match the single threaded one.
+	//-------------------------------------------------------------------------
+	bool BenchTiles(unsigned long ulIterations)
+	{
+		const int	VIEW_WIDTH = 1200, VIEW_HEIGHT = 900;
+		const int	SPRITE_COUNT = 3000;
+		const int	Sizes[3][2] = { { 37, 30 }, { 100, 143 }, { 128, 128 } };
+
+		CBenchRandom Rand(2024);
+		std::shared_ptr<SpriteImage> Images[4];
+		for (int i = 0; i < 4; i++)
+		{
+			Images[i] = std::make_shared<SpriteImage>();
+			Images[i]->id = i + 1;
+			MakeSpriteImages(Images[i]->image, Images[i]->mask, Sizes[i % 3][0], Sizes[i % 3][1], Rand);
+		}
+
+		// The last image is color keyed, black around the ellipse
+		Images[3]->mask.release();
+		Images[3]->transparentColor = 0xFF000000u;
+		Images[3]->spans.build(Images[3]->image, Images[3]->transparentColor);
+
+		struct SDraw { int iImage, iLayer; Vec2 Position; };
+		std::vector<SDraw> Draws(SPRITE_COUNT);
+		for (int i = 0; i < SPRITE_COUNT; i++)
+		{
+			Draws[i].iImage = Rand.Range(0, 4);
+			Draws[i].iLayer = Rand.Range(0, 3);
+			Draws[i].Position = Vec2((float)Rand.Range(-64, VIEW_WIDTH + 64), (float)Rand.Range(-64, VIEW_HEIGHT + 64));
+		}
+
+		BackBuffer	Buffer(VIEW_WIDTH, VIEW_HEIGHT, new NullPresentTarget());
+		Surface		Reference(VIEW_WIDTH, VIEW_HEIGHT);
+		RenderQueue	Queue;
+		double		dSingleTime = 0;
+		bool		bOk = true;
+		int			iMaxThreads = TileRenderer::hardwareThreads();
+		if (iMaxThreads > TileRenderer::MAX_THREADS) iMaxThreads = TileRenderer::MAX_THREADS;
+
+		printf("tiles: %d sprites per frame, %dx%d, %lu frames, %d hardware threads\n",
+			   SPRITE_COUNT, VIEW_WIDTH, VIEW_HEIGHT, ulIterations, TileRenderer::hardwareThreads());
+
+		// Thread count 0 is the render queue itself
+		for (int iThreads = 0; iThreads <= iMaxThreads; iThreads++)
+		{
+			TileRenderer Tiles(iThreads ? iThreads : 1);
+
+			CBenchTimer Timer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				Buffer.invalidate();
+				Buffer.reset();
+
+				for (size_t i = 0; i < Draws.size(); i++)
+					Queue.add(Images[Draws[i].iImage], Draws[i].Position, Draws[i].iLayer);
+
+				if (iThreads)
+					Tiles.submit(Queue, Buffer);
+				else
+					Queue.submit(Buffer);
+
+				Buffer.present();
+			}
+			double dTime = Timer.Seconds();
+
+			bool bMatch = true;
+			if (!iThreads)
+			{
+				memcpy(Reference.pixels(), Buffer.getSurface().pixels(), (size_t)VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint32_t));
+				dSingleTime = dTime;
+				printf("  queue     %8.3f ms/frame\n", dTime * 1000.0 / ulIterations);
+				continue;
+			}
+
+			bMatch = memcmp(Reference.pixels(), Buffer.getSurface().pixels(), (size_t)VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint32_t)) == 0;
+			bOk = bOk && bMatch;
+			printf("  %2d thread%s %8.3f ms/frame  x%.2f  %s\n", iThreads, iThreads > 1 ? "s" : " ",
+				   dTime * 1000.0 / ulIterations, dTime > 0 ? dSingleTime / dTime : 0.0, bMatch ? "ok" : "MISMATCH");
+		}
+
+		// One renderer whose thread count changes between frames, the new
+		// workers must wait for the next frame and not the ones before
+		TileRenderer Tiles(2);
+		bool bChangeOk = true;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Tiles.setThreadCount(2 + (int)(n % (TileRenderer::MAX_THREADS - 1)));
+			Buffer.invalidate();
+			Buffer.reset();
+
+			for (size_t i = 0; i < Draws.size(); i++)
+				Queue.add(Images[Draws[i].iImage], Draws[i].Position, Draws[i].iLayer);
+			Tiles.submit(Queue, Buffer);
+			Buffer.present();
+
+			bChangeOk = bChangeOk && memcmp(Reference.pixels(), Buffer.getSurface().pixels(), (size_t)VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint32_t)) == 0;
+		}
+		printf("  2 to %d threads, changed every frame  %s\n", (int)TileRenderer::MAX_THREADS, bChangeOk ? "ok" : "MISMATCH");
+		bOk = bOk && bChangeOk;
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchRotations ()
+	// Desc : Turning a ship: baking the rotation sets, then a heading change
+	//		decoding the bitmaps of the heading against a lookup in the set.
+	//		The quarter turns must be exact copies of the source pixels.
+	//		The game bakes the 4 quarter turns, 32 and 64 frames are what
+	//		a freely turning ship would cost.
+	//-------------------------------------------------------------------------
+	bool BenchRotations(unsigned long ulIterations)
+	{
+		const int	Counts[3] = { 4, 32, 64 };
+		const int	WIDTH = 100, HEIGHT = 143;
+
+		CBenchRandom Rand(99);
+		SpriteImage Source;
+		MakeSpriteImages(Source.image, Source.mask, WIDTH, HEIGHT, Rand);
+
+		printf("rotations: %dx%d sprite, %lu heading changes\n", WIDTH, HEIGHT, ulIterations);
+
+		bool bOk = true;
+		for (int c = 0; c < 3; c++)
+		{
+			std::shared_ptr<RotationSet> Set = std::make_shared<RotationSet>();
+			CBenchTimer BakeTimer;
+			for (int i = 0; i < Counts[c]; i++)
+			{
+				std::shared_ptr<SpriteImage> Frame = std::make_shared<SpriteImage>();
+				bakeRotation(Source, 2 * PI * i / Counts[c], *Frame);
+				Set->frames.push_back(Frame);
+			}
+			double dBakeTime = BakeTimer.Seconds();
+
+			// A quarter turn moves source pixel (x, y) to (y, w - 1 - x)
+			const SpriteImage& Quarter = *Set->frame(PI / 2);
+			bool bExact = Quarter.image.width() == HEIGHT && Quarter.image.height() == WIDTH;
+			for (int y = 0; bExact && y < WIDTH; y++)
+				for (int x = 0; bExact && x < HEIGHT; x++)
+					bExact = Quarter.image.row(y)[x] == Source.image.row(x)[WIDTH - 1 - y] &&
+							 Quarter.mask.row(y)[x] == Source.mask.row(x)[WIDTH - 1 - y];
+			bOk = bOk && bExact;
+
+			printf("  %2d frames  baked in %8.3f ms, %u KB  %s\n", Counts[c], dBakeTime * 1000.0,
+				   (unsigned int)(Set->bytes() / 1024), bExact ? "ok" : "MISMATCH");
+
+			if (c == 0)
+			{
+				// Looking up every angle, the way a turning ship does
+				const SpriteImage* pLast = NULL;
+				unsigned long ulChanges = 0;
+				CBenchTimer LookupTimer;
+				for (unsigned long n = 0; n < ulIterations; n++)
+				{
+					const SpriteImage* pFrame = Set->frame(n * 0.01).get();
+					if (pFrame != pLast) ulChanges++;
+					pLast = pFrame;
+				}
+				double dLookupTime = LookupTimer.Seconds();
+				printf("  lookup     %10.3f us/heading  (%lu frame changes)\n", dLookupTime * 1e6 / ulIterations, ulChanges);
+			}
+		}
+
+		// The hand drawn headings the game decoded on every turn
+		const char* Files[][2] =
+		{
+			{ "Data/leftRotate.bmp",  "Data/leftPlaneMask.bmp" },
+			{ "Data/downRotate.bmp",  "Data/downPlaneMask.bmp" },
+			{ "Data/rightRotate.bmp", "Data/rightPlaneMask.bmp" },
+			{ "Data/PlaneImg.bmp",	  "Data/PlaneMask.bmp" },
+		};
+
+		Surface Probe;
+		if (!loadSurfaceFromFile(Files[0][0], Probe))
+		{
+			printf("  decode     skipped, Data not found (run from the GameFramework folder)\n");
+			return bOk;
+		}
+
+		CBenchTimer DecodeTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Surface Image, Mask;
+			loadSurfaceFromFile(Files[n % 4][0], Image);
+			loadSurfaceFromFile(Files[n % 4][1], Mask);
+		}
+		printf("  decode     %10.3f us/heading\n", DecodeTimer.Seconds() * 1e6 / ulIterations);
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : ProcessCpuSeconds ()
+	// Desc : CPU time used by the process so far, on every core.
+	//-------------------------------------------------------------------------
+	double ProcessCpuSeconds()
+	{
+#ifdef _WIN32
+		FILETIME Creation, Exit, Kernel, User;
+		if (!GetProcessTimes(GetCurrentProcess(), &Creation, &Exit, &Kernel, &User)) return 0;
+		unsigned long long ul100ns = ((unsigned long long)Kernel.dwHighDateTime << 32 | Kernel.dwLowDateTime) +
+									 ((unsigned long long)User.dwHighDateTime << 32 | User.dwLowDateTime);
+		return ul100ns * 1e-7;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchPacer ()
+	// Desc : Waiting for 120 Hz frame deadlines by spinning on the clock (the
+	//		old frame lock), by sleeping only and by sleeping then spinning.
+	//		Reports how late the frames start and the CPU the wait costs.
+	//-------------------------------------------------------------------------
+	bool BenchPacer(unsigned long ulIterations)
+	{
+		const double	FRAME_TIME = 1.0 / 120.0;
+		const double	WORK_TIME = 0.002;		// Spun every frame, like a light frame would
+		const char*		Names[3] = { "spin", "sleep", "pacer" };
+
+		printf("pacer: %lu frames at %.0f Hz per method\n", ulIterations, 1.0 / FRAME_TIME);
+
+		for (int m = 0; m < 3; m++)
+		{
+			FramePacer Pacer;
+			std::vector<double> Late;
+			Late.reserve(ulIterations);
+
+			double dCpuStart = ProcessCpuSeconds();
+			double dStart = FramePacer::now();
+			double dDeadline = dStart;
+
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				FramePacer::spinUntil(FramePacer::now() + WORK_TIME);
+
+				dDeadline += FRAME_TIME;
+				if (m == 0)		 FramePacer::spinUntil(dDeadline);
+				else if (m == 1) Pacer.sleepUntil(dDeadline);
+				else			 Pacer.waitUntil(dDeadline);
+
+				Late.push_back(FramePacer::now() - dDeadline);
+			}
+
+			double dWall = FramePacer::now() - dStart;
+			double dCpu = ProcessCpuSeconds() - dCpuStart;
+
+			std::sort(Late.begin(), Late.end());
+			double dMean = 0;
+			for (size_t i = 0; i < Late.size(); i++) dMean += Late[i];
+			dMean /= Late.size() ? Late.size() : 1;
+			double dP99 = Late.empty() ? 0 : Late[Late.size() * 99 / 100];
+			double dMax = Late.empty() ? 0 : Late.back();
+
+			printf("  %-5s  late mean %7.3f ms, p99 %7.3f ms, max %7.3f ms  cpu %5.1f%%",
+				   Names[m], dMean * 1000.0, dP99 * 1000.0, dMax * 1000.0, dWall > 0 ? dCpu * 100.0 / dWall : 0.0);
+			if (m == 2) printf("  (margin %.3f ms, %lu sleeps)", Pacer.margin() * 1000.0, Pacer.sleepCount());
+			printf("\n");
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchHistogram ()
+	// Desc : Recording frame times, into the old 50 sample FIFO that was
+	//		moved and summed every frame against the log bucket histogram.
+	//		The percentiles of the histogram are checked against the exact
+	//		ones of the sorted samples.
+	//-------------------------------------------------------------------------
+	bool BenchHistogram(unsigned long ulIterations)
+	{
+		const int	FIFO_SIZE = 50;
+		unsigned long ulSamples = ulIterations * 1000;
+
+		// 60 Hz frames with some noise, one hitch of 20 to 60 ms in 200
+		CBenchRandom Rand(60);
+		std::vector<double> Samples(ulSamples);
+		for (unsigned long i = 0; i < ulSamples; i++)
+		{
+			Samples[i] = 0.0160 + Rand.Range(0, 1500) * 1e-6;
+			if (Rand.Range(0, 200) == 0) Samples[i] = Rand.Range(20, 60) * 1e-3;
+		}
+
+		printf("histogram: %lu frame times\n", ulSamples);
+
+		float FrameTime[FIFO_SIZE] = { 0 };
+		int iFifoCount = 0;
+		float fAverage = 0;
+		CBenchTimer FifoTimer;
+		for (unsigned long i = 0; i < ulSamples; i++)
+		{
+			memmove(&FrameTime[1], FrameTime, (FIFO_SIZE - 1) * sizeof(float));
+			FrameTime[0] = (float)Samples[i];
+			if (iFifoCount < FIFO_SIZE) iFifoCount++;
+
+			fAverage = 0;
+			for (int j = 0; j < iFifoCount; j++) fAverage += FrameTime[j];
+			fAverage /= iFifoCount;
+		}
+		double dFifoTime = FifoTimer.Seconds();
+
+		FrameProfiler Profiler;
+		CBenchTimer HistogramTimer;
+		for (unsigned long i = 0; i < ulSamples; i++)
+			Profiler.endFrame(Samples[i]);
+		double dHistogramTime = HistogramTimer.Seconds();
+
+		printf("  fifo       %8.2f ns/frame  (average %.2f ms)\n", dFifoTime * 1e9 / ulSamples, fAverage * 1000.0);
+		printf("  histogram  %8.2f ns/frame  x%.1f\n", dHistogramTime * 1e9 / ulSamples,
+			   dHistogramTime > 0 ? dFifoTime / dHistogramTime : 0.0);
+
+		// Each percentile must be within a bucket (1/16) of the exact one
+		const FrameHistogram& Times = Profiler.total(FrameProfiler::PHASE_FRAME);
+		std::sort(Samples.begin(), Samples.end());
+
+		bool bOk = Times.count() == ulSamples;
+		const double Percentiles[] = { 50, 95, 99, 99.9, 100 };
+		for (size_t p = 0; p < sizeof(Percentiles) / sizeof(Percentiles[0]); p++)
+		{
+			size_t iRank = (size_t)ceil(Percentiles[p] / 100.0 * ulSamples);
+			double dExact = Samples[iRank > 0 ? iRank - 1 : 0];
+			double dBinned = Times.percentile(Percentiles[p]);
+			double dError = dExact > 0 ? fabs(dBinned - dExact) / dExact : 0.0;
+			bool bClose = dError <= 1.0 / FrameHistogram::SUB_BUCKETS;
+			bOk = bOk && bClose;
+			printf("  p%-5g     exact %8.3f ms, histogram %8.3f ms  %5.2f%%  %s\n", Percentiles[p], dExact * 1000.0,
+				   dBinned * 1000.0, dError * 100.0, bClose ? "ok" : "OFF");
+		}
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchProjectiles ()
+	// Desc : A bullet hell of shots, spawned, moved and culled each step in
+	//		a std::list of shot objects like the old Bullet lists against
+	//		the structure of arrays pool. Both must end with the same shots.
+	//-------------------------------------------------------------------------
+	struct SBenchShot
+	{
+		float x, y, vx, vy, fLifetime;
+		bool Dead(float fRight, float fBottom) const
+		{
+			return fLifetime <= 0 || x < 0 || x > fRight || y < 0 || y > fBottom;
+		}
+	};
+
+	bool BenchProjectiles(unsigned long ulIterations)
+	{
+		const int	SPAWNS_PER_STEP = 48;
+		const int	STEPS = 120;
+		const float	DT = 1.0f / 120.0f;
+		const float	RIGHT = 1440.0f, BOTTOM = 900.0f;
+		unsigned long ulSteps = ulIterations * STEPS;
+
+		// The same spawns for both
+		CBenchRandom Rand(314);
+		std::vector<SBenchShot> Spawns(ulSteps * SPAWNS_PER_STEP);
+		for (size_t i = 0; i < Spawns.size(); i++)
+		{
+			SBenchShot& s = Spawns[i];
+			s.x = (float)Rand.Range(0, 1440);
+			s.y = (float)Rand.Range(0, 900);
+			s.vx = (float)Rand.Range(-300, 300);
+			s.vy = (float)Rand.Range(-300, 300);
+			s.fLifetime = Rand.Range(1, 8) * 0.5f;
+		}
+
+		std::list<SBenchShot> Shots;
+		size_t iPeak = 0;
+		double dShotSteps = 0;
+		CBenchTimer ListTimer;
+		for (unsigned long Step = 0; Step < ulSteps; Step++)
+		{
+			for (int i = 0; i < SPAWNS_PER_STEP; i++) Shots.push_back(Spawns[Step * SPAWNS_PER_STEP + i]);
+			for (std::list<SBenchShot>::iterator it = Shots.begin(); it != Shots.end(); ++it)
+			{
+				it->x += it->vx * DT;
+				it->y += it->vy * DT;
+				it->fLifetime -= DT;
+			}
+			for (std::list<SBenchShot>::iterator it = Shots.begin(); it != Shots.end();)
+			{
+				if (it->Dead(RIGHT, BOTTOM)) it = Shots.erase(it);
+				else ++it;
+			}
+			iPeak = std::max(iPeak, Shots.size());
+			dShotSteps += (double)Shots.size();
+		}
+		double dListTime = ListTimer.Seconds();
+
+		ProjectilePool Pool((int)iPeak + SPAWNS_PER_STEP);
+		CBenchTimer PoolTimer;
+		for (unsigned long Step = 0; Step < ulSteps; Step++)
+		{
+			for (int i = 0; i < SPAWNS_PER_STEP; i++)
+			{
+				const SBenchShot& s = Spawns[Step * SPAWNS_PER_STEP + i];
+				Pool.spawn(s.x, s.y, s.vx, s.vy, s.fLifetime, ProjectilePool::OWNER_ENEMY, 0);
+			}
+			Pool.update(DT);
+			Pool.cull(0, 0, RIGHT, BOTTOM);
+		}
+		double dPoolTime = PoolTimer.Seconds();
+
+		printf("projectiles: %lu steps, %d spawns per step, up to %u in flight\n", ulSteps, SPAWNS_PER_STEP, (unsigned int)iPeak);
+		printf("  list       %8.2f ns/shot step\n", dListTime * 1e9 / dShotSteps);
+		printf("  pool       %8.2f ns/shot step  x%.1f\n", dPoolTime * 1e9 / dShotSteps,
+			   dPoolTime > 0 ? dListTime / dPoolTime : 0.0);
+
+		// Same survivors at the same places, in any order
+		std::vector<std::pair<float, float> > FromList, FromPool;
+		for (std::list<SBenchShot>::const_iterator it = Shots.begin(); it != Shots.end(); ++it)
+			FromList.push_back(std::make_pair(it->x, it->y));
+		for (int i = 0; i < Pool.size(); i++)
+			FromPool.push_back(std::make_pair(Pool.xs()[i], Pool.ys()[i]));
+		std::sort(FromList.begin(), FromList.end());
+		std::sort(FromPool.begin(), FromPool.end());
+
+		bool bOk = FromList == FromPool && Pool.droppedCount() == 0;
+		printf("  %u shots left  %s\n", (unsigned int)FromPool.size(), bOk ? "ok" : "MISMATCH");
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchEnemies ()
+	// Desc : Enemies flying across and leaving, kept in a std::list cleaned
+	//		with remove_if as the world did, against the slot map. Both must
+	//		keep the same enemies, and every handle to a removed enemy must
+	//		be refused.
+	//-------------------------------------------------------------------------
+	bool BenchEnemies(unsigned long ulIterations)
+	{
+		const int	CAPACITY = 1024;
+		const int	WAVE = 8;
+		const int	STEPS = 120;
+		const float	DT = 1.0f / 120.0f;
+		unsigned long ulSteps = ulIterations * STEPS;
+
+		// The same waves for both, spawned whenever there is room for one
+		CBenchRandom Rand(1500);
+		std::vector<double> Starts(ulSteps * WAVE);
+		for (size_t i = 0; i < Starts.size(); i++) Starts[i] = Rand.Range(0, 1300);
+
+		std::list<Enemy> List;
+		double dEnemySteps = 0;
+		CBenchTimer ListTimer;
+		for (unsigned long Step = 0; Step < ulSteps; Step++)
+		{
+			if (List.size() + WAVE <= (size_t)CAPACITY)
+				for (int i = 0; i < WAVE; i++) List.push_back(Enemy(Vec2(Starts[Step * WAVE + i], 100.0)));
+			for (auto& e : List) e.move(DT);
+			List.remove_if([](const Enemy& c) { return c.mPosition.x > 1300; });
+			dEnemySteps += (double)List.size();
+		}
+		double dListTime = ListTimer.Seconds();
+
+		SlotMap<Enemy> Map(CAPACITY);
+		std::vector<SlotHandle> Handles;
+		Handles.reserve(ulSteps * WAVE);
+		const Enemy* pStorage = Map.begin();
+		CBenchTimer MapTimer;
+		for (unsigned long Step = 0; Step < ulSteps; Step++)
+		{
+			if (Map.size() + WAVE <= CAPACITY)
+				for (int i = 0; i < WAVE; i++) Handles.push_back(Map.emplace(Vec2(Starts[Step * WAVE + i], 100.0)));
+			for (auto& e : Map) e.move(DT);
+			for (int i = 0; i < Map.size();)
+			{
+				if (Map.at(i).mPosition.x > 1300) Map.removeAt(i);
+				else i++;
+			}
+		}
+		double dMapTime = MapTimer.Seconds();
+
+		printf("enemies: %lu steps, waves of %d, %.0f enemies on average\n", ulSteps, WAVE, dEnemySteps / ulSteps);
+		printf("  list       %8.2f ns/enemy step\n", dListTime * 1e9 / dEnemySteps);
+		printf("  slot map   %8.2f ns/enemy step  x%.1f\n", dMapTime * 1e9 / dEnemySteps,
+			   dMapTime > 0 ? dListTime / dMapTime : 0.0);
+
+		// Same survivors, the storage never moved, and the handles of the
+		// removed enemies are all stale
+		std::vector<double> FromList, FromMap, FromHandles;
+		for (auto& e : List) FromList.push_back(e.mPosition.x);
+		for (auto& e : Map) FromMap.push_back(e.mPosition.x);
+		size_t iStale = 0;
+		for (size_t i = 0; i < Handles.size(); i++)
+		{
+			if (const Enemy* e = Map.get(Handles[i])) FromHandles.push_back(e->mPosition.x);
+			else iStale++;
+		}
+		std::sort(FromList.begin(), FromList.end());
+		std::sort(FromMap.begin(), FromMap.end());
+		std::sort(FromHandles.begin(), FromHandles.end());
+
+		bool bSame = FromList == FromMap && FromMap == FromHandles;
+		bool bStale = iStale == Handles.size() - Map.size();
+		bool bNoAlloc = Map.begin() == pStorage;
+		printf("  %u enemies left %s, %u stale handles refused %s, storage %s\n", (unsigned int)FromMap.size(),
+			   bSame ? "ok" : "MISMATCH", (unsigned int)iStale, bStale ? "ok" : "MISMATCH", bNoAlloc ? "kept" : "MOVED");
+		return bSame && bStale && bNoAlloc;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchBroadphase ()
+	// Desc : A bullet hell of shots against a sky of enemies, every shot
+	//		tested against every enemy, against the grid rebuilt and queried.
+	//		Both must find the same pairs.
+	//-------------------------------------------------------------------------
+	bool BenchBroadphase(unsigned long ulIterations)
+	{
+		const int	SHOTS = 20000;
+		const int	ENEMIES = 200;
+		const float	SHOT_W = 37, SHOT_H = 30, ENEMY_W = 100, ENEMY_H = 143;
+		enum { LAYER_ENEMY, LAYER_SHOT };
+
+		CBenchRandom Rand(16);
+		std::vector<float> ShotX(SHOTS), ShotY(SHOTS), EnemyX(ENEMIES), EnemyY(ENEMIES);
+		for (int i = 0; i < SHOTS; i++) { ShotX[i] = (float)Rand.Range(0, 1440); ShotY[i] = (float)Rand.Range(0, 900); }
+		for (int i = 0; i < ENEMIES; i++) { EnemyX[i] = (float)Rand.Range(0, 1440); EnemyY[i] = (float)Rand.Range(0, 900); }
+
+		std::vector<std::pair<int, int> > BrutePairs;
+		CBenchTimer BruteTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			BrutePairs.clear();
+			for (int s = 0; s < SHOTS; s++)
+			{
+				for (int e = 0; e < ENEMIES; e++)
+				{
+					if (fabsf(ShotX[s] - EnemyX[e]) * 2 <= SHOT_W + ENEMY_W && fabsf(ShotY[s] - EnemyY[e]) * 2 <= SHOT_H + ENEMY_H)
+						BrutePairs.push_back(std::make_pair(s, e));
+				}
+			}
+		}
+		double dBruteTime = BruteTimer.Seconds();
+
+		Broadphase Grid(-64, -64, 1440 + 64, 900 + 64, 128, 2);
+		std::vector<BroadphasePair> Pairs;
+		CBenchTimer GridTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Grid.clear();
+			for (int e = 0; e < ENEMIES; e++) Grid.addCentered(e, LAYER_ENEMY, EnemyX[e], EnemyY[e], ENEMY_W, ENEMY_H);
+			for (int s = 0; s < SHOTS; s++) Grid.addCentered(s, LAYER_SHOT, ShotX[s], ShotY[s], SHOT_W, SHOT_H);
+			Grid.build();
+
+			Pairs.clear();
+			Grid.query(LAYER_SHOT, LAYER_ENEMY, Pairs);
+		}
+		double dGridTime = GridTimer.Seconds();
+
+		const BroadphaseStats& Stats = Grid.stats();
+		printf("broadphase: %d shots against %d enemies, %dx%d cells of %.0f px\n", SHOTS, ENEMIES, Grid.columns(), Grid.rows(),
+			   Grid.cellSize());
+		printf("  all pairs  %8.3f ms/step  (%d tests)\n", dBruteTime * 1000.0 / ulIterations, SHOTS * ENEMIES);
+		printf("  grid       %8.3f ms/step  x%.1f  (%lu tests, %d/%d cells used, %d boxes in the fullest)\n",
+			   dGridTime * 1000.0 / ulIterations, dGridTime > 0 ? dBruteTime / dGridTime : 0.0, Stats.pairsTested,
+			   Stats.occupiedCells, Stats.cells, Stats.maxCellEntries);
+
+		std::vector<std::pair<int, int> > GridPairs;
+		for (size_t i = 0; i < Pairs.size(); i++) GridPairs.push_back(std::make_pair(Pairs[i].a, Pairs[i].b));
+		std::sort(BrutePairs.begin(), BrutePairs.end());
+		std::sort(GridPairs.begin(), GridPairs.end());
+
+		bool bOk = BrutePairs == GridPairs;
+		printf("  %u pairs  %s\n", (unsigned int)GridPairs.size(), bOk ? "ok" : "MISMATCH");
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : CLegacySprite (Class)
+	// Desc : Just what the old Sprite_Collide read from a sprite, its
+	//		position and its size through virtual calls.
+	//-------------------------------------------------------------------------
+	class CLegacySprite
+	{
+	public:
+		CLegacySprite(float x, float y, int w, int h) : m_x(x), m_y(y), m_w(w), m_h(h) { }
+		virtual ~CLegacySprite() { }
+		virtual int width() const { return m_w; }
+		virtual int height() const { return m_h; }
+
+		float m_x, m_y;
+
+	private:
+		int m_w, m_h;
+	};
+
+	//-------------------------------------------------------------------------
+	// Name : LegacySpriteCollide ()
+	// Desc : The old Sprite_Collide as it was, one pair per call. Its boxes
+	//		are a quarter of the sprites (right = left + width / 2) and the
+	//		second one takes the height of the first.
+	//-------------------------------------------------------------------------
+	int LegacySpriteCollide(const CLegacySprite* object1, const CLegacySprite* object2)
+	{
+		int left1 = (int)(object1->m_x - object1->width() / 2);
+		int left2 = (int)(object2->m_x - object2->width() / 2);
+		int right1 = left1 + object1->width() / 2;
+		int right2 = left2 + object2->width() / 2;
+		int top1 = (int)(object1->m_y - object1->height() / 2);
+		int top2 = (int)(object2->m_y - object1->height() / 2);
+		int bottom1 = top1 + object1->height() / 2;
+		int bottom2 = top2 + object2->height() / 2;
+
+		if (bottom1 < top2) return(0);
+		if (top1 > bottom2) return(0);
+		if (right1 < left2) return(0);
+		if (left1 > right2) return(0);
+		return(1);
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchOverlap ()
+	// Desc : Ships tested against a packed array of shots, one pair at a
+	//		time by the old Sprite_Collide and by the corrected scalar test,
+	//		then by every batch kernel. The kernels must find exactly the
+	//		pairs of the corrected test.
+	//-------------------------------------------------------------------------
+	bool BenchOverlap(unsigned long ulIterations)
+	{
+		const int	SHIPS = 64;
+		const int	SHOTS = 4096;
+		const int	SHIP_W = 137, SHIP_H = 107, SHOT_W = 37, SHOT_H = 30;
+
+		CBenchRandom Rand(17);
+		std::vector<CLegacySprite> Ships, Shots;
+		std::vector<float> Left(SHOTS), Top(SHOTS), Right(SHOTS), Bottom(SHOTS);
+		for (int i = 0; i < SHIPS; i++) Ships.push_back(CLegacySprite((float)Rand.Range(0, 1440), (float)Rand.Range(0, 900), SHIP_W, SHIP_H));
+		for (int i = 0; i < SHOTS; i++)
+		{
+			Shots.push_back(CLegacySprite((float)Rand.Range(0, 1440), (float)Rand.Range(0, 900), SHOT_W, SHOT_H));
+			Left[i] = Shots[i].m_x - SHOT_W * 0.5f;
+			Top[i] = Shots[i].m_y - SHOT_H * 0.5f;
+			Right[i] = Shots[i].m_x + SHOT_W * 0.5f;
+			Bottom[i] = Shots[i].m_y + SHOT_H * 0.5f;
+		}
+		BoxList Boxes = { Left.data(), Top.data(), Right.data(), Bottom.data(), SHOTS };
+		double dPairs = (double)ulIterations * SHIPS * SHOTS;
+
+		printf("overlap: %d ships against %d shots\n", SHIPS, SHOTS);
+
+		// The old function, through the sprites
+		unsigned long ulLegacyHits = 0;
+		CBenchTimer LegacyTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			ulLegacyHits = 0;
+			for (int s = 0; s < SHIPS; s++)
+				for (int i = 0; i < SHOTS; i++)
+					ulLegacyHits += LegacySpriteCollide(&Ships[s], &Shots[i]);
+		}
+		double dLegacyTime = LegacyTimer.Seconds();
+		printf("  legacy     %8.1f Mpairs/s  (%lu hits, quarter boxes)\n", dPairs / dLegacyTime * 1e-6, ulLegacyHits);
+
+		// The corrected test one pair at a time, the reference
+		std::vector<int> Reference;
+		CBenchTimer ScalarTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			Reference.clear();
+			for (int s = 0; s < SHIPS; s++)
+			{
+				float l = Ships[s].m_x - SHIP_W * 0.5f, t = Ships[s].m_y - SHIP_H * 0.5f;
+				float r = Ships[s].m_x + SHIP_W * 0.5f, b = Ships[s].m_y + SHIP_H * 0.5f;
+				for (int i = 0; i < SHOTS; i++)
+					if (boxesOverlap(l, t, r, b, Left[i], Top[i], Right[i], Bottom[i])) Reference.push_back(s * SHOTS + i);
+			}
+		}
+		double dScalarTime = ScalarTimer.Seconds();
+		printf("  reference  %8.1f Mpairs/s  x%.1f  (%u hits)\n", dPairs / dScalarTime * 1e-6,
+			   dScalarTime > 0 ? dLegacyTime / dScalarTime : 0.0, (unsigned int)Reference.size());
+
+		OverlapKernel Saved = getOverlapKernel();
+		std::vector<int> Indices(SHOTS), Found;
+		bool bOk = true;
+
+		for (int k = 0; k < OVERLAP_KERNEL_COUNT; k++)
+		{
+			if (!isOverlapKernelSupported((OverlapKernel)k)) continue;
+			setOverlapKernel((OverlapKernel)k);
+
+			CBenchTimer KernelTimer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				Found.clear();
+				for (int s = 0; s < SHIPS; s++)
+				{
+					float l = Ships[s].m_x - SHIP_W * 0.5f, t = Ships[s].m_y - SHIP_H * 0.5f;
+					float r = Ships[s].m_x + SHIP_W * 0.5f, b = Ships[s].m_y + SHIP_H * 0.5f;
+					int iCount = overlapIndices(l, t, r, b, Boxes, Indices.data());
+					for (int i = 0; i < iCount; i++) Found.push_back(s * SHOTS + Indices[i]);
+				}
+			}
+			double dKernelTime = KernelTimer.Seconds();
+
+			bool bSame = Found == Reference;
+			bOk = bOk && bSame;
+			printf("  %-10s %8.1f Mpairs/s  x%.1f  %s\n", getOverlapKernelName((OverlapKernel)k), dPairs / dKernelTime * 1e-6,
+				   dKernelTime > 0 ? dLegacyTime / dKernelTime : 0.0, bSame ? "ok" : "MISMATCH");
+		}
+
+		setOverlapKernel(Saved);
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : PixelOpaque ()
+	// Desc : Whether a pixel of a sprite image is drawn, read from the
+	//		image itself: the reference for the collision masks.
+	//-------------------------------------------------------------------------
+	bool PixelOpaque(const SpriteImage& Image, int x, int y)
+	{
+		if (Image.masked()) return (Image.mask.row(y)[x] & 0x00FFFFFF) != 0x00FFFFFF;
+		return Image.image.row(y)[x] != Image.transparentColor;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchPixels ()
+	// Desc : A dense bullet hell, shots all over the ships turned to every
+	//		heading. Every pair of overlapping boxes is tested pixel by pixel
+	//		on the images and with the packed row masks, which must agree.
+	//-------------------------------------------------------------------------
+	bool BenchPixels(unsigned long ulIterations)
+	{
+		const int	PAIRS = 4096;
+
+		ImageCache Images;
+		RotationHandle Ships = Images.loadRotations("Data/PlaneImg.bmp", "Data/PlaneMask.bmp", 32);
+		ImageHandle Bullet = Images.load("Data/bullet.bmp", "Data/bmask.bmp");
+		ImageHandle Enemy = Images.load("Data/Enemy.bmp", RGB(0xff, 0x00, 0xff));
+		if (!Bullet || !Enemy || !Ships)
+		{
+			printf("pixels: cannot load the game images, run from the GameFramework folder\n");
+			return false;
+		}
+
+		// Shots and enemies placed so their box overlaps the one of a ship
+		struct SPair { const SpriteImage* pShip; const SpriteImage* pOther; int x, y; };
+		CBenchRandom Rand(18);
+		std::vector<SPair> Pairs(PAIRS);
+		for (int i = 0; i < PAIRS; i++)
+		{
+			SPair& p = Pairs[i];
+			p.pShip = Ships->frames[Rand.Range(0, (int)Ships->count() - 1)].get();
+			p.pOther = Rand.Range(0, 7) ? Bullet.get() : Enemy.get();
+			p.x = Rand.Range(1 - p.pOther->image.width(), p.pShip->image.width() - 1);
+			p.y = Rand.Range(1 - p.pOther->image.height(), p.pShip->image.height() - 1);
+		}
+
+		printf("pixels: %d ship / shot or enemy pairs with overlapping boxes, ships in %u headings\n", PAIRS,
+			   (unsigned int)Ships->count());
+
+		std::vector<char> Reference(PAIRS), Masked(PAIRS);
+		CBenchTimer PixelTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			for (int i = 0; i < PAIRS; i++)
+			{
+				const SPair& p = Pairs[i];
+				int x0 = std::max(0, p.x), x1 = std::min(p.pShip->image.width(), p.x + p.pOther->image.width());
+				int y0 = std::max(0, p.y), y1 = std::min(p.pShip->image.height(), p.y + p.pOther->image.height());
+
+				bool bHit = false;
+				for (int y = y0; y < y1 && !bHit; y++)
+					for (int x = x0; x < x1 && !bHit; x++)
+						bHit = PixelOpaque(*p.pShip, x, y) && PixelOpaque(*p.pOther, x - p.x, y - p.y);
+				Reference[i] = bHit;
+			}
+		}
+		double dPixelTime = PixelTimer.Seconds();
+
+		CBenchTimer MaskTimer;
+		for (unsigned long n = 0; n < ulIterations; n++)
+		{
+			for (int i = 0; i < PAIRS; i++)
+			{
+				const SPair& p = Pairs[i];
+				Masked[i] = CollisionMask::overlap(p.pShip->collision, 0, 0, p.pOther->collision, p.x, p.y);
+			}
+		}
+		double dMaskTime = MaskTimer.Seconds();
+
+		int iHits = 0;
+		for (int i = 0; i < PAIRS; i++) iHits += Reference[i];
+		double dTests = (double)ulIterations * PAIRS;
+
+		printf("  per pixel  %8.1f ns/pair\n", dPixelTime * 1e9 / dTests);
+		printf("  row masks  %8.1f ns/pair  x%.1f\n", dMaskTime * 1e9 / dTests, dMaskTime > 0 ? dPixelTime / dMaskTime : 0.0);
+
+		bool bOk = Reference == Masked;
+		printf("  %d of %d box hits touch  %s\n", iHits, PAIRS, bOk ? "ok" : "MISMATCH");
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchSweep ()
+	// Desc : Fast shots fired through a ship at 120, 30 and 10 steps per
+	//		second. Every shot crosses the ship, the test on the positions
+	//		at the end of each step misses the ones that jump over it, the
+	//		swept test must find them all.
+	//-------------------------------------------------------------------------
+	bool BenchSweep(unsigned long ulIterations)
+	{
+		const int	SHOTS = 4096;
+		const float	SHOT_SPEED = 3600.0f;		// Pixels per second
+		const float	SHIP_WIDTH = 60, SHIP_HEIGHT = 60, SHOT_WIDTH = 37, SHOT_HEIGHT = 30;
+		const float	FLIGHT = 600.0f;			// Starting distance left of the ship
+		const int	RATES[] = { 120, 30, 10 };
+
+		// Shots aimed at the ship from random heights and starting points
+		CBenchRandom Rand(19);
+		std::vector<float> StartX(SHOTS), StartY(SHOTS);
+		for (int i = 0; i < SHOTS; i++)
+		{
+			StartX[i] = -FLIGHT - Rand.Range(0, 999) * 0.1f;
+			StartY[i] = (float)Rand.Range(-(int)(SHIP_HEIGHT + SHOT_HEIGHT) / 2, (int)(SHIP_HEIGHT + SHOT_HEIGHT) / 2);
+		}
+
+		printf("sweep: %d shots at %.0f px/s through a %.0fx%.0f ship\n", SHOTS, SHOT_SPEED, SHIP_WIDTH, SHIP_HEIGHT);
+
+		bool bOk = true;
+		for (size_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+		{
+			float fStep = SHOT_SPEED / RATES[r];
+			int nSteps = (int)((FLIGHT + 100.0f + SHIP_WIDTH + SHOT_WIDTH) / fStep) + 1;
+			int iDiscrete = 0, iSwept = 0;
+			long lDiscreteTests = 0, lSweptTests = 0;
+
+			CBenchTimer DiscreteTimer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				iDiscrete = 0;
+				lDiscreteTests = 0;
+				for (int i = 0; i < SHOTS; i++)
+				{
+					float x = StartX[i], y = StartY[i];
+					for (int s = 0; s < nSteps; s++, lDiscreteTests++)
+					{
+						x += fStep;
+						if (boxesOverlap(x - SHOT_WIDTH / 2, y - SHOT_HEIGHT / 2, x + SHOT_WIDTH / 2, y + SHOT_HEIGHT / 2,
+										 -SHIP_WIDTH / 2, -SHIP_HEIGHT / 2, SHIP_WIDTH / 2, SHIP_HEIGHT / 2))
+						{
+							iDiscrete++;
+							break;
+						}
+					}
+				}
+			}
+			double dDiscreteTime = DiscreteTimer.Seconds();
+
+			CBenchTimer SweptTimer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+			{
+				iSwept = 0;
+				lSweptTests = 0;
+				for (int i = 0; i < SHOTS; i++)
+				{
+					float x = StartX[i], y = StartY[i];
+					for (int s = 0; s < nSteps; s++, lSweptTests++)
+					{
+						float fEnter, fLeave;
+						if (sweepBoxes(x - SHOT_WIDTH / 2, y - SHOT_HEIGHT / 2, x + SHOT_WIDTH / 2, y + SHOT_HEIGHT / 2, fStep, 0,
+									   -SHIP_WIDTH / 2, -SHIP_HEIGHT / 2, SHIP_WIDTH / 2, SHIP_HEIGHT / 2, fEnter, fLeave))
+						{
+							iSwept++;
+							break;
+						}
+						x += fStep;
+					}
+				}
+			}
+			double dSweptTime = SweptTimer.Seconds();
+
+			printf("  %3d Hz  %5.1f px/step  end positions %4d hit  %5.1f ns/test   swept %4d hit  %5.1f ns/test\n",
+				   RATES[r], fStep, iDiscrete, dDiscreteTime * 1e9 / ((double)ulIterations * lDiscreteTests),
+				   iSwept, dSweptTime * 1e9 / ((double)ulIterations * lSweptTests));
+			bOk = bOk && iSwept == SHOTS;
+		}
+
+		printf("  %s\n", bOk ? "ok" : "MISMATCH");
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchMixer ()
+	// Desc : Mixes 10 ms blocks of 1 to 64 looping voices of the game
+	//		sounds, converted to the mixer rate like the game loads them, at
+	//		random volumes and pans, and tells how much of the block the mix
+	//		takes. One voice is checked against a plain mix of the sound
+	//		computed in doubles.
+	//-------------------------------------------------------------------------
+	bool BenchMixer(unsigned long ulIterations)
+	{
+		const char*	Files[] = { "Data/jet-start.wav", "Data/jet-stop.wav", "Data/jet-cabin.wav", "Data/explosion.wav", "Data/fart.wav" };
+		const int	FILE_COUNT = sizeof(Files) / sizeof(Files[0]);
+		const int	VOICES[] = { 1, 8, 32, AudioMixer::MAX_VOICES };
+		const int	BLOCK = AudioEngine::BLOCK_FRAMES;
+		const int	BLOCKS = 100;				// A second of sound per iteration
+
+		SoundCache Cache(AudioEngine::SAMPLE_RATE);
+		SoundHandle Sounds[FILE_COUNT];
+		for (int i = 0; i < FILE_COUNT; i++)
+		{
+			Sounds[i] = Cache.load(Files[i]);
+			if (!Sounds[i])
+			{
+				printf("mixer: cannot load %s\n", Files[i]);
+				return false;
+			}
+		}
+
+		printf("mixer: %d frame blocks at %d Hz, %lu KB of decoded sound\n",
+			   BLOCK, (int)AudioEngine::SAMPLE_RATE, (unsigned long)(Cache.residentBytes() / 1024));
+
+		std::vector<float> Block(BLOCK * 2);
+		CBenchRandom Rand(21);
+		for (size_t v = 0; v < sizeof(VOICES) / sizeof(VOICES[0]); v++)
+		{
+			AudioMixer Mixer(AudioEngine::SAMPLE_RATE);
+			for (int i = 0; i < VOICES[v]; i++)
+				Mixer.play(i + 1, Sounds[i % FILE_COUNT], Rand.Range(20, 101) * 0.01f, Rand.Range(-100, 101) * 0.01f, true);
+
+			CBenchTimer Timer;
+			for (unsigned long n = 0; n < ulIterations; n++)
+				for (int b = 0; b < BLOCKS; b++)
+					Mixer.mix(Block.data(), BLOCK);
+			double dBlock = Timer.Seconds() / ((double)ulIterations * BLOCKS);
+
+			printf("  %2d voices  %7.2f us/block  %5.2f%% of a block  %6.1f ns/voice frame\n",
+				   VOICES[v], dBlock * 1e6, dBlock * 100.0 / AudioEngine::blockSeconds(),
+				   dBlock * 1e9 / ((double)VOICES[v] * BLOCK));
+		}
+
+		// The stereo sound, looping, half volume, panned a little left
+		const Sound& Check = *Sounds[FILE_COUNT - 1];
+		const float VOLUME = 0.5f, PAN = -0.25f;
+		AudioMixer Mixer(AudioEngine::SAMPLE_RATE);
+		Mixer.play(1, Sounds[FILE_COUNT - 1], VOLUME, PAN, true);
+
+		size_t nFrames = Check.frames();
+		double dStep = (double)Check.sampleRate / AudioEngine::SAMPLE_RATE;
+		double dMaxError = 0;
+		for (int b = 0; b < BLOCKS * 2; b++)
+		{
+			Mixer.mix(Block.data(), BLOCK);
+			for (int f = 0; f < BLOCK; f++)
+			{
+				double dPos = fmod((double)(b * BLOCK + f) * dStep, (double)nFrames);
+				size_t i = (size_t)dPos, j = (i + 1) % nFrames;
+				double t = dPos - i;
+				for (int c = 0; c < 2; c++)
+				{
+					double a = Check.samples[i * 2 + c], e = Check.samples[j * 2 + c];
+					double dGain = VOLUME * (c == 1 ? 1 + PAN : 1);
+					double dError = fabs(Block[f * 2 + c] - (a + (e - a) * t) * dGain);
+					if (dError > dMaxError) dMaxError = dError;
+				}
+			}
+		}
+
+		bool bOk = dMaxError < 1e-4;
+		printf("  reference mix  max error %.2g  %s\n", dMaxError, bOk ? "ok" : "MISMATCH");
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchCommands ()
+	// Desc : Sound requests handed from one thread to another, first as
+	//		fast as they go, through a locked vector swapped by the reader
+	//		and through the lock free ring, every value checked in order.
+	//		Then thousands of requests a second are posted to a running
+	//		AudioEngine in bursts of a 120 Hz frame; none may be dropped,
+	//		and the longest post tells whether the game ever waited.
+	//-------------------------------------------------------------------------
+	bool BenchCommands(unsigned long ulIterations)
+	{
+		const unsigned long	ITEMS = ulIterations * 5000;
+		const int			CAPACITY = AudioEngine::COMMAND_CAPACITY;
+		const int			RATES[] = { 1000, 5000, 20000 };	// Requests a second
+		const double		SECONDS = 0.5;
+
+		printf("commands: %lu requests between two threads, %d deep ring\n", ITEMS, CAPACITY);
+		bool bOk = true;
+
+		// Locked vector, the reader swaps it for an empty one
+		{
+			std::mutex Mutex;
+			std::vector<unsigned long> Pending;
+			bool bInOrder = true;
+
+			CBenchTimer Timer;
+			std::thread Reader([&]()
+			{
+				std::vector<unsigned long> Taken;
+				unsigned long ulNext = 0;
+				while (ulNext < ITEMS)
+				{
+					{
+						std::lock_guard<std::mutex> Lock(Mutex);
+						Taken.swap(Pending);
+					}
+					if (Taken.empty()) std::this_thread::yield();
+					for (size_t i = 0; i < Taken.size(); i++)
+						if (Taken[i] != ulNext++) bInOrder = false;
+					Taken.clear();
+				}
+			});
+			for (unsigned long i = 0; i < ITEMS; i++)
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Pending.push_back(i);
+			}
+			Reader.join();
+			double dTime = Timer.Seconds();
+
+			printf("  locked vector  %6.1f ns/request  %s\n", dTime * 1e9 / ITEMS, bInOrder ? "ok" : "MISMATCH");
+			bOk = bOk && bInOrder;
+		}
+
+		// Lock free ring, the writer tries again when it is full
+		{
+			SpscQueue<unsigned long> Queue(CAPACITY);
+			bool bInOrder = true;
+
+			CBenchTimer Timer;
+			std::thread Reader([&]()
+			{
+				unsigned long ulNext = 0, ulValue;
+				while (ulNext < ITEMS)
+				{
+					if (!Queue.pop(ulValue)) std::this_thread::yield();
+					else if (ulValue != ulNext++) bInOrder = false;
+				}
+			});
+			for (unsigned long i = 0; i < ITEMS; i++)
+				while (!Queue.push(i))
+					std::this_thread::yield();
+			Reader.join();
+			double dTime = Timer.Seconds();
+
+			printf("  lock free ring %6.1f ns/request  %s (%lu full rings met)\n", dTime * 1e9 / ITEMS,
+				   bInOrder ? "ok" : "MISMATCH", Queue.overflows());
+			bOk = bOk && bInOrder;
+		}
+
+		// A short sound to play, a second of silence
+		std::shared_ptr<Sound> pSilence = std::make_shared<Sound>();
+		pSilence->sampleRate = AudioEngine::SAMPLE_RATE;
+		pSilence->channels = 1;
+		pSilence->samples.assign(AudioEngine::SAMPLE_RATE, 0.0f);
+		SoundHandle Silence = pSilence;
+
+		for (size_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+		{
+			AudioEngine Engine;
+			if (!Engine.start(new NullAudioOutput(true)))
+				return false;
+
+			// Each frame plays voices, moves them and stops the older ones
+			int nFrames = (int)(SECONDS * 120);
+			int nPerFrame = RATES[r] / 120;
+			unsigned long ulPosted = 0;
+			double dLongest = 0, dPosting = 0;
+			std::vector<VoiceId> Voices;
+
+			CBenchTimer Timer;
+			for (int f = 0; f < nFrames; f++)
+			{
+				for (int i = 0; i < nPerFrame; i++, ulPosted++)
+				{
+					CBenchTimer Post;
+					switch (i % 3)
+					{
+					case 0: Voices.push_back(Engine.play(Silence, 0.5f, 0.0f)); break;
+					case 1: Engine.setPan(Voices.back(), (i % 7) / 3.0f - 1.0f); break;
+					case 2: Engine.stopVoice(Voices[Voices.size() / 2]); break;
+					}
+					double dPost = Post.Seconds();
+					dPosting += dPost;
+					if (dPost > dLongest) dLongest = dPost;
+				}
+
+				// Sleep out the rest of the frame
+				double dWait = (f + 1) / 120.0 - Timer.Seconds();
+				if (dWait > 0) std::this_thread::sleep_for(std::chrono::microseconds((long long)(dWait * 1e6)));
+			}
+
+			int iPeak = Engine.peakCommandDepth();
+			unsigned long ulOverflows = Engine.commandOverflows();
+			Engine.stop();
+			unsigned long ulApplied = Engine.stats().commands;
+
+			bool bRateOk = ulOverflows == 0 && ulApplied == ulPosted;
+			printf("  %5d/s  %6lu posted  %6lu applied  %3d queued at most  %lu overflowed  post %5.0f ns avg %6.1f us max  %s\n",
+				   RATES[r], ulPosted, ulApplied, iPeak, ulOverflows, dPosting * 1e9 / ulPosted, dLongest * 1e6,
+				   bRateOk ? "ok" : "MISMATCH");
+			bOk = bOk && bRateOk;
+		}
+
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : ResampleLinear ()
+	// Desc : The reference conversion, what the mixer does for a sound at
+	//		another rate: straight lines between the input frames.
+	//-------------------------------------------------------------------------
+	void ResampleLinear(const float* pIn, size_t nFrames, int iInRate, int iOutRate, float* pOut, size_t nOutFrames)
+	{
+		double dStep = (double)iInRate / iOutRate;
+		for (size_t n = 0; n < nOutFrames; n++)
+		{
+			double dPos = n * dStep;
+			size_t i = (size_t)dPos;
+			float a = pIn[i], b = i + 1 < nFrames ? pIn[i + 1] : 0.0f;
+			pOut[n] = a + (b - a) * (float)(dPos - i);
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchResample ()
+	// Desc : Converts tones at the rates of the game sounds to the mixer
+	//		rate by straight lines and by the polyphase filter, scalar and
+	//		SSE2. Quality is the signal to error ratio against the tones
+	//		computed at the output rate, away from the ends; going down
+	//		from 48 kHz, a tone the output cannot hold must also go instead
+	//		of folding back.
+	//-------------------------------------------------------------------------
+	bool BenchResample(unsigned long ulIterations)
+	{
+		const int		RATES[] = { 8000, 11127, 22222, 48000 };
+		const int		OUT_RATE = AudioEngine::SAMPLE_RATE;
+		const double	TONES[] = { 0.05, 0.17, 0.31, 0.41 };		// Shares of the lower rate
+		const int		TONE_COUNT = sizeof(TONES) / sizeof(TONES[0]);
+		const double	ALIAS_TONE = 23500.0;						// Hz, above the mixer's Nyquist
+		const double	SECONDS = 0.5;
+		unsigned long	ulRuns = ulIterations / 20 ? ulIterations / 20 : 1;
+
+		printf("resample: %.1f s of tones to %d Hz, %d taps, %d phases\n", SECONDS, OUT_RATE, (int)Resampler::TAPS, (int)Resampler::PHASES);
+
+		bool bOk = true;
+		ResampleKernel eKernel = getResampleKernel();
+		for (size_t r = 0; r < sizeof(RATES) / sizeof(RATES[0]); r++)
+		{
+			int iInRate = RATES[r];
+			double dLower = iInRate < OUT_RATE ? iInRate : OUT_RATE;
+			Resampler Converter(iInRate, OUT_RATE);
+			size_t nFrames = (size_t)(SECONDS * iInRate);
+			size_t nOut = Converter.outputFrames(nFrames);
+
+			// In band tones, and past the output's reach when going down
+			bool bAlias = iInRate > OUT_RATE;
+			std::vector<float> In(nFrames), Alias(nFrames);
+			for (size_t i = 0; i < nFrames; i++)
+			{
+				double t = (double)i / iInRate, v = 0;
+				for (int k = 0; k < TONE_COUNT; k++) v += sin(2 * PI * TONES[k] * dLower * t + k) / TONE_COUNT;
+				In[i] = (float)v;
+				Alias[i] = (float)sin(2 * PI * ALIAS_TONE * t);
+			}
+
+			std::vector<float> Linear(nOut), Scalar(nOut), Simd(nOut);
+			double dTimes[3];
+			for (int m = 0; m < 3; m++)
+			{
+				if (m == 1) setResampleKernel(RESAMPLE_SCALAR);
+				if (m == 2) setResampleKernel(RESAMPLE_SSE2);
+
+				CBenchTimer Timer;
+				for (unsigned long n = 0; n < ulRuns; n++)
+				{
+					if (m == 0) ResampleLinear(In.data(), nFrames, iInRate, OUT_RATE, Linear.data(), nOut);
+					else Converter.process(In.data(), nFrames, 1, m == 1 ? Scalar.data() : Simd.data());
+				}
+				dTimes[m] = Timer.Seconds() / ulRuns;
+			}
+
+			// Signal to error, the filter's reach at both ends left out
+			double dSignal = 0, dLinearError = 0, dFilterError = 0, dKernelDiff = 0;
+			size_t nEdge = Resampler::TAPS * OUT_RATE / iInRate + 1;
+			for (size_t n = nEdge; n + nEdge < nOut; n++)
+			{
+				double t = (double)n / OUT_RATE, v = 0;
+				for (int k = 0; k < TONE_COUNT; k++) v += sin(2 * PI * TONES[k] * dLower * t + k) / TONE_COUNT;
+				dSignal += v * v;
+				dLinearError += (Linear[n] - v) * (Linear[n] - v);
+				dFilterError += (Simd[n] - v) * (Simd[n] - v);
+				dKernelDiff = std::max(dKernelDiff, fabs((double)Simd[n] - Scalar[n]));
+			}
+			double dLinearSnr = 10 * log10(dSignal / dLinearError);
+			double dFilterSnr = 10 * log10(dSignal / dFilterError);
+
+			printf("  %5d Hz  linear %6.1f dB %6.1f Mframe/s   polyphase %6.1f dB  scalar %5.1f Mframe/s  sse2 %5.1f Mframe/s",
+				   iInRate, dLinearSnr, nOut / dTimes[0] * 1e-6, dFilterSnr, nOut / dTimes[1] * 1e-6, nOut / dTimes[2] * 1e-6);
+			bool bRateOk = dFilterSnr > dLinearSnr && dFilterSnr > 60 && dKernelDiff < 1e-5;
+
+			// What is left of a tone the output rate cannot hold
+			if (bAlias)
+			{
+				Converter.process(Alias.data(), nFrames, 1, Simd.data());
+				ResampleLinear(Alias.data(), nFrames, iInRate, OUT_RATE, Linear.data(), nOut);
+				double dLinearLeft = 0, dFilterLeft = 0;
+				for (size_t n = nEdge; n + nEdge < nOut; n++)
+				{
+					dLinearLeft += Linear[n] * Linear[n];
+					dFilterLeft += Simd[n] * Simd[n];
+				}
+				double dLinearAlias = 10 * log10(dLinearLeft / ((nOut - 2 * nEdge) * 0.5));
+				double dFilterAlias = 10 * log10(dFilterLeft / ((nOut - 2 * nEdge) * 0.5));
+				printf("\n           %.1f kHz folds back at %.1f dB (linear) / %.1f dB (polyphase)", ALIAS_TONE / 1000, dLinearAlias, dFilterAlias);
+				bRateOk = bRateOk && dFilterAlias < -60;
+			}
+
+			printf("  %s\n", bRateOk ? "ok" : "MISMATCH");
+			bOk = bOk && bRateOk;
+		}
+
+		setResampleKernel(eKernel);
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchStream ()
+	// Desc : Streams each game sound to its end in 10 ms blocks and checks
+	//		it against the whole file loaded and converted by the cache.
+	//		Then loops the largest one for a minute of music, reading ahead
+	//		between blocks like the audio thread: the heap must stay flat
+	//		with no underrun. Left without reading ahead, the stream must
+	//		count the underruns.
+	//-------------------------------------------------------------------------
+	bool BenchStream(unsigned long ulIterations)
+	{
+		const char*	Files[] = { "Data/jet-start.wav", "Data/jet-stop.wav", "Data/jet-cabin.wav", "Data/explosion.wav", "Data/fart.wav" };
+		const int	FILE_COUNT = sizeof(Files) / sizeof(Files[0]);
+		const int	RATE = AudioEngine::SAMPLE_RATE;
+		const int	BLOCK = AudioEngine::BLOCK_FRAMES;
+		const int	MUSIC_SECONDS = 60;
+
+		printf("stream: %d frame ring, %d frame pieces\n", (int)AudioStream::RING_FRAMES, (int)AudioStream::CHUNK_FRAMES);
+
+		bool bOk = true;
+		SoundCache Cache(RATE);
+		std::vector<float> Block(BLOCK * 2);
+		for (int i = 0; i < FILE_COUNT; i++)
+		{
+			SoundHandle Whole = Cache.load(Files[i]);
+			AudioStream Stream(RATE);
+			if (Whole->empty() || !Stream.open(Files[i], false))
+			{
+				printf("  cannot open %s\n", Files[i]);
+				return false;
+			}
+
+			size_t nFrames = 0;
+			double dMaxError = 0;
+			bool bSame = Stream.channels() == Whole->channels;
+			while (bSame && !Stream.finished())
+			{
+				int nRead = Stream.read(Block.data(), BLOCK);
+				for (int f = 0; f < nRead * Stream.channels() && nFrames * Whole->channels + f < Whole->samples.size(); f++)
+					dMaxError = std::max(dMaxError, fabs((double)Block[f] - Whole->samples[nFrames * Whole->channels + f]));
+				nFrames += nRead;
+				Stream.prefetch();
+			}
+
+			bool bFileOk = bSame && nFrames == Whole->frames() && dMaxError < 1e-6 && Stream.underruns() == 0;
+			printf("  %-20s %5d Hz -> %d Hz  %6lu frames  streamed %4lu KB / whole %4lu KB  max error %.1g  %s\n",
+				   Files[i], Stream.fileRate(), RATE, (unsigned long)nFrames, (unsigned long)(Stream.residentBytes() / 1024),
+				   (unsigned long)(Whole->bytes() / 1024), dMaxError, bFileOk ? "ok" : "MISMATCH");
+			bOk = bOk && bFileOk;
+		}
+
+		// A minute of music, the stream looping over the largest file
+		AudioStream Music(RATE);
+		if (!Music.open(Files[FILE_COUNT - 1], true))
+			return false;
+
+		size_t nStartBytes = Music.residentBytes(), nMaxBytes = nStartBytes;
+		int nBlocks = MUSIC_SECONDS * RATE / BLOCK;
+		double dPrefetch = 0;
+		for (int b = 0; b < nBlocks; b++)
+		{
+			Music.read(Block.data(), BLOCK);
+
+			CBenchTimer Timer;
+			Music.prefetch();
+			dPrefetch += Timer.Seconds();
+			nMaxBytes = std::max(nMaxBytes, Music.residentBytes());
+		}
+
+		size_t nWholeBytes = (size_t)MUSIC_SECONDS * RATE * Music.channels() * sizeof(float);
+		bool bMusicOk = Music.underruns() == 0 && nMaxBytes == nStartBytes && !Music.finished();
+		printf("  %d s looping       %lu KB at the start, %lu KB at most (%lu KB loaded whole), %lu underruns, reading %.2f%% of the time  %s\n",
+			   MUSIC_SECONDS, (unsigned long)(nStartBytes / 1024), (unsigned long)(nMaxBytes / 1024), (unsigned long)(nWholeBytes / 1024),
+			   Music.underruns(), dPrefetch * 100.0 / MUSIC_SECONDS, bMusicOk ? "ok" : "MISMATCH");
+		bOk = bOk && bMusicOk;
+
+		// Nothing read ahead after the ring filled on opening
+		AudioStream Starved(RATE);
+		if (!Starved.open(Files[FILE_COUNT - 1], true))
+			return false;
+
+		int nFull = 0;
+		for (int b = 0; b < 100; b++)
+			if (Starved.read(Block.data(), BLOCK) == BLOCK) nFull++;
+
+		bool bStarvedOk = Starved.underruns() == (unsigned long)(100 - nFull) && Starved.underruns() > 0;
+		printf("  no read ahead      %d of 100 blocks full, %lu underruns  %s\n", nFull, Starved.underruns(), bStarvedOk ? "ok" : "MISMATCH");
+		bOk = bOk && bStarvedOk;
+
+		(void)ulIterations;
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : LoadBmpReference ()
+	// Desc : The old portable loader: reads the whole file onto the heap,
+	//		then converts it a pixel at a time into top-down opaque rows.
+	//-------------------------------------------------------------------------
+	bool LoadBmpReference(const char* szFileName, std::vector<uint32_t>& Pixels, int& iWidth, int& iHeight)
+	{
+		FILE* pFile = fopen(szFileName, "rb");
+		if (!pFile) return false;
+
+		std::vector<unsigned char> File;
+		unsigned char Chunk[4096];
+		size_t n;
+		while ((n = fread(Chunk, 1, sizeof(Chunk), pFile)) > 0) File.insert(File.end(), Chunk, Chunk + n);
+		fclose(pFile);
+		if (File.size() < 54 || File[0] != 'B' || File[1] != 'M') return false;
+
+		const unsigned char* pData = &File[0];
+		uint32_t uOffBits, uInfoSize, uColors;
+		int32_t iBpp = 0;
+		memcpy(&uOffBits, pData + 10, 4);
+		memcpy(&uInfoSize, pData + 14, 4);
+		memcpy(&iWidth, pData + 18, 4);
+		memcpy(&iHeight, pData + 22, 4);
+		memcpy(&iBpp, pData + 28, 2);
+		memcpy(&uColors, pData + 46, 4);
+
+		bool bTopDown = iHeight < 0;
+		if (bTopDown) iHeight = -iHeight;
+		size_t nStride = (((size_t)iWidth * iBpp + 31) / 32) * 4;
+		const unsigned char* pPalette = pData + 14 + uInfoSize;
+		uint32_t uPaletteSize = iBpp <= 8 ? (uColors && uColors < (1u << iBpp) ? uColors : (1u << iBpp)) : 0;
+
+		Pixels.resize((size_t)iWidth * iHeight);
+		for (int y = 0; y < iHeight; y++)
+		{
+			const unsigned char* pSrc = pData + uOffBits + nStride * (bTopDown ? y : iHeight - 1 - y);
+			for (int x = 0; x < iWidth; x++)
+			{
+				uint32_t uIndex;
+				if (iBpp >= 24)
+				{
+					const unsigned char* c = pSrc + x * (iBpp / 8);
+					Pixels[(size_t)y * iWidth + x] = makePixel(c[2], c[1], c[0]);
+					continue;
+				}
+				else if (iBpp == 8) uIndex = pSrc[x];
+				else if (iBpp == 4) uIndex = (pSrc[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F;
+				else uIndex = (pSrc[x >> 3] >> (7 - (x & 7))) & 0x01;
+
+				const unsigned char* c = pPalette + 4 * (uIndex < uPaletteSize ? uIndex : 0);
+				Pixels[(size_t)y * iWidth + x] = makePixel(c[2], c[1], c[0]);
+			}
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : WriteBmp ()
+	// Desc : Writes a bitmap of random bytes, padding included, with its
+	//		rows stored in either order.
+	//-------------------------------------------------------------------------
+	bool WriteBmp(const char* szFileName, int iWidth, int iHeight, int iBpp, bool bTopDown, CBenchRandom& Rand)
+	{
+		FILE* pFile = fopen(szFileName, "wb");
+		if (!pFile) return false;
+
+		size_t nStride = (((size_t)iWidth * iBpp + 31) / 32) * 4;
+		unsigned int uPalette = iBpp <= 8 ? (1u << iBpp) * 4 : 0;
+		unsigned int uOffBits = 54 + uPalette;
+		unsigned char Header[54] = { 'B', 'M' };
+		unsigned int Fields[][2] = { { 2, uOffBits + (unsigned int)(nStride * iHeight) }, { 10, uOffBits }, { 14, 40 }, { 18, (unsigned int)iWidth },
+									 { 22, (unsigned int)(bTopDown ? -iHeight : iHeight) }, { 26, 1 | ((unsigned int)iBpp << 16) } };
+		for (size_t f = 0; f < sizeof(Fields) / sizeof(Fields[0]); f++)
+			for (int b = 0; b < 4; b++) Header[Fields[f][0] + b] = (unsigned char)(Fields[f][1] >> (8 * b));
+		fwrite(Header, 1, sizeof(Header), pFile);
+
+		std::vector<unsigned char> Bytes(uPalette + nStride * iHeight);
+		for (size_t i = 0; i < Bytes.size(); i++) Bytes[i] = (unsigned char)Rand.Next();
+		fwrite(&Bytes[0], 1, Bytes.size(), pFile);
+		fclose(pFile);
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	// Name : BenchBmp ()
+	// Desc : Loads the game bitmaps and a few made up ones covering every
+	//		depth and row order, the old read and convert per pixel loader
+	//		against the mapped decoder with the scalar and SSSE3 kernels.
+	//		Every result must match the old one, top-down for the surfaces
+	//		and bottom-up without alpha for CImageFile.
+	//-------------------------------------------------------------------------
+	bool BenchBmp(unsigned long ulIterations)
+	{
+		const char*	Files[] = { "Data/spacerrr.bmp", "Data/Background.bmp", "Data/explosion.bmp", "Data/explosionmask.bmp", "Data/PlaneImg.bmp",
+								"Data/leftRotate.bmp", "Data/bullet.bmp", "Data/PlaneMask.bmp", "bench_24_topdown.bmp", "bench_32.bmp",
+								"bench_8.bmp", "bench_4_topdown.bmp", "bench_1.bmp" };
+		const int	FILE_COUNT = sizeof(Files) / sizeof(Files[0]);
+		const int	MADE_UP = 5;
+		unsigned long ulRuns = ulIterations / 10 ? ulIterations / 10 : 1;
+
+		Surface Probe;
+		if (!loadSurfaceFromFile(Files[0], Probe))
+		{
+			printf("bmp: %s not found, run from the GameFramework folder\n", Files[0]);
+			return true;
+		}
+
+		CBenchRandom Rand(2025);
+		const int Made[MADE_UP][4] = { { 37, 29, 24, 1 }, { 53, 31, 32, 0 }, { 143, 17, 8, 0 }, { 37, 23, 4, 1 }, { 53, 19, 1, 0 } };
+		for (int m = 0; m < MADE_UP; m++)
+		{
+			if (!WriteBmp(Files[FILE_COUNT - MADE_UP + m], Made[m][0], Made[m][1], Made[m][2], Made[m][3] != 0, Rand))
+			{
+				printf("cannot write %s\n", Files[FILE_COUNT - MADE_UP + m]);
+				return false;
+			}
+		}
+
+		printf("bmp: %lu loads per file, read and convert / mapped scalar / mapped ssse3%s\n", ulRuns,
+			   isBmpKernelSupported(BMP_SSSE3) ? "" : " (no SSSE3, scalar twice)");
+
+		bool bOk = true;
+		BmpKernel eKernel = getBmpKernel();
+		for (int i = 0; i < FILE_COUNT; i++)
+		{
+			std::vector<uint32_t> Reference;
+			int iWidth = 0, iHeight = 0;
+			BmpFile Bmp;
+			if (!LoadBmpReference(Files[i], Reference, iWidth, iHeight) || !Bmp.open(Files[i]))
+			{
+				printf("  cannot load %s\n", Files[i]);
+				bOk = false;
+				continue;
+			}
+
+			double dTimes[3];
+			bool bSame = true;
+			for (int m = 0; m < 3; m++)
+			{
+				setBmpKernel(m == 2 ? BMP_SSSE3 : BMP_SCALAR);
+
+				Surface Image;
+				std::vector<uint32_t> Pixels;
+				CBenchTimer Timer;
+				for (unsigned long n = 0; n < ulRuns; n++)
+				{
+					if (m == 0) LoadBmpReference(Files[i], Pixels, iWidth, iHeight);
+					else loadSurfaceFromFile(Files[i], Image);
+				}
+				dTimes[m] = Timer.Seconds() / ulRuns;
+
+				for (int y = 0; m > 0 && y < iHeight; y++)
+					bSame = bSame && Image.width() == iWidth && !memcmp(Image.row(y), &Reference[(size_t)y * iWidth], iWidth * sizeof(uint32_t));
+			}
+
+			// The rows CImageFile keeps
+			std::vector<uint32_t> Flipped((size_t)iWidth * iHeight);
+			Bmp.decode(&Flipped[0], iWidth, false, 0);
+			for (int y = 0; y < iHeight; y++)
+				for (int x = 0; x < iWidth; x++)
+					bSame = bSame && Flipped[(size_t)(iHeight - 1 - y) * iWidth + x] == (Reference[(size_t)y * iWidth + x] & 0xFFFFFFu);
+
+			double dPixels = (double)iWidth * iHeight;
+			printf("  %-24s %2d bpp %-9s %4dx%-4d %7.1f / %7.1f / %7.1f Mpixel/s  x%.1f  %s\n", Files[i], Bmp.bitsPerPixel(),
+				   Bmp.topDown() ? "top-down" : "bottom-up", iWidth, iHeight, dPixels / dTimes[0] * 1e-6, dPixels / dTimes[1] * 1e-6,
+				   dPixels / dTimes[2] * 1e-6, dTimes[2] > 0 ? dTimes[0] / dTimes[2] : 0.0, bSame ? "ok" : "MISMATCH");
+			bOk = bOk && bSame;
+		}
+
+		for (int m = 0; m < MADE_UP; m++) remove(Files[FILE_COUNT - MADE_UP + m]);
+		setBmpKernel(eKernel);
+		return bOk;
+	}
+
+	//-------------------------------------------------------------------------
+	// Benchmark table
+	//-------------------------------------------------------------------------
+	struct SBenchmark
+	{
+		const char*	szName;
+		bool		(*pfnRun)(unsigned long ulIterations);
+	};
+
+	const SBenchmark g_Benchmarks[] =
+	{
+		{ "blit", BenchBlit },
+		{ "spans", BenchSpans },
+		{ "assets", BenchAssets },
+		{ "background", BenchBackground },
+		{ "dirty", BenchDirty },
+		{ "tiles", BenchTiles },
+		{ "rotations", BenchRotations },
+		{ "pacer", BenchPacer },
+		{ "histogram", BenchHistogram },
+		{ "projectiles", BenchProjectiles },
+		{ "enemies", BenchEnemies },
+		{ "broadphase", BenchBroadphase },
+		{ "overlap", BenchOverlap },
+		{ "pixels", BenchPixels },
+		{ "sweep", BenchSweep },
+		{ "mixer", BenchMixer },
+		{ "commands", BenchCommands },
+		{ "resample", BenchResample },
+		{ "stream", BenchStream },
+		{ "bmp", BenchBmp },
+	};
+
+	const int BENCHMARK_COUNT = sizeof(g_Benchmarks) / sizeof(g_Benchmarks[0]);
+}
+
+//-----------------------------------------------------------------------------
+// Name : RunBenchmark ()
+// Desc : Runs the named benchmark ("all" runs every one).
+//-----------------------------------------------------------------------------
+bool RunBenchmark(const char* szName, unsigned long ulIterations)
+{
+	bool bAll = !strcmp(szName, "all");
+	bool bFound = false, bOk = true;
+
+	for (int i = 0; i < BENCHMARK_COUNT; i++)
+	{
+		if (!bAll && strcmp(szName, g_Benchmarks[i].szName)) continue;
+
+		bFound = true;
+		bOk = g_Benchmarks[i].pfnRun(ulIterations) && bOk;
+	}
+
+	if (!bFound)
+	{
+		printf("Unknown benchmark '%s'\n", szName);
+		ListBenchmarks();
+	}
+
+	return bFound && bOk;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ListBenchmarks ()
+// Desc : Prints the names of the available benchmarks.
+//-----------------------------------------------------------------------------
+void ListBenchmarks()
+{
+	printf("Benchmarks:");
+	for (int i = 0; i < BENCHMARK_COUNT; i++) printf(" %s", g_Benchmarks[i].szName);
+	printf(" all\n");
+}
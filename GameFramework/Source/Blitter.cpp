@@ -0,0 +1,252 @@
+// Blitter.cpp
+// Sprite compositing kernels for 32-bit surfaces.
+#include "Blitter.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define BLITTER_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 code in functions that ask for it,
+// MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define BLITTER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BLITTER_TARGET_AVX2
+#endif
+
+typedef void (*MaskedRowFn)(uint32_t *dst, const uint32_t *img, const uint32_t *mask, int count);
+
+namespace
+{
+	void maskedRowScalar(uint32_t *dst, const uint32_t *img, const uint32_t *mask, int count)
+	{
+		for( int i = 0; i < count; ++i )
+			dst[i] = (dst[i] & mask[i]) | img[i];
+	}
+
+#ifdef BLITTER_X86
+	void maskedRowSSE2(uint32_t *dst, const uint32_t *img, const uint32_t *mask, int count)
+	{
+		int i = 0;
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i m = _mm_loadu_si128((const __m128i*)(mask + i));
+			__m128i s = _mm_loadu_si128((const __m128i*)(img + i));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(d, m), s));
+		}
+		maskedRowScalar(dst + i, img + i, mask + i, count - i);
+	}
+
+	BLITTER_TARGET_AVX2
+	void maskedRowAVX2(uint32_t *dst, const uint32_t *img, const uint32_t *mask, int count)
+	{
+		int i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			__m256i m = _mm256_loadu_si256((const __m256i*)(mask + i));
+			__m256i s = _mm256_loadu_si256((const __m256i*)(img + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_and_si256(d, m), s));
+		}
+		for( ; i < count; ++i )
+			dst[i] = (dst[i] & mask[i]) | img[i];
+	}
+
+	bool cpuHasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if( info[0] < 7 )
+			return false;
+
+		// AVX2 needs the OS to save the YMM registers (OSXSAVE + XCR0).
+		__cpuid(info, 1);
+		if( !(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) )
+			return false;
+		if( (_xgetbv(0) & 6) != 6 )
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif // BLITTER_X86
+
+	MaskedRowFn gMaskedRow = 0;
+	BlitKernel gKernel = BLIT_SCALAR;
+
+	void selectBestKernel()
+	{
+		if( isBlitKernelSupported(BLIT_AVX2) )
+			setBlitKernel(BLIT_AVX2);
+		else if( isBlitKernelSupported(BLIT_SSE2) )
+			setBlitKernel(BLIT_SSE2);
+		else
+			setBlitKernel(BLIT_SCALAR);
+	}
+}
+
+bool isBlitKernelSupported(BlitKernel kernel)
+{
+	switch( kernel )
+	{
+	case BLIT_SCALAR:
+		return true;
+#ifdef BLITTER_X86
+	case BLIT_SSE2:
+		// Every CPU that runs this game has SSE2.
+		return true;
+	case BLIT_AVX2:
+		{
+			static const bool hasAVX2 = cpuHasAVX2();
+			return hasAVX2;
+		}
+#endif
+	default:
+		return false;
+	}
+}
+
+void setBlitKernel(BlitKernel kernel)
+{
+	if( !isBlitKernelSupported(kernel) )
+		kernel = BLIT_SCALAR;
+
+	switch( kernel )
+	{
+#ifdef BLITTER_X86
+	case BLIT_SSE2: gMaskedRow = maskedRowSSE2; break;
+	case BLIT_AVX2: gMaskedRow = maskedRowAVX2; break;
+#endif
+	default:		gMaskedRow = maskedRowScalar; break;
+	}
+
+	gKernel = kernel;
+}
+
+BlitKernel getBlitKernel()
+{
+	if( !gMaskedRow )
+		selectBestKernel();
+
+	return gKernel;
+}
+
+const char* getBlitKernelName(BlitKernel kernel)
+{
+	switch( kernel )
+	{
+	case BLIT_SCALAR:	return "scalar";
+	case BLIT_SSE2:		return "sse2";
+	case BLIT_AVX2:		return "avx2";
+	default:			return "unknown";
+	}
+}
+
+bool clipBlit(const Surface &dst, int srcWidth, int srcHeight,
+			  int &x, int &y, int &srcX, int &srcY, int &w, int &h)
+{
+	// Keep the source block inside the source image.
+	if( srcX < 0 ) { x -= srcX; w += srcX; srcX = 0; }
+	if( srcY < 0 ) { y -= srcY; h += srcY; srcY = 0; }
+	if( srcX + w > srcWidth ) w = srcWidth - srcX;
+	if( srcY + h > srcHeight ) h = srcHeight - srcY;
+
+	// Then the destination block inside the destination.
+	if( x < 0 ) { srcX -= x; w += x; x = 0; }
+	if( y < 0 ) { srcY -= y; h += y; y = 0; }
+	if( x + w > dst.width() ) w = dst.width() - x;
+	if( y + h > dst.height() ) h = dst.height() - y;
+
+	return w > 0 && h > 0;
+}
+
+void blitMasked(Surface &dst, int x, int y,
+				const Surface &image, const Surface &mask,
+				int srcX, int srcY, int w, int h)
+{
+	if( !clipBlit(dst, image.width(), image.height(), x, y, srcX, srcY, w, h) )
+		return;
+
+	if( !gMaskedRow )
+		selectBestKernel();
+
+	for( int j = 0; j < h; ++j )
+		gMaskedRow(dst.row(y + j) + x, image.row(srcY + j) + srcX, mask.row(srcY + j) + srcX, w);
+}
+
+void SpanList::build(const Surface &image, uint32_t key)
+{
+	clear();
+
+	mHeight = image.height();
+	mRowStart.reserve(mHeight + 1);
+
+	for( int y = 0; y < mHeight; ++y )
+	{
+		const uint32_t *row = image.row(y);
+		mRowStart.push_back((int)mSpans.size());
+
+		for( int x = 0; x < image.width(); )
+		{
+			// Skip the transparent pixels, then take the opaque run.
+			while( x < image.width() && row[x] == key )
+				++x;
+
+			Span span;
+			span.start = x;
+			while( x < image.width() && row[x] != key )
+				++x;
+			span.length = x - span.start;
+
+			if( span.length > 0 )
+				mSpans.push_back(span);
+		}
+	}
+
+	mRowStart.push_back((int)mSpans.size());
+}
+
+void SpanList::clear()
+{
+	mSpans.clear();
+	mRowStart.clear();
+	mHeight = 0;
+}
+
+void blitSpans(Surface &dst, int x, int y,
+			   const Surface &image, const SpanList &spans,
+			   int srcX, int srcY, int w, int h)
+{
+	if( !clipBlit(dst, image.width(), image.height(), x, y, srcX, srcY, w, h) )
+		return;
+
+	int srcRight = srcX + w;
+
+	for( int j = 0; j < h; ++j )
+	{
+		const uint32_t *src = image.row(srcY + j);
+		uint32_t *out = dst.row(y + j) + x - srcX;
+
+		for( const SpanList::Span *span = spans.rowBegin(srcY + j), *end = spans.rowEnd(srcY + j); span != end; ++span )
+		{
+			// Trim the run to the visible columns.
+			int from = span->start > srcX ? span->start : srcX;
+			int to = span->start + span->length < srcRight ? span->start + span->length : srcRight;
+
+			if( from < to )
+				memcpy(out + from, src + from, (to - from) * sizeof(uint32_t));
+		}
+	}
+}
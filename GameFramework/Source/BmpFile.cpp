@@ -0,0 +1,273 @@
+// BmpFile.cpp
+// Uncompressed Windows bitmaps decoded from a mapped file.
+#include "BmpFile.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define BMP_X86 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSSE3 code in functions that ask for it,
+// MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define BMP_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define BMP_TARGET_SSSE3
+#endif
+
+typedef void (*SpreadFn)(const uint8_t *src, uint32_t *dst, int count, uint32_t alpha);
+
+namespace
+{
+	const size_t FILE_HEADER_SIZE = 14;
+	const uint32_t INFO_HEADER_SIZE = 40;		// BITMAPINFOHEADER, later versions extend it
+	const uint32_t COMPRESSION_NONE = 0;		// BI_RGB
+
+	uint32_t readLE(const uint8_t *p, int bytes)
+	{
+		uint32_t v = 0;
+		for( int i = bytes - 1; i >= 0; --i )
+			v = (v << 8) | p[i];
+		return v;
+	}
+
+	// 24 bpp to 32, one pixel at a time. alpha is already in the top byte.
+	void spreadScalar(const uint8_t *src, uint32_t *dst, int count, uint32_t alpha)
+	{
+		for( int x = 0; x < count; ++x, src += 3 )
+			dst[x] = alpha | ((uint32_t)src[2] << 16) | ((uint32_t)src[1] << 8) | src[0];
+	}
+
+#ifdef BMP_X86
+	// Four pixels per shuffle: twelve bytes of B, G, R spread to sixteen,
+	// a zero put in every fourth one and the alpha ORed over it.
+	BMP_TARGET_SSSE3 void spreadSSSE3(const uint8_t *src, uint32_t *dst, int count, uint32_t alpha)
+	{
+		const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i top = _mm_set1_epi32((int)alpha);
+
+		// Every load reads sixteen bytes for the twelve it uses, so the
+		// last one of a step has to end inside the row
+		int x = 0;
+		for( ; x + 18 <= count; x += 16 )
+		{
+			const uint8_t *s = src + x * 3;
+			__m128i p0 = _mm_loadu_si128((const __m128i*)s);
+			__m128i p1 = _mm_loadu_si128((const __m128i*)(s + 12));
+			__m128i p2 = _mm_loadu_si128((const __m128i*)(s + 24));
+			__m128i p3 = _mm_loadu_si128((const __m128i*)(s + 36));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_shuffle_epi8(p0, spread), top));
+			_mm_storeu_si128((__m128i*)(dst + x + 4), _mm_or_si128(_mm_shuffle_epi8(p1, spread), top));
+			_mm_storeu_si128((__m128i*)(dst + x + 8), _mm_or_si128(_mm_shuffle_epi8(p2, spread), top));
+			_mm_storeu_si128((__m128i*)(dst + x + 12), _mm_or_si128(_mm_shuffle_epi8(p3, spread), top));
+		}
+		for( ; x + 6 <= count; x += 4 )
+		{
+			__m128i p = _mm_loadu_si128((const __m128i*)(src + x * 3));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_shuffle_epi8(p, spread), top));
+		}
+
+		spreadScalar(src + x * 3, dst + x, count - x, alpha);
+	}
+
+	bool cpuHasSSSE3()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("ssse3") != 0;
+#endif
+	}
+#endif // BMP_X86
+
+	SpreadFn gSpread = 0;
+	BmpKernel gKernel = BMP_SCALAR;
+
+	SpreadFn spreadFn()
+	{
+		if( !gSpread )
+		{
+			if( isBmpKernelSupported(BMP_SSSE3) )
+				setBmpKernel(BMP_SSSE3);
+			else
+				setBmpKernel(BMP_SCALAR);
+		}
+
+		return gSpread;
+	}
+}
+
+BmpFile::BmpFile()
+	: mPixels(0), mPalette(0), mPaletteSize(0), mStride(0), mWidth(0), mHeight(0), mBitsPerPixel(0), mTopDown(false)
+{
+}
+
+bool BmpFile::open(const char *szFileName)
+{
+	close();
+
+	if( !mFile.open(szFileName) )
+		return false;
+
+	const uint8_t *data = mFile.data();
+	size_t size = mFile.size();
+	if( size < FILE_HEADER_SIZE + INFO_HEADER_SIZE || data[0] != 'B' || data[1] != 'M' )
+	{
+		close();
+		return false;
+	}
+
+	uint32_t offBits = readLE(data + 10, 4);
+	uint32_t infoSize = readLE(data + 14, 4);
+	int32_t width = (int32_t)readLE(data + 18, 4);
+	int32_t height = (int32_t)readLE(data + 22, 4);
+	int bpp = (int)readLE(data + 28, 2);
+	uint32_t compression = readLE(data + 30, 4);
+	uint32_t colorsUsed = readLE(data + 46, 4);
+
+	bool topDown = height < 0;
+	if( topDown )
+		height = -height;
+
+	bool known = bpp == 1 || bpp == 4 || bpp == 8 || bpp == 24 || bpp == 32;
+	if( !known || compression != COMPRESSION_NONE || infoSize < INFO_HEADER_SIZE || width <= 0 || height <= 0 )
+	{
+		close();
+		return false;
+	}
+
+	// The palette follows the info header and ends where the rows start
+	size_t stride = (((size_t)width * bpp + 31) / 32) * 4;
+	size_t paletteOffset = FILE_HEADER_SIZE + infoSize;
+	uint32_t paletteSize = bpp <= 8 ? (colorsUsed && colorsUsed < (1u << bpp) ? colorsUsed : (1u << bpp)) : 0;
+	if( offBits > size || paletteOffset + (size_t)paletteSize * 4 > offBits || (size - offBits) / stride < (size_t)height )
+	{
+		close();
+		return false;
+	}
+
+	mPixels = data + offBits;
+	mPalette = data + paletteOffset;
+	mPaletteSize = (int)paletteSize;
+	mStride = stride;
+	mWidth = width;
+	mHeight = height;
+	mBitsPerPixel = bpp;
+	mTopDown = topDown;
+	return true;
+}
+
+void BmpFile::close()
+{
+	mFile.close();
+	mPixels = mPalette = 0;
+	mPaletteSize = 0;
+	mStride = 0;
+	mWidth = mHeight = mBitsPerPixel = 0;
+	mTopDown = false;
+}
+
+void BmpFile::decode(uint32_t *pixels, int pitch, bool topDown, uint8_t alpha) const
+{
+	if( !mPixels )
+		return;
+
+	const uint32_t top = (uint32_t)alpha << 24;
+
+	// Palette entries as finished pixels, indices past the end give the first
+	uint32_t colors[256];
+	if( mBitsPerPixel <= 8 )
+	{
+		for( int i = 0; i < 256; ++i )
+		{
+			const uint8_t *c = mPalette + 4 * (i < mPaletteSize ? i : 0);
+			colors[i] = top | ((uint32_t)c[2] << 16) | ((uint32_t)c[1] << 8) | c[0];
+		}
+	}
+
+	SpreadFn spread = spreadFn();
+
+	for( int y = 0; y < mHeight; ++y )
+	{
+		// Stored row y lands on row y when both orders agree, else mirrored
+		const uint8_t *src = mPixels + mStride * y;
+		uint32_t *dst = pixels + (ptrdiff_t)pitch * (mTopDown == topDown ? y : mHeight - 1 - y);
+
+		switch( mBitsPerPixel )
+		{
+		case 32:
+			for( int x = 0; x < mWidth; ++x, src += 4 )
+				dst[x] = top | ((uint32_t)src[2] << 16) | ((uint32_t)src[1] << 8) | src[0];
+			break;
+		case 24:
+			spread(src, dst, mWidth, top);
+			break;
+		case 8:
+			for( int x = 0; x < mWidth; ++x )
+				dst[x] = colors[src[x]];
+			break;
+		case 4:
+			for( int x = 0; x < mWidth; ++x )
+				dst[x] = colors[(src[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+			break;
+		default:
+			for( int x = 0; x < mWidth; ++x )
+				dst[x] = colors[(src[x >> 3] >> (7 - (x & 7))) & 0x01];
+			break;
+		}
+	}
+}
+
+bool isBmpKernelSupported(BmpKernel kernel)
+{
+	switch( kernel )
+	{
+	case BMP_SCALAR:
+		return true;
+#ifdef BMP_X86
+	case BMP_SSSE3:
+		return cpuHasSSSE3();
+#endif
+	default:
+		return false;
+	}
+}
+
+void setBmpKernel(BmpKernel kernel)
+{
+	if( !isBmpKernelSupported(kernel) )
+		kernel = BMP_SCALAR;
+
+	switch( kernel )
+	{
+#ifdef BMP_X86
+	case BMP_SSSE3:	gSpread = spreadSSSE3; break;
+#endif
+	default:		gSpread = spreadScalar; break;
+	}
+
+	gKernel = kernel;
+}
+
+BmpKernel getBmpKernel()
+{
+	spreadFn();
+	return gKernel;
+}
+
+const char* getBmpKernelName(BmpKernel kernel)
+{
+	switch( kernel )
+	{
+	case BMP_SCALAR:	return "scalar";
+	case BMP_SSSE3:		return "ssse3";
+	default:			return "unknown";
+	}
+}
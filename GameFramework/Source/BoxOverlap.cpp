@@ -0,0 +1,323 @@
+// BoxOverlap.cpp
+// Batch overlap tests of axis aligned boxes.
+#include "BoxOverlap.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define OVERLAP_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX code in functions that ask for it,
+// MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define OVERLAP_TARGET_AVX __attribute__((target("avx")))
+#else
+#define OVERLAP_TARGET_AVX
+#endif
+
+typedef int (*OverlapMaskFn)(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits);
+
+namespace
+{
+	// Bits set in each value of a nibble.
+	const int NIBBLE_BITS[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	// Boxes tested per block by overlapIndices and overlapPairs, the hits
+	// of a block fit on the stack.
+	const int INDEX_BLOCK = 1024;
+
+	int lowestBit(uint32_t bits)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return (int)index;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+
+	int overlapMaskScalar(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits)
+	{
+		int found = 0;
+		for( int i = 0; i < boxes.count; ++i )
+		{
+			if( boxesOverlap(left, top, right, bottom, boxes.left[i], boxes.top[i], boxes.right[i], boxes.bottom[i]) )
+			{
+				hits[i >> 5] |= 1u << (i & 31);
+				++found;
+			}
+		}
+		return found;
+	}
+
+#ifdef OVERLAP_X86
+	// The comparisons are "not less than", true when either side is a NaN
+	// like the negated tests of boxesOverlap().
+	int overlapMaskSSE2(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits)
+	{
+		__m128 l = _mm_set1_ps(left);
+		__m128 t = _mm_set1_ps(top);
+		__m128 r = _mm_set1_ps(right);
+		__m128 b = _mm_set1_ps(bottom);
+
+		int found = 0;
+		int i = 0;
+		for( ; i + 4 <= boxes.count; i += 4 )
+		{
+			__m128 x = _mm_and_ps(_mm_cmpnlt_ps(r, _mm_loadu_ps(boxes.left + i)),
+								  _mm_cmpnlt_ps(_mm_loadu_ps(boxes.right + i), l));
+			__m128 y = _mm_and_ps(_mm_cmpnlt_ps(b, _mm_loadu_ps(boxes.top + i)),
+								  _mm_cmpnlt_ps(_mm_loadu_ps(boxes.bottom + i), t));
+
+			uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_and_ps(x, y));
+			hits[i >> 5] |= bits << (i & 31);
+			found += NIBBLE_BITS[bits];
+		}
+
+		for( ; i < boxes.count; ++i )
+		{
+			if( boxesOverlap(left, top, right, bottom, boxes.left[i], boxes.top[i], boxes.right[i], boxes.bottom[i]) )
+			{
+				hits[i >> 5] |= 1u << (i & 31);
+				++found;
+			}
+		}
+		return found;
+	}
+
+	OVERLAP_TARGET_AVX
+	int overlapMaskAVX(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits)
+	{
+		__m256 l = _mm256_set1_ps(left);
+		__m256 t = _mm256_set1_ps(top);
+		__m256 r = _mm256_set1_ps(right);
+		__m256 b = _mm256_set1_ps(bottom);
+
+		int found = 0;
+		int i = 0;
+		for( ; i + 8 <= boxes.count; i += 8 )
+		{
+			__m256 x = _mm256_and_ps(_mm256_cmp_ps(r, _mm256_loadu_ps(boxes.left + i), _CMP_NLT_UQ),
+									 _mm256_cmp_ps(_mm256_loadu_ps(boxes.right + i), l, _CMP_NLT_UQ));
+			__m256 y = _mm256_and_ps(_mm256_cmp_ps(b, _mm256_loadu_ps(boxes.top + i), _CMP_NLT_UQ),
+									 _mm256_cmp_ps(_mm256_loadu_ps(boxes.bottom + i), t, _CMP_NLT_UQ));
+
+			uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(x, y));
+			hits[i >> 5] |= bits << (i & 31);
+			found += NIBBLE_BITS[bits & 15] + NIBBLE_BITS[bits >> 4];
+		}
+
+		for( ; i < boxes.count; ++i )
+		{
+			if( boxesOverlap(left, top, right, bottom, boxes.left[i], boxes.top[i], boxes.right[i], boxes.bottom[i]) )
+			{
+				hits[i >> 5] |= 1u << (i & 31);
+				++found;
+			}
+		}
+		return found;
+	}
+
+	bool cpuHasAVX()
+	{
+#ifdef _MSC_VER
+		// AVX needs the OS to save the YMM registers (OSXSAVE + XCR0).
+		int info[4];
+		__cpuid(info, 1);
+		if( !(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) )
+			return false;
+		return (_xgetbv(0) & 6) == 6;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") != 0;
+#endif
+	}
+#endif // OVERLAP_X86
+
+	// Narrows [enter, leave] to the part of the move where the spans
+	// [center - half, center + half] moving by d and [min, max] overlap on
+	// one axis. False when they never do.
+	bool sweepAxis(float center, float half, float d, float min, float max, float &enter, float &leave)
+	{
+		// The span of the other box grown by the half size of the moving one
+		min -= half;
+		max += half;
+
+		if( d == 0 )
+			return !(center < min || max < center);
+
+		float t0 = (min - center) / d;
+		float t1 = (max - center) / d;
+		if( t0 > t1 )
+		{
+			float t = t0;
+			t0 = t1;
+			t1 = t;
+		}
+
+		if( t0 > enter ) enter = t0;
+		if( t1 < leave ) leave = t1;
+		return enter <= leave;
+	}
+
+	OverlapMaskFn gOverlapMask = 0;
+	OverlapKernel gKernel = OVERLAP_SCALAR;
+
+	OverlapMaskFn overlapMaskFn()
+	{
+		if( !gOverlapMask )
+		{
+			if( isOverlapKernelSupported(OVERLAP_AVX) )
+				setOverlapKernel(OVERLAP_AVX);
+			else if( isOverlapKernelSupported(OVERLAP_SSE2) )
+				setOverlapKernel(OVERLAP_SSE2);
+			else
+				setOverlapKernel(OVERLAP_SCALAR);
+		}
+
+		return gOverlapMask;
+	}
+}
+
+bool sweepBoxes(float left1, float top1, float right1, float bottom1, float dx, float dy,
+				float left2, float top2, float right2, float bottom2, float &enter, float &leave)
+{
+	float t0 = 0, t1 = 1;
+	if( !sweepAxis((left1 + right1) * 0.5f, (right1 - left1) * 0.5f, dx, left2, right2, t0, t1) ||
+		!sweepAxis((top1 + bottom1) * 0.5f, (bottom1 - top1) * 0.5f, dy, top2, bottom2, t0, t1) )
+		return false;
+
+	enter = t0;
+	leave = t1;
+	return true;
+}
+
+int overlapMask(float left, float top, float right, float bottom, const BoxList &boxes, uint32_t *hits)
+{
+	if( boxes.count <= 0 )
+		return 0;
+
+	memset(hits, 0, ((boxes.count + 31) / 32) * sizeof(uint32_t));
+	return overlapMaskFn()(left, top, right, bottom, boxes, hits);
+}
+
+int overlapIndices(float left, float top, float right, float bottom, const BoxList &boxes, int *indices)
+{
+	OverlapMaskFn fn = overlapMaskFn();
+	uint32_t hits[INDEX_BLOCK / 32];
+	int found = 0;
+
+	for( int first = 0; first < boxes.count; first += INDEX_BLOCK )
+	{
+		int count = boxes.count - first < INDEX_BLOCK ? boxes.count - first : INDEX_BLOCK;
+		BoxList block = { boxes.left + first, boxes.top + first, boxes.right + first, boxes.bottom + first, count };
+
+		int words = (count + 31) / 32;
+		memset(hits, 0, words * sizeof(uint32_t));
+		if( !fn(left, top, right, bottom, block, hits) )
+			continue;
+
+		for( int w = 0; w < words; ++w )
+		{
+			for( uint32_t bits = hits[w]; bits; bits &= bits - 1 )
+				indices[found++] = first + w * 32 + lowestBit(bits);
+		}
+	}
+
+	return found;
+}
+
+int overlapPairs(const BoxList &a, const BoxList &b, std::vector<OverlapPair> &pairs)
+{
+	OverlapMaskFn fn = overlapMaskFn();
+	uint32_t hits[INDEX_BLOCK / 32];
+	size_t first = pairs.size();
+
+	for( int i = 0; i < a.count; ++i )
+	{
+		for( int start = 0; start < b.count; start += INDEX_BLOCK )
+		{
+			int count = b.count - start < INDEX_BLOCK ? b.count - start : INDEX_BLOCK;
+			BoxList block = { b.left + start, b.top + start, b.right + start, b.bottom + start, count };
+
+			int words = (count + 31) / 32;
+			memset(hits, 0, words * sizeof(uint32_t));
+			if( !fn(a.left[i], a.top[i], a.right[i], a.bottom[i], block, hits) )
+				continue;
+
+			for( int w = 0; w < words; ++w )
+			{
+				for( uint32_t bits = hits[w]; bits; bits &= bits - 1 )
+				{
+					OverlapPair pair;
+					pair.a = i;
+					pair.b = start + w * 32 + lowestBit(bits);
+					pairs.push_back(pair);
+				}
+			}
+		}
+	}
+
+	return (int)(pairs.size() - first);
+}
+
+bool isOverlapKernelSupported(OverlapKernel kernel)
+{
+	switch( kernel )
+	{
+	case OVERLAP_SCALAR:
+		return true;
+#ifdef OVERLAP_X86
+	case OVERLAP_SSE2:
+		// Every CPU that runs this game has SSE2.
+		return true;
+	case OVERLAP_AVX:
+		{
+			static const bool hasAVX = cpuHasAVX();
+			return hasAVX;
+		}
+#endif
+	default:
+		return false;
+	}
+}
+
+void setOverlapKernel(OverlapKernel kernel)
+{
+	if( !isOverlapKernelSupported(kernel) )
+		kernel = OVERLAP_SCALAR;
+
+	switch( kernel )
+	{
+#ifdef OVERLAP_X86
+	case OVERLAP_SSE2:	gOverlapMask = overlapMaskSSE2; break;
+	case OVERLAP_AVX:	gOverlapMask = overlapMaskAVX; break;
+#endif
+	default:			gOverlapMask = overlapMaskScalar; break;
+	}
+
+	gKernel = kernel;
+}
+
+OverlapKernel getOverlapKernel()
+{
+	overlapMaskFn();
+	return gKernel;
+}
+
+const char* getOverlapKernelName(OverlapKernel kernel)
+{
+	switch( kernel )
+	{
+	case OVERLAP_SCALAR:	return "scalar";
+	case OVERLAP_SSE2:		return "sse2";
+	case OVERLAP_AVX:		return "avx";
+	default:				return "unknown";
+	}
+}
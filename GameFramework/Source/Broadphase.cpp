@@ -0,0 +1,264 @@
+// Broadphase.cpp
+// Uniform grid rebuilt every step.
+#include "Broadphase.h"
+#include "BoxOverlap.h"
+#include <math.h>
+#include <string.h>
+
+Broadphase::Broadphase(float left, float top, float right, float bottom, float cellSize, int layers)
+	: mLeft(left), mTop(top), mCellSize(cellSize), mLayers(layers)
+{
+	if( mLayers < 1 ) mLayers = 1;
+	if( mLayers > MAX_LAYERS ) mLayers = MAX_LAYERS;
+
+	if( mCellSize < 1 )
+		mCellSize = 1;
+
+	mInvCellSize = 1.0f / mCellSize;
+	mColumns = (int)ceil((right - left) * mInvCellSize);
+	mRows = (int)ceil((bottom - top) * mInvCellSize);
+	if( mColumns < 1 ) mColumns = 1;
+	if( mRows < 1 ) mRows = 1;
+
+	mRunStart.resize(mColumns * mRows * mLayers + 1);
+	memset(mInteractions, 0, sizeof(mInteractions));
+	for( int l = 0; l < mLayers; ++l )
+		mInteractions[l] = mLayers == MAX_LAYERS ? 0xFFFFFFFFu : (1u << mLayers) - 1;
+	clear();
+}
+
+void Broadphase::clear()
+{
+	mBoxLeft.clear();
+	mBoxTop.clear();
+	mBoxRight.clear();
+	mBoxBottom.clear();
+	mBoxId.clear();
+	mBoxLayer.clear();
+	for( int i = 0; i < 4; ++i )
+		mBoxCells[i].clear();
+
+	memset(&mStats, 0, sizeof(mStats));
+	mStats.cells = mColumns * mRows;
+}
+
+void Broadphase::setInteraction(int layerA, int layerB, bool interact)
+{
+	layerA = layerIndex(layerA);
+	layerB = layerIndex(layerB);
+
+	if( interact )
+	{
+		mInteractions[layerA] |= 1u << layerB;
+		mInteractions[layerB] |= 1u << layerA;
+	}
+	else
+	{
+		mInteractions[layerA] &= ~(1u << layerB);
+		mInteractions[layerB] &= ~(1u << layerA);
+	}
+}
+
+void Broadphase::clearInteractions()
+{
+	memset(mInteractions, 0, sizeof(mInteractions));
+}
+
+// Truncating is flooring here, anything left of the grid goes to 0.
+int Broadphase::column(float x) const
+{
+	int c = (int)((x - mLeft) * mInvCellSize);
+	return c < 0 ? 0 : c >= mColumns ? mColumns - 1 : c;
+}
+
+int Broadphase::row(float y) const
+{
+	int r = (int)((y - mTop) * mInvCellSize);
+	return r < 0 ? 0 : r >= mRows ? mRows - 1 : r;
+}
+
+void Broadphase::add(int id, int layer, float left, float top, float right, float bottom)
+{
+	layer = layerIndex(layer);
+	if( !mInteractions[layer] )
+		return;
+
+	mBoxLeft.push_back(left);
+	mBoxTop.push_back(top);
+	mBoxRight.push_back(right);
+	mBoxBottom.push_back(bottom);
+	mBoxId.push_back(id);
+	mBoxLayer.push_back((unsigned char)layer);
+
+	mBoxCells[0].push_back((unsigned short)column(left));
+	mBoxCells[1].push_back((unsigned short)row(top));
+	mBoxCells[2].push_back((unsigned short)column(right));
+	mBoxCells[3].push_back((unsigned short)row(bottom));
+}
+
+void Broadphase::addCentered(int id, int layer, float x, float y, float width, float height)
+{
+	float hw = width * 0.5f;
+	float hh = height * 0.5f;
+	add(id, layer, x - hw, y - hh, x + hw, y + hh);
+}
+
+void Broadphase::build()
+{
+	int cells = mColumns * mRows;
+	int boxes = (int)mBoxId.size();
+
+	// Count the entries of each run one slot ahead, the running sum then
+	// turns the counts into the first index of every run.
+	memset(mRunStart.data(), 0, mRunStart.size() * sizeof(int));
+	memset(mLayerStart, 0, sizeof(mLayerStart));
+
+	for( int i = 0; i < boxes; ++i )
+	{
+		int layer = mBoxLayer[i];
+		++mLayerStart[layer + 1];
+		for( int r = mBoxCells[1][i]; r <= mBoxCells[3][i]; ++r )
+			for( int c = mBoxCells[0][i]; c <= mBoxCells[2][i]; ++c )
+				++mRunStart[(r * mColumns + c) * mLayers + layer + 1];
+	}
+
+	mStats.boxes = boxes;
+	mStats.occupiedCells = 0;
+	mStats.maxCellEntries = 0;
+	for( int c = 0; c < cells; ++c )
+	{
+		int *run = &mRunStart[c * mLayers];
+		int first = run[0];
+		for( int l = 0; l < mLayers; ++l )
+			run[l + 1] += run[l];
+
+		int count = run[mLayers] - first;
+		if( count )
+			++mStats.occupiedCells;
+		if( count > mStats.maxCellEntries )
+			mStats.maxCellEntries = count;
+	}
+	mStats.entries = mRunStart[cells * mLayers];
+	if( (int)mHits.size() < mStats.maxCellEntries )
+		mHits.resize(mStats.maxCellEntries);
+
+	for( int l = 0; l < mLayers; ++l )
+		mLayerStart[l + 1] += mLayerStart[l];
+
+	// Copy every box into its runs and its layer.
+	int entries = mStats.entries;
+	mEntryLeft.resize(entries);
+	mEntryTop.resize(entries);
+	mEntryRight.resize(entries);
+	mEntryBottom.resize(entries);
+	mEntryBox.resize(entries);
+	mCursor.assign(mRunStart.begin(), mRunStart.end() - 1);
+
+	for( int i = 0; i < boxes; ++i )
+	{
+		for( int r = mBoxCells[1][i]; r <= mBoxCells[3][i]; ++r )
+		{
+			for( int c = mBoxCells[0][i]; c <= mBoxCells[2][i]; ++c )
+			{
+				int e = mCursor[(r * mColumns + c) * mLayers + mBoxLayer[i]]++;
+				mEntryLeft[e] = mBoxLeft[i];
+				mEntryTop[e] = mBoxTop[i];
+				mEntryRight[e] = mBoxRight[i];
+				mEntryBottom[e] = mBoxBottom[i];
+				mEntryBox[e] = i;
+			}
+		}
+	}
+
+	mLayerBoxes.resize(boxes);
+	mCursor.assign(mLayerStart, mLayerStart + mLayers);
+	for( int i = 0; i < boxes; ++i )
+		mLayerBoxes[mCursor[mBoxLayer[i]]++] = i;
+}
+
+int Broadphase::query(int layerA, int layerB, std::vector<BroadphasePair> &pairs)
+{
+	size_t first = pairs.size();
+	layerA = layerIndex(layerA);
+	layerB = layerIndex(layerB);
+	if( !interacts(layerA, layerB) )
+		return 0;
+
+	bool same = layerA == layerB;
+	++mStats.layerPairs;
+
+	// Walk the smaller layer, look for the other one in its cells.
+	bool swapped = mLayerStart[layerA + 1] - mLayerStart[layerA] > mLayerStart[layerB + 1] - mLayerStart[layerB];
+	int walked = swapped ? layerB : layerA;
+	int other = swapped ? layerA : layerB;
+
+	unsigned long tested = 0;
+	int *hits = mHits.data();
+
+	for( int k = mLayerStart[walked]; k < mLayerStart[walked + 1]; ++k )
+	{
+		int a = mLayerBoxes[k];
+		float left = mBoxLeft[a], top = mBoxTop[a], right = mBoxRight[a], bottom = mBoxBottom[a];
+
+		for( int r = mBoxCells[1][a]; r <= mBoxCells[3][a]; ++r )
+		{
+			for( int c = mBoxCells[0][a]; c <= mBoxCells[2][a]; ++c )
+			{
+				const int *run = &mRunStart[(r * mColumns + c) * mLayers + other];
+				int begin = run[0];
+				BoxList boxes = { mEntryLeft.data() + begin, mEntryTop.data() + begin, mEntryRight.data() + begin,
+								  mEntryBottom.data() + begin, run[1] - begin };
+				tested += boxes.count;
+
+				int found = overlapIndices(left, top, right, bottom, boxes, hits);
+				for( int h = 0; h < found; ++h )
+				{
+					int e = begin + hits[h];
+					int b = mEntryBox[e];
+					if( same && b <= a )
+						continue;
+
+					// A pair sharing several cells is reported by the one
+					// holding the top left corner of the overlap only.
+					float overlapLeft = left > mEntryLeft[e] ? left : mEntryLeft[e];
+					float overlapTop = top > mEntryTop[e] ? top : mEntryTop[e];
+					if( column(overlapLeft) != c || row(overlapTop) != r )
+						continue;
+
+					BroadphasePair pair;
+					pair.a = mBoxId[swapped ? b : a];
+					pair.b = mBoxId[swapped ? a : b];
+					pair.layerA = layerA;
+					pair.layerB = layerB;
+					pairs.push_back(pair);
+				}
+			}
+		}
+	}
+
+	mStats.pairsTested += tested;
+
+	int found = (int)(pairs.size() - first);
+	mStats.pairsFound += found;
+	return found;
+}
+
+int Broadphase::queryInteracting(std::vector<BroadphasePair> &pairs)
+{
+	size_t first = pairs.size();
+
+	for( int a = 0; a < mLayers; ++a )
+	{
+		if( mLayerStart[a] == mLayerStart[a + 1] )
+			continue;
+
+		// Layers from a on that interact with it and hold boxes
+		for( int b = a; b < mLayers; ++b )
+		{
+			if( ((mInteractions[a] >> b) & 1) && mLayerStart[b] != mLayerStart[b + 1] )
+				query(a, b, pairs);
+		}
+	}
+
+	return (int)(pairs.size() - first);
+}
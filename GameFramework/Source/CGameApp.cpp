@@ -18,6 +18,21 @@
 extern HINSTANCE g_hInst;
 
 using namespace std;
+
+//-----------------------------------------------------------------------------
+// Module Local Constants
+//-----------------------------------------------------------------------------
+namespace
+{
+	// Frame rate limit when the display does not report its refresh rate
+	const int	DEFAULT_REFRESH_RATE = 60;
+
+	// Longest frame simulated in full. After a stall (window dragged,
+	// debugger break) the game slows down instead of running hundreds of
+	// steps to catch up.
+	const float MAX_FRAME_TIME = 0.25f;
+}
+
 //-----------------------------------------------------------------------------
 // CGameApp Member Functions
 //-----------------------------------------------------------------------------
@@ -32,9 +47,10 @@ CGameApp::CGameApp()
 	m_hIcon			= NULL;
 	m_hMenu			= NULL;
 	m_pBBuffer		= NULL;
-	m_pPlayer		= NULL;
-	m_pPlayer2      = nullptr;
 	m_LastFrameRate = 0;
+	m_LastFrameP99	= 0;
+	m_fStepTime		= 0.0f;
+	m_fFrameRateLimit = (float)DEFAULT_REFRESH_RATE;
 }
 
 //-----------------------------------------------------------------------------
@@ -140,9 +156,14 @@ int CGameApp::BeginGame()
 			TranslateMessage( &msg );
 			DispatchMessage ( &msg );
 		} 
+		else if ( !m_bActive )
+		{
+			// Minimized, sleep until something happens to the window
+			WaitMessage();
+		}
 		else 
 		{
-			// Advance Game Frame.
+			// Advance Game Frame (sleeps out the rest of the frame).
 			FrameAdvance();
 
 		} // End If messages waiting
@@ -205,8 +226,6 @@ LRESULT CALLBACK CGameApp::StaticWndProc(HWND hWnd, UINT Message, WPARAM wParam,
 //-----------------------------------------------------------------------------
 LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM lParam )
 {
-	static UINT			fTimer;	
-
 	// Determine message type
 	switch (Message)
 	{
@@ -221,7 +240,14 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 			PostQuitMessage(0);
 			break;
 		
+		case WM_PAINT:
+			// Part of the window was uncovered, the next frame shows all of it
+			if ( m_pBBuffer ) m_pBBuffer->invalidate();
+			return DefWindowProc(hWnd, Message, wParam, lParam);
+
 		case WM_SIZE:
+			if ( m_pBBuffer ) m_pBBuffer->invalidate();
+
 			if ( wParam == SIZE_MINIMIZED )
 			{
 				// App is inactive
@@ -260,52 +286,38 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 				PostQuitMessage(0);
 				break;
 			case VK_RETURN:
-				fTimer = SetTimer(m_hWnd, 1, 70, NULL);
-				m_pPlayer->Explode();
+				m_Input.Players[0].bExplode = true;
 				break;
 			case 'Q':
-				fTimer = SetTimer(m_hWnd, 1, 70, NULL);
-				m_pPlayer2->Explode();
+				m_Input.Players[1].bExplode = true;
 				break;
 			case 'H':
-				m_pPlayer2->Shoot2();
+				m_Input.Players[1].bFire = true;
 				break;
 			case VK_SPACE:
-				m_pPlayer->Shoot();
+				m_Input.Players[0].bFire = true;
 				break;
 			case 'N':
-				m_pPlayer->RotateLeft();
+				m_Input.Players[0].bRotateLeft = true;
 				break;
 			case 'M':
-				m_pPlayer->RotateRight();
+				m_Input.Players[0].bRotateRight = true;
 				break;
 			case 'R':
-				m_pPlayer2->RotateLeft();
+				m_Input.Players[1].bRotateLeft = true;
 				break;
 			case 'T':
-				m_pPlayer2->RotateRight();
+				m_Input.Players[1].bRotateRight = true;
 				break;
 			case 'Z':
 				Save_game();
 				break;
 			case 'X':
-				fTimer = SetTimer(m_hWnd, 1, 70, NULL);
 				Load_game();
 				break;
 			}
 			break;
 
-		case WM_TIMER:
-			switch(wParam)
-			{
-			case 1:
-				if(!m_pPlayer->AdvanceExplosion())
-					KillTimer(m_hWnd, 1);
-				if (!m_pPlayer2->AdvanceExplosion())
-					KillTimer(m_hWnd, 1);
-			}
-			break;
-
 		case WM_COMMAND:
 			break;
 
@@ -324,17 +336,27 @@ LRESULT CGameApp::DisplayWndProc( HWND hWnd, UINT Message, WPARAM wParam, LPARAM
 bool CGameApp::BuildObjects()
 {
 	m_pBBuffer = new BackBuffer(m_hWnd, m_nViewWidth, m_nViewHeight);
-	m_pPlayer = new CPlayer(m_pBBuffer);
-	m_pPlayer->lives = 3;
-	m_pPlayer2 = new CPlayer(m_pBBuffer);
-	m_pPlayer2->lives = 3;
 
-	
-	if(!m_imgBackground.LoadBitmapFromFile("data/spacerrr.bmp", GetDC(m_hWnd)))
-		return false;
-	if (!m_imgBackground1.LoadBitmapFromFile("data/copy.bmp", GetDC(m_hWnd)))
+	if (!m_Renderer.Load())
 		return false;
 
+	// Composite the sprites on every core
+	m_Renderer.SetRenderThreads(TileRenderer::hardwareThreads());
+
+	// Collide with the sizes of the images we draw
+	m_Renderer.ApplySpriteSizes(m_World);
+
+	// Mix on the sound card, or nowhere without one
+	if (!m_Audio.Load(createAudioOutput(AudioEngine::BLOCK_FRAMES)))
+		m_Audio.Load(new NullAudioOutput());
+
+	// Frames the display cannot show are not worth drawing (0 and 1 mean
+	// the default rate of the hardware)
+	HDC hDC = GetDC(m_hWnd);
+	int iRefreshRate = GetDeviceCaps(hDC, VREFRESH);
+	ReleaseDC(m_hWnd, hDC);
+	m_fFrameRateLimit = (float)(iRefreshRate > 1 ? iRefreshRate : DEFAULT_REFRESH_RATE);
+
 	// Success!
 	return true;
 }
@@ -345,11 +367,7 @@ bool CGameApp::BuildObjects()
 //-----------------------------------------------------------------------------
 void CGameApp::SetupGameState()
 {
-	m_pPlayer->Position() = Vec2(1300, 500);
-	m_pPlayer2->Position() = Vec2(100, 500);
-	m_pPlayer2->RotateRight();
-	m_pPlayer->RotateLeft();
-
+	m_World.Reset();
 }
 
 //-----------------------------------------------------------------------------
@@ -359,21 +377,49 @@ void CGameApp::SetupGameState()
 //-----------------------------------------------------------------------------
 void CGameApp::ReleaseObjects( )
 {
-	if(m_pPlayer != NULL)
+	// Report how well the image cache did before letting the images go
+	const ImageCache& Images = m_Renderer.Images();
+	TCHAR szStats[ 256 ];
+	sprintf_s( szStats, _T("Image cache: %lu hits, %lu misses, %lu images, %lu KB resident\n"),
+			   Images.hits(), Images.misses(), (ULONG)Images.size(), (ULONG)(Images.residentBytes() / 1024) );
+	OutputDebugString( szStats );
+	m_Renderer.Release();
+
+	// Report what mixing cost before stopping the engine
+	AudioStats Audio = m_Audio.Engine().stats();
+	sprintf_s( szStats, _T("Audio: %lu blocks, mix p99 %.1f us (%.2f%% of a block), %d voices at most, %lu sounds, %lu KB resident\n"),
+			   Audio.blocks, Audio.mixTimes.percentile( 99 ) * 1e6, Audio.mixTimes.percentile( 99 ) / AudioEngine::blockSeconds() * 100.0,
+			   Audio.peakVoices, (ULONG)m_Audio.Sounds().size(), (ULONG)(m_Audio.Sounds().residentBytes() / 1024) );
+	OutputDebugString( szStats );
+	sprintf_s( szStats, _T("Audio: %lu requests applied, %d queued at most, %lu overflowed\n"),
+			   Audio.commands, m_Audio.Engine().peakCommandDepth(), m_Audio.Engine().commandOverflows() );
+	OutputDebugString( szStats );
+	m_Audio.Release();
+
+	if(m_pBBuffer != NULL && m_pBBuffer->stats().frames)
 	{
-		delete m_pPlayer;
-		m_pPlayer = NULL;
-	}
-	if (m_pPlayer2 != NULL)
-	{
-		delete m_pPlayer2;
-		m_pPlayer2 = NULL;
+		const BackBuffer::Stats& Stats = m_pBBuffer->stats();
+		sprintf_s( szStats, _T("Back buffer: %lu frames, %lu full, %lu pixels cleared / %lu presented per frame\n"),
+				   Stats.frames, Stats.fullFrames, (ULONG)(Stats.totalCleared / Stats.frames), (ULONG)(Stats.totalPresented / Stats.frames) );
+		OutputDebugString( szStats );
 	}
+
 	if(m_pBBuffer != NULL)
 	{
 		delete m_pBBuffer;
 		m_pBBuffer = NULL;
 	}
+
+	// Frame time percentiles of the whole run, per phase
+	const FrameProfiler& Profiler = m_Timer.Profiler();
+	for ( int i = 0; i < FrameProfiler::PHASE_COUNT; i++ )
+	{
+		const FrameHistogram& Times = Profiler.total( (FrameProfiler::Phase)i );
+		sprintf_s( szStats, _T("%-10s: p50 %.2f ms, p99 %.2f ms, max %.2f ms over %u frames\n"), FrameProfiler::phaseName( (FrameProfiler::Phase)i ),
+				   Times.percentile( 50 ) * 1000.0, Times.percentile( 99 ) * 1000.0, Times.maximum() * 1000.0, Times.count() );
+		OutputDebugString( szStats );
+	}
+	Profiler.writeCsv( "frametimes.csv" );
 }
 
 //-----------------------------------------------------------------------------
@@ -385,36 +431,35 @@ void CGameApp::FrameAdvance()
 	static TCHAR FrameRate[ 50 ];
 	static TCHAR TitleBuffer[ 255 ];
 
-	// Advance the timer
-	m_Timer.Tick( );
+	// Advance the timer, no faster than the display shows frames
+	m_Timer.Tick( m_fFrameRateLimit );
 
 	// Skip if app is inactive
 	if ( !m_bActive ) return;
 	
-	// Get / Display the framerate
-	if ( m_LastFrameRate != m_Timer.GetFrameRate() )
+	// Get / Display the framerate, and the frame time 99% of the recent
+	// frames beat, which is what hitches show up in
+	FrameProfiler& Profiler = m_Timer.Profiler();
+	ULONG FrameP99 = (ULONG)(Profiler.window( FrameProfiler::PHASE_FRAME ).percentile( 99 ) * 10000.0);
+	if ( m_LastFrameRate != m_Timer.GetFrameRate() || m_LastFrameP99 != FrameP99 )
 	{
 		m_LastFrameRate = m_Timer.GetFrameRate( FrameRate, 50 );
-		sprintf_s( TitleBuffer, _T("Game : %s  Lives: %d - %d"), FrameRate, m_pPlayer2->lives, m_pPlayer->lives );
+		m_LastFrameP99	= FrameP99;
+		sprintf_s( TitleBuffer, _T("Game : %s  p99 %.1f ms  Lives: %d - %d"), FrameRate, FrameP99 / 10.0,
+				   m_World.Player(1).lives, m_World.Player(0).lives );
 		SetWindowText( m_hWnd, TitleBuffer );
 
 	} // End if Frame Rate Altered
 
-	if (m_pPlayer->lives == 0) {
-		MessageBox(0, "BOZGORII CASTIGA", "GAME OVER", MB_OK);
-		PostQuitMessage(0);
-	}
-
-	else if (m_pPlayer2->lives == 0) {
-		MessageBox(0, "VADIM CASTIGA", "GAME OVER", MB_OK);
-		PostQuitMessage(0);
-	}
-
 	// Poll & Process input devices
+	Profiler.begin( FrameProfiler::PHASE_INPUT );
 	ProcessInput();
+	Profiler.end( FrameProfiler::PHASE_INPUT );
 
-	// Animate the game objects
+	// Animate the game objects (and present what happened on every step)
+	Profiler.begin( FrameProfiler::PHASE_SIMULATION );
 	AnimateObjects();
+	Profiler.end( FrameProfiler::PHASE_SIMULATION );
 
 	// Drawing the game objects
 	DrawObjects();
@@ -446,9 +491,9 @@ void CGameApp::ProcessInput( )
 	if (pKeyBuffer['A'] & 0xF0) DirectionP2 |= CPlayer::DIR_LEFT;
 	if (pKeyBuffer['D'] & 0xF0) DirectionP2 |= CPlayer::DIR_RIGHT;
 
-	// Move the player
-	m_pPlayer->Move(Direction);
-	m_pPlayer2->Move(DirectionP2);
+	// Held keys move the players on the next step
+	m_Input.Players[0].ulDirection = Direction;
+	m_Input.Players[1].ulDirection = DirectionP2;
 
 
 	// Now process the mouse (if the button is pressed)
@@ -466,62 +511,67 @@ void CGameApp::ProcessInput( )
 	} // End if Captured
 }
 
-void CGameApp::DrawBackground()
+//-----------------------------------------------------------------------------
+// Name : AnimateObjects () (Private)
+// Desc : Animates the objects we currently have loaded. The world runs as
+//		many fixed steps as fit in the time the frame took, so the game
+//		speed does not depend on the frame rate. What is left over carries
+//		to the next frame.
+//-----------------------------------------------------------------------------
+void CGameApp::AnimateObjects()
 {
-	static int currentY0 = 0;
-	static int currentY1 = m_imgBackground.Width();
-
-	static size_t lastTime = GetTickCount();
-	size_t currentTime = GetTickCount();
+	float fFrameTime = m_Timer.GetFrameTime();
+	if (fFrameTime > MAX_FRAME_TIME) fFrameTime = MAX_FRAME_TIME;
 
-	if (currentTime - lastTime > 150)
+	m_fStepTime += fFrameTime;
+	while (m_fStepTime >= CGameWorld::STEP_TIME)
 	{
-		lastTime = currentTime;
-		currentY0 -= 5;
-		currentY1 -= 5;
+		m_World.Step(m_Input, CGameWorld::STEP_TIME);
+		m_fStepTime -= CGameWorld::STEP_TIME;
 
-		if (currentY0 < -m_imgBackground.Width())
-			currentY0 = m_imgBackground.Width();
+		// Present what happened during the step
+		ProcessEvents();
 
-		if (currentY1 < -m_imgBackground1.Width())
-			currentY1 = m_imgBackground1.Width();
+		// Key presses are consumed by the step, held directions stay until
+		// they are polled again
+		for (int i = 0; i < CGameWorld::PLAYER_COUNT; i++)
+		{
+			ULONG Direction = m_Input.Players[i].ulDirection;
+			m_Input.Players[i] = SPlayerInput();
+			m_Input.Players[i].ulDirection = Direction;
+		}
 	}
-	m_imgBackground.Paint(m_pBBuffer->getDC(),currentY0,0);
-	m_imgBackground.Paint(m_pBBuffer->getDC(),currentY1,0);
-}
 
-int CGameApp::Sprite_Collide(Sprite * object1, Sprite * object2) {
-
-	int left1, left2;
-	int right1, right2;
-	int top1, top2;
-	int bottom1, bottom2;
-
-	left1 = object1->mPosition.x - object1->width()/2;
-	left2 = object2->mPosition.x - object2->width()/2;
-	right1 = left1 + object1->width()/2;
-	right2 = left2 + object2->width()/2;
-	top1 = object1->mPosition.y - object1->height()/2;
-	top2 = object2->mPosition.y - object1->height()/2;
-	bottom1 = top1 + object1->height()/2;
-	bottom2 = top2 + object2->height()/2;
-
-	if (bottom1 < top2) return(0);
-	if (top1 > bottom2) return(0);
-
-	if (right1 < left2) return(0);
-	if (left1 > right2) return(0);
+	m_Renderer.Update(fFrameTime);
+}
 
-	return(1);
-};
 //-----------------------------------------------------------------------------
-// Name : AnimateObjects () (Private)
-// Desc : Animates the objects we currently have loaded.
+// Name : ProcessEvents () (Private)
+// Desc : Plays the sounds and shows the messages for the events raised by
+//		the last simulation step.
 //-----------------------------------------------------------------------------
-void CGameApp::AnimateObjects()
+void CGameApp::ProcessEvents()
 {
-	m_pPlayer->Update(m_Timer.GetTimeElapsed());
-	m_pPlayer2->Update(m_Timer.GetTimeElapsed());
+	// The mixer thread plays them, any number at once
+	m_Audio.PlayEvents(m_World);
+
+	const std::vector<SGameEvent>& Events = m_World.Events();
+
+	for (size_t i = 0; i < Events.size(); i++)
+	{
+		switch (Events[i].eType)
+		{
+		case SGameEvent::EVENT_GAME_OVER:
+			if (Events[i].iPlayer == 1)
+				MessageBox(0, "BOZGORII CASTIGA", "GAME OVER", MB_OK);
+			else
+				MessageBox(0, "VADIM CASTIGA", "GAME OVER", MB_OK);
+			PostQuitMessage(0);
+			break;
+		default:
+			break;
+		}
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -530,145 +580,26 @@ void CGameApp::AnimateObjects()
 //-----------------------------------------------------------------------------
 void CGameApp::DrawObjects()
 {
-	static UINT fTimer;
-	m_pBBuffer->reset();
-
-//	m_imgBackground.Paint(m_pBBuffer->getDC(), 0, 0);
-	DrawBackground();
-
-	
-
-	m_pPlayer->Draw();
-
-	m_pPlayer2->Draw();
-
-	if (enemies.size() < 3) {
-		Enemy enemy(m_pBBuffer);
-		enemy.m_pSprite->mPosition = Vec2(50, 100);
-		enemies.push_back(enemy);
-		Enemy enemy2(m_pBBuffer);
-		enemy2.shootCooldown = 100;
-		enemy2.m_pSprite->mPosition = Vec2(250, 100);
-		enemies.push_back(enemy2);
-		Enemy enemy3(m_pBBuffer);
-		enemy3.m_pSprite->mPosition = Vec2(450, 100);
-		enemies.push_back(enemy3);
-	}
-	
-	for (auto &it : enemies) {
-		it.shootCooldown--;
-		it.m_pSprite->draw();
-		it.move();
-		it.shoot();
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 70, NULL);
-			m_pPlayer->Explode();
-			m_pPlayer->m_pSprite->mPosition = Vec2(400, 400);
-		}
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer2->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 70, NULL);
-			m_pPlayer2->Explode();
-			m_pPlayer2->m_pSprite->mPosition = Vec2(400, 400);
-		}
-	}
-
-	for (auto &it : bullets) {
-		it.m_pSprite->draw();
-		it.Move1();
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer2->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 50, NULL);
-			m_pPlayer2->Explode();
-			it = NULL;	
-		}
-	}
-
-	for (auto &it : bullets2) {
-		it.m_pSprite->draw();
-		it.Move2();
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 50, NULL);
-			m_pPlayer->Explode();
-			it = NULL;
-		}
-	}
-
-	for (auto &it : bullets3) {
-		it.m_pSprite->draw();
-		it.Move3();
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer2->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 50, NULL);
-			it = NULL;
-			m_pPlayer2->Explode();
-		}
-		if (Sprite_Collide(it.m_pSprite, m_pPlayer->m_pSprite)) {
-			fTimer = SetTimer(m_hWnd, 1, 50, NULL);
-			m_pPlayer->Explode();
-			it = NULL;
-		}
-	}
-
-	if (Sprite_Collide(m_pPlayer->m_pSprite, m_pPlayer2->m_pSprite)) {
-		fTimer = SetTimer(m_hWnd, 1, 70, NULL);
-		m_pPlayer->Explode();
-		m_pPlayer2->Explode();
-		m_pPlayer->m_pSprite->mPosition = Vec2(1300, 500);
-		m_pPlayer2->m_pSprite->mPosition = Vec2(100, 500);
-
-	}
-
-	enemies.remove_if([](Enemy c) {
-		return c.m_pSprite->mPosition.x > 1300 ? true : false;
-	});
-
-	bullets3.remove_if([](Bullet c) {
-		return c.m_pSprite->mPosition.y > 700 ? true : false;
-	});
+	FrameProfiler& Profiler = m_Timer.Profiler();
 
+	// Draw in between the last two steps, as far as the time left over
+	Profiler.begin(FrameProfiler::PHASE_DRAW);
+	m_Renderer.Draw(m_World, *m_pBBuffer, m_fStepTime / CGameWorld::STEP_TIME);
+	Profiler.end(FrameProfiler::PHASE_DRAW);
 
+	Profiler.begin(FrameProfiler::PHASE_PRESENT);
 	m_pBBuffer->present();
+	Profiler.end(FrameProfiler::PHASE_PRESENT);
 }
 
 void CGameApp::Save_game()
 {
-	
-	ofstream fout;
-	fout.open("game.txt", ofstream::out | ofstream::trunc); // the text file is freed every time
-
-	fout << "Player1:" << " " << m_pPlayer->m_pSprite->mPosition.x << " " << m_pPlayer->m_pSprite->mPosition.y << endl;
-	fout << "Player2:" << " " << m_pPlayer2->m_pSprite->mPosition.x << " " << m_pPlayer2->m_pSprite->mPosition.y << endl;
-
-	fout << "Player1Lives:" << " " << m_pPlayer->lives << endl;
-	fout << "Player2Lives:" << " " << m_pPlayer->lives << endl;
-
-	fout.close();
+	m_World.Save("game.txt");
 }
 
 // Function that will read data from a text file and initialize the game with the last coordinates
 // of the planes (before the moment of save)
 void CGameApp::Load_game()
 {
-	ifstream fin("game.txt");
-
-	double p1x, p2x;
-	int p1l, p2l;
-	double p1y, p2y;
-
-	string stuff;
-
-	fin >> stuff >> p1x >> p1y;
-	fin >> stuff >> p2x >> p2y;
-	
-	m_pPlayer->m_pSprite->mVelocity = Vec2(0, 0);
-	m_pPlayer->Position() = Vec2(p1x, p1y);
-
-	m_pPlayer2->m_pSprite->mVelocity = Vec2(0, 0);
-	m_pPlayer2->Position() = Vec2(p2x, p2y);
-	
-	fin >> stuff >> p1l;
-	fin >> stuff >> p2l;
-
-	m_pPlayer->lives = p1l;
-	m_pPlayer2->lives = p2l;
-
-	fin.close();
-}
+	m_World.Load("game.txt");
+}
\ No newline at end of file
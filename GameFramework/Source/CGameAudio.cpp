@@ -0,0 +1,170 @@
+//-----------------------------------------------------------------------------
+// File: CGameAudio.cpp
+//
+// Desc: Plays the sounds of the events a CGameWorld raises.
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CGameAudio Specific Includes
+//-----------------------------------------------------------------------------
+#include "CGameAudio.h"
+
+//-----------------------------------------------------------------------------
+// Module Local Constants
+//-----------------------------------------------------------------------------
+namespace
+{
+	// How far to the side a ship at the edge of the playfield is heard
+	const float PAN_WIDTH = 0.8f;
+
+	const float JET_VOLUME = 0.7f;
+	const float EXPLOSION_VOLUME = 1.0f;
+	const float MUSIC_VOLUME = 0.5f;
+}
+
+//-----------------------------------------------------------------------------
+// CGameAudio Member Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameAudio () (Constructor)
+// Desc : CGameAudio Class Constructor
+//-----------------------------------------------------------------------------
+CGameAudio::CGameAudio() : m_Sounds(AudioEngine::SAMPLE_RATE)
+{
+	for (int i = 0; i < CGameWorld::PLAYER_COUNT; i++) m_JetVoices[i] = 0;
+	m_MusicVoice = 0;
+	m_dRenderFrames = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CGameAudio () (Destructor)
+// Desc : CGameAudio Class Destructor
+//-----------------------------------------------------------------------------
+CGameAudio::~CGameAudio()
+{
+	Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Load ()
+// Desc : Decodes the sounds of the game and starts the engine on pOutput,
+//		which it then owns. The paths are relative to the GameFramework
+//		folder. Without bThreaded the sound is only mixed by Render().
+//-----------------------------------------------------------------------------
+bool CGameAudio::Load(AudioOutput* pOutput, bool bThreaded)
+{
+	m_JetStart	= m_Sounds.load("Data/jet-start.wav");
+	m_JetStop	= m_Sounds.load("Data/jet-stop.wav");
+	m_JetCabin	= m_Sounds.load("Data/jet-cabin.wav");
+	m_Explosion	= m_Sounds.load("Data/explosion.wav");
+
+	m_dRenderFrames = 0;
+	return m_Engine.start(pOutput, bThreaded);
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Stops the engine and lets go of the sounds.
+//-----------------------------------------------------------------------------
+void CGameAudio::Release()
+{
+	m_Engine.stop();
+	m_MusicVoice = 0;
+
+	m_JetStart.reset();
+	m_JetStop.reset();
+	m_JetCabin.reset();
+	m_Explosion.reset();
+	m_Sounds.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Name : PlayMusic ()
+// Desc : Streams a WAV file as the music, in place of the last one. The
+//		file is read as it plays, so its length costs no memory.
+//-----------------------------------------------------------------------------
+bool CGameAudio::PlayMusic(const char* szFileName, bool bLoop)
+{
+	if (!m_Engine.started()) return false;
+
+	StopMusic();
+	StreamHandle Stream = std::make_shared<AudioStream>((int)AudioEngine::SAMPLE_RATE);
+	if (!Stream->open(szFileName, bLoop)) return false;
+
+	m_MusicVoice = m_Engine.playStream(Stream, MUSIC_VOLUME);
+	return m_MusicVoice != 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : StopMusic ()
+// Desc : Stops the music streamed by PlayMusic().
+//-----------------------------------------------------------------------------
+void CGameAudio::StopMusic()
+{
+	if (m_MusicVoice) m_Engine.stopVoice(m_MusicVoice);
+	m_MusicVoice = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : PlayEvents ()
+// Desc : Starts the sounds of the events raised by the last step, each
+//		heard from the side of the screen its ship is on.
+//-----------------------------------------------------------------------------
+void CGameAudio::PlayEvents(const CGameWorld& World)
+{
+	if (!m_Engine.started()) return;
+
+	const std::vector<SGameEvent>& Events = World.Events();
+	for (size_t i = 0; i < Events.size(); i++)
+	{
+		int iPlayer = Events[i].iPlayer;
+		switch (Events[i].eType)
+		{
+		case SGameEvent::EVENT_JET_START: PlayJet(World, iPlayer, m_JetStart); break;
+		case SGameEvent::EVENT_JET_STOP:  PlayJet(World, iPlayer, m_JetStop); break;
+		case SGameEvent::EVENT_JET_CABIN: PlayJet(World, iPlayer, m_JetCabin); break;
+		case SGameEvent::EVENT_EXPLOSION:
+			m_Engine.play(m_Explosion, EXPLOSION_VOLUME, PlayerPan(World, iPlayer));
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : Render ()
+// Desc : Mixes dt seconds of sound into the output, when the engine runs
+//		without its thread.
+//-----------------------------------------------------------------------------
+void CGameAudio::Render(float dt)
+{
+	m_dRenderFrames += dt * (double)AudioEngine::SAMPLE_RATE;
+
+	int nFrames = (int)m_dRenderFrames;
+	m_dRenderFrames -= nFrames;
+	if (nFrames > 0) m_Engine.render(nFrames);
+}
+
+//-----------------------------------------------------------------------------
+// Name : PlayJet () (Private)
+// Desc : Plays an engine sound of a ship in place of the last one, the
+//		start, cabin and stop sounds follow each other.
+//-----------------------------------------------------------------------------
+void CGameAudio::PlayJet(const CGameWorld& World, int iPlayer, const SoundHandle& Sound)
+{
+	if (m_JetVoices[iPlayer]) m_Engine.stopVoice(m_JetVoices[iPlayer]);
+	m_JetVoices[iPlayer] = m_Engine.play(Sound, JET_VOLUME, PlayerPan(World, iPlayer));
+}
+
+//-----------------------------------------------------------------------------
+// Name : PlayerPan () (Private, Static)
+// Desc : Pan of a ship, from its place across the playfield.
+//-----------------------------------------------------------------------------
+float CGameAudio::PlayerPan(const CGameWorld& World, int iPlayer)
+{
+	float x = (float)World.Player(iPlayer).Position().x / CGameWorld::PLAYFIELD_WIDTH;
+	x = x < 0 ? 0 : x > 1 ? 1 : x;
+	return (x * 2 - 1) * PAN_WIDTH;
+}
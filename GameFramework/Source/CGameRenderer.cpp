@@ -0,0 +1,204 @@
+//-----------------------------------------------------------------------------
+// File: CGameRenderer.cpp
+//
+// Desc: Draws the state of a CGameWorld into a back buffer.
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CGameRenderer Specific Includes
+//-----------------------------------------------------------------------------
+#include "CGameRenderer.h"
+
+//-----------------------------------------------------------------------------
+// Module Local Constants
+//-----------------------------------------------------------------------------
+namespace
+{
+	// Background scroll speed in pixels per second, the pace of the old
+	// 5 pixel steps every 150 ms
+	const float BACKGROUND_SPEED = 5.0f / 0.15f;
+
+	// The explosion frames are 128 x 128, four per row
+	const int	EXPLOSION_FRAME_SIZE = 128;
+	const int	EXPLOSION_FRAMES_PER_ROW = 4;
+}
+
+//-----------------------------------------------------------------------------
+// CGameRenderer Member Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameRenderer () (Constructor)
+// Desc : CGameRenderer Class Constructor
+//-----------------------------------------------------------------------------
+CGameRenderer::CGameRenderer()
+{
+	m_iBackgroundX = -1;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CGameRenderer () (Destructor)
+// Desc : CGameRenderer Class Destructor
+//-----------------------------------------------------------------------------
+CGameRenderer::~CGameRenderer()
+{
+	Release();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Load ()
+// Desc : Loads the images of the game. The paths are relative to the
+//		GameFramework folder.
+//-----------------------------------------------------------------------------
+bool CGameRenderer::Load()
+{
+	// Every heading is turned from the forward image here, once
+	m_PlayerRotations	= m_Images.loadRotations("Data/PlaneImg.bmp", "Data/PlaneMask.bmp", PLAYER_ROTATIONS);
+	m_ExplosionImage	= m_Images.load("Data/explosion.bmp", "Data/explosionmask.bmp");
+	m_EnemyImage		= m_Images.load("Data/Enemy.bmp", RGB(0xff, 0x00, 0xff));
+	m_ProjectileImages[CGameWorld::PROJECTILE_BULLET] = m_Images.load("Data/bullet.bmp", "Data/bmask.bmp");
+	if (!m_PlayerRotations || !m_ExplosionImage || !m_EnemyImage || !m_ProjectileImages[CGameWorld::PROJECTILE_BULLET])
+		return false;
+
+	// Decoded once in the back buffer format, drawing only copies it
+	if (!m_Background.load("Data/spacerrr.bmp"))
+		return false;
+	m_Background.setSpeed(BACKGROUND_SPEED);
+	m_iBackgroundX = -1;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Release ()
+// Desc : Lets go of the images.
+//-----------------------------------------------------------------------------
+void CGameRenderer::Release()
+{
+	m_Queue.clear();
+
+	m_PlayerRotations.reset();
+	m_ExplosionImage.reset();
+	m_EnemyImage.reset();
+	for (int i = 0; i < CGameWorld::PROJECTILE_IMAGE_COUNT; i++)
+		m_ProjectileImages[i].reset();
+	m_Images.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ApplySpriteSizes ()
+// Desc : Makes the world collide with the sizes and the opaque pixels of
+//		the images we draw, for the ship every rotation frame.
+//-----------------------------------------------------------------------------
+void CGameRenderer::ApplySpriteSizes(CGameWorld& World) const
+{
+	const SpriteImage& Player = *m_PlayerRotations->frame(0);
+	const SpriteImage& Bullet = *m_ProjectileImages[CGameWorld::PROJECTILE_BULLET];
+
+	World.SetSpriteSizes(Vec2(Player.image.width(), Player.image.height()),
+						 Vec2(m_EnemyImage->image.width(), m_EnemyImage->image.height()),
+						 Vec2(Bullet.image.width(), Bullet.image.height()));
+
+	std::vector<CollisionMask> ShipMasks;
+	for (size_t i = 0; i < m_PlayerRotations->count(); i++)
+		ShipMasks.push_back(m_PlayerRotations->frames[i]->collision);
+
+	World.SetCollisionMasks(ShipMasks, m_EnemyImage->collision, Bullet.collision);
+}
+
+//-----------------------------------------------------------------------------
+// Name : Update ()
+// Desc : Advances what moves on screen on its own (the background).
+//-----------------------------------------------------------------------------
+void CGameRenderer::Update(float dt)
+{
+	m_Background.update(dt);
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildCommands ()
+// Desc : Queues one render command per visible object of the world, fAlpha
+//		of the way through the last step.
+//-----------------------------------------------------------------------------
+void CGameRenderer::BuildCommands(const CGameWorld& World, RenderQueue& Queue, float fAlpha)
+{
+	for (int i = 0; i < CGameWorld::PLAYER_COUNT; i++)
+	{
+		const CPlayer& Player = World.Player(i);
+
+		if (!Player.IsExploding())
+			Queue.add(m_PlayerRotations->frame(Player.HeadingAngle()), Lerp(Player.PreviousPosition(), Player.Position(), fAlpha), LAYER_PLAYERS);
+		else
+		{
+			int iFrame = Player.GetExplosionFrame();
+			Queue.add(m_ExplosionImage, Player.ExplosionPosition(), LAYER_PLAYERS,
+					  iFrame % EXPLOSION_FRAMES_PER_ROW * EXPLOSION_FRAME_SIZE,
+					  iFrame / EXPLOSION_FRAMES_PER_ROW * EXPLOSION_FRAME_SIZE,
+					  EXPLOSION_FRAME_SIZE, EXPLOSION_FRAME_SIZE);
+		}
+	}
+
+	for (SlotMap<Enemy>::const_iterator it = World.enemies.begin(); it != World.enemies.end(); ++it)
+		Queue.add(m_EnemyImage, Lerp(it->mPrevPosition, it->mPosition, fAlpha), LAYER_ENEMIES);
+
+	const ProjectilePool& Projectiles = World.projectiles;
+	for (int i = 0; i < Projectiles.size(); i++)
+	{
+		Queue.add(m_ProjectileImages[Projectiles.image(i)], Lerp(Projectiles.previousPosition(i), Projectiles.position(i), fAlpha), LAYER_BULLETS);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : Render ()
+// Desc : Draws a frame of the world and presents it.
+//-----------------------------------------------------------------------------
+void CGameRenderer::Render(const CGameWorld& World, BackBuffer& BBuffer, float fAlpha)
+{
+	Draw(World, BBuffer, fAlpha);
+	BBuffer.present();
+}
+
+//-----------------------------------------------------------------------------
+// Name : Draw ()
+// Desc : Draws a frame of the world into the back buffer, the caller
+//		presents it.
+//-----------------------------------------------------------------------------
+void CGameRenderer::Draw(const CGameWorld& World, BackBuffer& BBuffer, float fAlpha)
+{
+	// A scroll step moves the whole backdrop, so every pixel on screen
+	// changes and only a full repaint and present can show it. At the
+	// scroll speed that is about one frame in four at 120 Hz, the others
+	// keep to the dirty rectangles (see the dirty benchmark).
+	int iBackgroundX = (int)m_Background.offset();
+	if (iBackgroundX != m_iBackgroundX)
+	{
+		BBuffer.invalidate();
+		m_iBackgroundX = iBackgroundX;
+	}
+
+	BBuffer.reset();
+	DrawBackground(BBuffer);
+
+	BuildCommands(World, m_Queue, fAlpha);
+
+	if (m_Tiles.threadCount() > 1)
+		m_Tiles.submit(m_Queue, BBuffer);
+	else
+		m_Queue.submit(BBuffer);
+}
+
+//-----------------------------------------------------------------------------
+// Name : DrawBackground () (Private)
+// Desc : Copies the visible window of the scrolling background, only where
+//		the back buffer was cleared, the rest is still there.
+//-----------------------------------------------------------------------------
+void CGameRenderer::DrawBackground(BackBuffer& BBuffer)
+{
+	const DirtyRegion& Damage = BBuffer.damage();
+
+	for (int i = 0; i < Damage.count(); i++)
+	{
+		const RECT& rc = Damage.rect(i);
+		m_Background.draw(BBuffer.getSurface(), rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
+	}
+}
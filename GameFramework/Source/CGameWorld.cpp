@@ -0,0 +1,569 @@
+//-----------------------------------------------------------------------------
+// File: CGameWorld.cpp
+//
+// Desc: Platform neutral game simulation. Holds the world state (players,
+//	   enemies, bullets, lives) and advances it one step at a time from a
+//	   set of inputs.
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// CGameWorld Specific Includes
+//-----------------------------------------------------------------------------
+#include "CGameWorld.h"
+#include "BoxOverlap.h"
+#include <fstream>
+#include <math.h>
+#include <string>
+
+using namespace std;
+
+const float CGameWorld::STEP_TIME = 1.0f / 120.0f;
+
+//-----------------------------------------------------------------------------
+// Module Local Constants
+//-----------------------------------------------------------------------------
+namespace
+{
+	// Shot speeds in pixels per second, the old per frame steps at 60
+	// frames per second: players fire sideways, enemies drop theirs
+	const float SHOT_SPEED = 5 * 60.0f;
+	const float FALL_SPEED = 2 * 60.0f;
+
+	// Seconds a shot flies at most, they leave the playfield long before
+	const float SHOT_LIFETIME = 10.0f;
+
+	// Distance past the playfield edges a shot is dropped at
+	const float PLAYFIELD_MARGIN = 64.0f;
+
+	// Side of the collision grid cells, a bit more than a ship
+	const float COLLISION_CELL_SIZE = 128.0f;
+
+	// Most pixel tests along a swept hit, a pixel of motion apart below it
+	const int MAX_SWEEP_SAMPLES = 256;
+
+	// Box around a centered sprite at both ends of its move
+	void SweptBounds(const Vec2& From, const Vec2& To, const Vec2& Size, float& fLeft, float& fTop, float& fRight, float& fBottom)
+	{
+		float fHalfWidth = (float)Size.x * 0.5f, fHalfHeight = (float)Size.y * 0.5f;
+		fLeft	= (float)(From.x < To.x ? From.x : To.x) - fHalfWidth;
+		fRight	= (float)(From.x < To.x ? To.x : From.x) + fHalfWidth;
+		fTop	= (float)(From.y < To.y ? From.y : To.y) - fHalfHeight;
+		fBottom	= (float)(From.y < To.y ? To.y : From.y) + fHalfHeight;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// CGameWorld Member Functions
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Name : CGameWorld () (Constructor)
+// Desc : CGameWorld Class Constructor
+//-----------------------------------------------------------------------------
+CGameWorld::CGameWorld() : enemies(MAX_ENEMIES), m_EnemySize(100, 143), m_BulletSize(37, 30),
+	m_Broadphase(-PLAYFIELD_MARGIN, -PLAYFIELD_MARGIN, PLAYFIELD_WIDTH + PLAYFIELD_MARGIN, PLAYFIELD_HEIGHT + PLAYFIELD_MARGIN,
+				 COLLISION_CELL_SIZE, COLLISION_LAYER_COUNT)
+{
+	// What can hit what, the players first. Any other pair of layers is
+	// never tested.
+	static const int Interactions[][2] =
+	{
+		{ COLLISION_PLAYER1, COLLISION_PLAYER2 },
+		{ COLLISION_PLAYER1, COLLISION_ENEMY },
+		{ COLLISION_PLAYER1, COLLISION_PLAYER2_SHOT },
+		{ COLLISION_PLAYER1, COLLISION_ENEMY_SHOT },
+		{ COLLISION_PLAYER2, COLLISION_ENEMY },
+		{ COLLISION_PLAYER2, COLLISION_PLAYER1_SHOT },
+		{ COLLISION_PLAYER2, COLLISION_ENEMY_SHOT }
+	};
+
+	m_Broadphase.clearInteractions();
+	for (size_t i = 0; i < sizeof(Interactions) / sizeof(Interactions[0]); i++)
+		m_Broadphase.setInteraction(Interactions[i][0], Interactions[i][1], true);
+
+	Reset();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ~CGameWorld () (Destructor)
+// Desc : CGameWorld Class Destructor
+//-----------------------------------------------------------------------------
+CGameWorld::~CGameWorld()
+{
+}
+
+//-----------------------------------------------------------------------------
+// Name : Reset ()
+// Desc : Puts the world back into the state of a new match.
+//-----------------------------------------------------------------------------
+void CGameWorld::Reset()
+{
+	for (int i = 0; i < PLAYER_COUNT; i++)
+	{
+		Vec2 size = m_Players[i].BaseSize();
+		m_Players[i] = CPlayer();
+		m_Players[i].SetBaseSize(size);
+	}
+
+	projectiles.clear();
+	enemies.clear();
+	m_Events.clear();
+
+	m_bGameOver = false;
+	m_iWinner	= -1;
+	m_StepCount = 0;
+
+	m_Players[0].Position() = Vec2(1300, 500);
+	m_Players[1].Position() = Vec2(100, 500);
+	m_Players[1].RotateRight();
+	m_Players[0].RotateLeft();
+	SavePositions();
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetSpriteSizes ()
+// Desc : Sets the collision sizes of the objects, usually taken from the
+//		images the front end draws them with. The ship size is the one of
+//		the forward facing image.
+//-----------------------------------------------------------------------------
+void CGameWorld::SetSpriteSizes(const Vec2& ShipSize, const Vec2& EnemySize, const Vec2& BulletSize)
+{
+	for (int i = 0; i < PLAYER_COUNT; i++)
+		m_Players[i].SetBaseSize(ShipSize);
+
+	m_EnemySize = EnemySize;
+	m_BulletSize = BulletSize;
+}
+
+//-----------------------------------------------------------------------------
+// Name : SetCollisionMasks ()
+// Desc : Sets the opaque pixels of the objects, the ship masks are evenly
+//		spaced headings starting forward and turning counterclockwise. Box
+//		hits then only count where the pixels touch.
+//-----------------------------------------------------------------------------
+void CGameWorld::SetCollisionMasks(const std::vector<CollisionMask>& ShipMasks, const CollisionMask& EnemyMask,
+								   const CollisionMask& BulletMask)
+{
+	m_ShipMasks = ShipMasks;
+	m_EnemyMask = EnemyMask;
+	m_BulletMask = BulletMask;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Step ()
+// Desc : Advances the simulation by dt seconds. Events raised during the
+//		step can be read back with Events() until the next call.
+//-----------------------------------------------------------------------------
+void CGameWorld::Step(const SWorldInput& Input, float dt)
+{
+	m_Events.clear();
+
+	if (m_bGameOver) return;
+
+	SavePositions();
+	ProcessInput(Input, dt);
+	UpdatePlayers(dt);
+	UpdateEnemies(dt);
+	UpdateProjectiles(dt);
+	ResolveCollisions();
+	CullObjects();
+
+	// Any player out of lives ends the match
+	if (m_Players[0].lives <= 0 || m_Players[1].lives <= 0)
+	{
+		m_bGameOver = true;
+		m_iWinner	= m_Players[0].lives <= 0 ? 1 : 0;
+		PushEvent(SGameEvent::EVENT_GAME_OVER, m_iWinner);
+	}
+
+	m_StepCount++;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ProcessInput () (Private)
+// Desc : Applies the player actions and movement for this step.
+//-----------------------------------------------------------------------------
+void CGameWorld::ProcessInput(const SWorldInput& Input, float dt)
+{
+	for (int i = 0; i < PLAYER_COUNT; i++)
+	{
+		const SPlayerInput& in = Input.Players[i];
+		CPlayer& player = m_Players[i];
+
+		if (in.bExplode) ExplodePlayer(i);
+		if (in.bRotateLeft) player.RotateLeft();
+		if (in.bRotateRight) player.RotateRight();
+
+		if (in.bFire && player.Shoot())
+		{
+			// Player 1 fires left, player 2 right
+			const Vec2& pos = player.Position();
+			projectiles.spawn((float)pos.x, (float)pos.y, i == 0 ? -SHOT_SPEED : SHOT_SPEED, 0.0f, SHOT_LIFETIME,
+							  i == 0 ? ProjectilePool::OWNER_PLAYER1 : ProjectilePool::OWNER_PLAYER2, PROJECTILE_BULLET);
+		}
+
+		player.Move(in.ulDirection, dt);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : UpdatePlayers () (Private)
+// Desc : Integrates the players and turns their sound cues into events.
+//-----------------------------------------------------------------------------
+void CGameWorld::UpdatePlayers(float dt)
+{
+	for (int i = 0; i < PLAYER_COUNT; i++)
+	{
+		switch (m_Players[i].Update(dt))
+		{
+		case CPlayer::SOUND_JET_START: PushEvent(SGameEvent::EVENT_JET_START, i); break;
+		case CPlayer::SOUND_JET_STOP:  PushEvent(SGameEvent::EVENT_JET_STOP, i); break;
+		case CPlayer::SOUND_JET_CABIN: PushEvent(SGameEvent::EVENT_JET_CABIN, i); break;
+		default: break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : UpdateEnemies () (Private)
+// Desc : Spawns a new wave when needed, moves the enemies and lets them
+//		shoot.
+//-----------------------------------------------------------------------------
+void CGameWorld::UpdateEnemies(float dt)
+{
+	// Built in place in the reserved storage, a wave does not allocate
+	if (enemies.size() < 3) {
+		enemies.emplace(Vec2(50, 100));
+		enemies.emplace(Vec2(250, 100), 1.6f);
+		enemies.emplace(Vec2(450, 100));
+	}
+
+	for (auto &it : enemies) {
+		it.shootCooldown -= dt;
+		it.move(dt);
+		if (it.shoot())
+			projectiles.spawn((float)it.mPosition.x, (float)it.mPosition.y, 0.0f, FALL_SPEED, SHOT_LIFETIME,
+							  ProjectilePool::OWNER_ENEMY, PROJECTILE_BULLET);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : UpdateProjectiles () (Private)
+// Desc : Moves every shot.
+//-----------------------------------------------------------------------------
+void CGameWorld::UpdateProjectiles(float dt)
+{
+	projectiles.update(dt);
+}
+
+//-----------------------------------------------------------------------------
+// Name : BuildBroadphase () (Private)
+// Desc : Puts every object of the step into the collision grid, ids are
+//		the player index, the packed enemy index or the shot index. Ships
+//		and shots cover the whole path of the step, so the swept test
+//		gets every shot that went through a ship between two steps.
+//-----------------------------------------------------------------------------
+void CGameWorld::BuildBroadphase()
+{
+	float l, t, r, b;
+	m_Broadphase.clear();
+
+	for (int i = 0; i < PLAYER_COUNT; i++)
+	{
+		SweptBounds(m_Players[i].PreviousPosition(), m_Players[i].Position(), m_Players[i].Size(), l, t, r, b);
+		m_Broadphase.add(i, COLLISION_PLAYER1 + i, l, t, r, b);
+	}
+
+	for (int i = 0; i < enemies.size(); i++)
+	{
+		const Vec2& pos = enemies.at(i).mPosition;
+		m_Broadphase.addCentered(i, COLLISION_ENEMY, (float)pos.x, (float)pos.y, (float)m_EnemySize.x, (float)m_EnemySize.y);
+	}
+
+	for (int i = 0; i < projectiles.size(); i++)
+	{
+		SweptBounds(projectiles.previousPosition(i), projectiles.position(i), m_BulletSize, l, t, r, b);
+		m_Broadphase.add(i, COLLISION_PLAYER1_SHOT + projectiles.owner(i), l, t, r, b);
+	}
+
+	m_Broadphase.build();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ResolveCollisions () (Private)
+// Desc : Takes the candidate pairs of the layers that interact from the
+//		grid in one query and applies the hits. Enemies ram the players,
+//		players are hit by the shots of the other player and by the enemy
+//		shots, and the two ships can collide. The shots are swept along
+//		their move of the step against the move of the ships, however far
+//		they fly in a step, the rest is tested on the current positions. A
+//		player moved by an earlier hit of the step is not hit where it was.
+//-----------------------------------------------------------------------------
+void CGameWorld::ResolveCollisions()
+{
+	BuildBroadphase();
+
+	// A player is always the first layer of a pair, the second one says
+	// what met it
+	m_Pairs.clear();
+	m_Broadphase.queryInteracting(m_Pairs);
+
+	// Rams first, they move the players
+	for (size_t p = 0; p < m_Pairs.size(); p++)
+	{
+		const BroadphasePair& pair = m_Pairs[p];
+		if (pair.layerB != COLLISION_ENEMY) continue;
+
+		int i = pair.a;
+		const Vec2& pos = enemies.at(pair.b).mPosition;
+		if (Sprite_Collide(pos, m_EnemySize, m_Players[i].Position(), m_Players[i].Size()) &&
+			Pixels_Collide(pos, &m_EnemyMask, m_Players[i].Position(), ShipMask(i))) {
+			ExplodePlayer(i);
+			m_Players[i].Position() = Vec2(400, 400);
+			m_Players[i].SavePosition();
+		}
+	}
+
+	// A shot hits the player it meets first, enemy shots going through
+	// both at once hit player 1
+	m_ShotHit.assign(projectiles.size(), 0);
+	m_ShotTime.resize(projectiles.size());
+	for (size_t p = 0; p < m_Pairs.size(); p++)
+	{
+		const BroadphasePair& pair = m_Pairs[p];
+		if (pair.layerB < COLLISION_PLAYER1_SHOT) continue;
+
+		int iShot = pair.b;
+		int iTarget = pair.a;
+		const CPlayer& target = m_Players[iTarget];
+
+		float fTime;
+		if (Swept_Collide(projectiles.previousPosition(iShot), projectiles.position(iShot), m_BulletSize, &m_BulletMask,
+						  target.PreviousPosition(), target.Position(), target.Size(), ShipMask(iTarget), fTime) &&
+			(!m_ShotHit[iShot] || fTime < m_ShotTime[iShot]))
+		{
+			m_ShotHit[iShot] = (char)(iTarget + 1);
+			m_ShotTime[iShot] = fTime;
+		}
+	}
+
+	for (int i = 0; i < projectiles.size(); i++)
+		if (m_ShotHit[i]) ExplodePlayer(m_ShotHit[i] - 1);
+
+	// Backwards, so the last shot moved into a hole was already looked at
+	for (int i = projectiles.size() - 1; i >= 0; i--)
+		if (m_ShotHit[i]) projectiles.remove(i);
+
+	for (size_t p = 0; p < m_Pairs.size(); p++)
+	{
+		if (m_Pairs[p].layerA != COLLISION_PLAYER1 || m_Pairs[p].layerB != COLLISION_PLAYER2) continue;
+
+		if (Sprite_Collide(m_Players[0].Position(), m_Players[0].Size(), m_Players[1].Position(), m_Players[1].Size()) &&
+			Pixels_Collide(m_Players[0].Position(), ShipMask(0), m_Players[1].Position(), ShipMask(1))) {
+			ExplodePlayer(0);
+			ExplodePlayer(1);
+			m_Players[0].Position() = Vec2(1300, 500);
+			m_Players[1].Position() = Vec2(100, 500);
+			m_Players[0].SavePosition();
+			m_Players[1].SavePosition();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Name : CullObjects () (Private)
+// Desc : Drops the enemies past the right side and the shots that left the
+//		playfield or ran out of time.
+//-----------------------------------------------------------------------------
+void CGameWorld::CullObjects()
+{
+	// The last enemy moves into a removed index, look at it again
+	for (int i = 0; i < enemies.size(); ) {
+		if (enemies.at(i).mPosition.x > 1300) enemies.removeAt(i);
+		else i++;
+	}
+
+	projectiles.cull(-PLAYFIELD_MARGIN, -PLAYFIELD_MARGIN, PLAYFIELD_WIDTH + PLAYFIELD_MARGIN, PLAYFIELD_HEIGHT + PLAYFIELD_MARGIN);
+}
+
+//-----------------------------------------------------------------------------
+// Name : SavePositions () (Private)
+// Desc : Remembers where everything is before a step, the renderer draws
+//		in between the two.
+//-----------------------------------------------------------------------------
+void CGameWorld::SavePositions()
+{
+	for (int i = 0; i < PLAYER_COUNT; i++)
+		m_Players[i].SavePosition();
+
+	for (auto &it : enemies) it.mPrevPosition = it.mPosition;
+	projectiles.savePositions();
+}
+
+//-----------------------------------------------------------------------------
+// Name : ExplodePlayer () (Private)
+// Desc : Blows up a player, costing it a life.
+//-----------------------------------------------------------------------------
+void CGameWorld::ExplodePlayer(int iPlayer)
+{
+	m_Players[iPlayer].Explode();
+	PushEvent(SGameEvent::EVENT_EXPLOSION, iPlayer);
+}
+
+//-----------------------------------------------------------------------------
+// Name : PushEvent () (Private)
+// Desc : Records an event for the front end.
+//-----------------------------------------------------------------------------
+void CGameWorld::PushEvent(SGameEvent::EType eType, int iPlayer)
+{
+	SGameEvent e;
+	e.eType = eType;
+	e.iPlayer = iPlayer;
+	m_Events.push_back(e);
+}
+
+//-----------------------------------------------------------------------------
+// Name : Sprite_Collide () (Private, Static)
+// Desc : Bounding box test between two centered boxes, the same boxes and
+//		the same test the collision grid uses.
+//-----------------------------------------------------------------------------
+int CGameWorld::Sprite_Collide(const Vec2& Pos1, const Vec2& Size1, const Vec2& Pos2, const Vec2& Size2) {
+
+	float halfWidth1 = (float)Size1.x * 0.5f, halfHeight1 = (float)Size1.y * 0.5f;
+	float halfWidth2 = (float)Size2.x * 0.5f, halfHeight2 = (float)Size2.y * 0.5f;
+	float x1 = (float)Pos1.x, y1 = (float)Pos1.y;
+	float x2 = (float)Pos2.x, y2 = (float)Pos2.y;
+
+	return boxesOverlap(x1 - halfWidth1, y1 - halfHeight1, x1 + halfWidth1, y1 + halfHeight1,
+						x2 - halfWidth2, y2 - halfHeight2, x2 + halfWidth2, y2 + halfHeight2) ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Pixels_Collide () (Private, Static)
+// Desc : Whether two centered sprites whose boxes overlap have opaque
+//		pixels in the same place. The masks sit where the renderer draws
+//		the images. Without both masks the boxes decide.
+//-----------------------------------------------------------------------------
+bool CGameWorld::Pixels_Collide(const Vec2& Pos1, const CollisionMask* pMask1, const Vec2& Pos2, const CollisionMask* pMask2)
+{
+	if (!pMask1 || !pMask2 || pMask1->empty() || pMask2->empty()) return true;
+
+	return CollisionMask::overlap(*pMask1, (int)Pos1.x - pMask1->width() / 2, (int)Pos1.y - pMask1->height() / 2,
+								  *pMask2, (int)Pos2.x - pMask2->width() / 2, (int)Pos2.y - pMask2->height() / 2);
+}
+
+//-----------------------------------------------------------------------------
+// Name : Swept_Collide () (Private, Static)
+// Desc : Continuous test of two centered sprites over a step, each moving
+//		in a straight line from its From to its To position. The boxes give
+//		the part of the step where they touch, the masks are tested along
+//		it about a pixel of relative motion apart. fTime gets the fraction
+//		of the step at the first contact.
+//-----------------------------------------------------------------------------
+bool CGameWorld::Swept_Collide(const Vec2& From1, const Vec2& To1, const Vec2& Size1, const CollisionMask* pMask1,
+							   const Vec2& From2, const Vec2& To2, const Vec2& Size2, const CollisionMask* pMask2,
+							   float& fTime)
+{
+	float halfWidth1 = (float)Size1.x * 0.5f, halfHeight1 = (float)Size1.y * 0.5f;
+	float halfWidth2 = (float)Size2.x * 0.5f, halfHeight2 = (float)Size2.y * 0.5f;
+	float x1 = (float)From1.x, y1 = (float)From1.y;
+	float x2 = (float)From2.x, y2 = (float)From2.y;
+
+	// Sprite 1 moving past sprite 2 standing still
+	float dx1 = (float)(To1.x - From1.x), dy1 = (float)(To1.y - From1.y);
+	float dx2 = (float)(To2.x - From2.x), dy2 = (float)(To2.y - From2.y);
+	float dx = dx1 - dx2, dy = dy1 - dy2;
+
+	float fEnter, fLeave;
+	if (!sweepBoxes(x1 - halfWidth1, y1 - halfHeight1, x1 + halfWidth1, y1 + halfHeight1, dx, dy,
+					x2 - halfWidth2, y2 - halfHeight2, x2 + halfWidth2, y2 + halfHeight2, fEnter, fLeave))
+		return false;
+
+	float fTravel = (fabs(dx) > fabs(dy) ? fabs(dx) : fabs(dy)) * (fLeave - fEnter);
+	int nSamples = fTravel < MAX_SWEEP_SAMPLES ? (int)ceil(fTravel) : MAX_SWEEP_SAMPLES;
+
+	for (int i = 0; i <= nSamples; i++)
+	{
+		float t = nSamples ? fEnter + (fLeave - fEnter) * i / nSamples : fEnter;
+		if (Pixels_Collide(Vec2(x1 + dx1 * t, y1 + dy1 * t), pMask1, Vec2(x2 + dx2 * t, y2 + dy2 * t), pMask2))
+		{
+			fTime = t;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// Name : ShipMask () (Private)
+// Desc : The mask of the heading of a player, rounded to the nearest one
+//		like the renderer picks its rotation frame. 0 without masks.
+//-----------------------------------------------------------------------------
+const CollisionMask* CGameWorld::ShipMask(int iPlayer) const
+{
+	int n = (int)m_ShipMasks.size();
+	if (!n) return 0;
+
+	int i = (int)floor(m_Players[iPlayer].HeadingAngle() * n / (2 * PI) + 0.5) % n;
+	return &m_ShipMasks[i < 0 ? i + n : i];
+}
+
+//-----------------------------------------------------------------------------
+// Name : Save ()
+// Desc : Writes the plane positions and lives to a text file.
+//-----------------------------------------------------------------------------
+bool CGameWorld::Save(const char* szFileName) const
+{
+	ofstream fout;
+	fout.open(szFileName, ofstream::out | ofstream::trunc); // the text file is freed every time
+	if (!fout) return false;
+
+	const CPlayer& p1 = m_Players[0];
+	const CPlayer& p2 = m_Players[1];
+
+	fout << "Player1:" << " " << p1.Position().x << " " << p1.Position().y << endl;
+	fout << "Player2:" << " " << p2.Position().x << " " << p2.Position().y << endl;
+
+	fout << "Player1Lives:" << " " << p1.lives << endl;
+	fout << "Player2Lives:" << " " << p2.lives << endl;
+
+	fout.close();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Name : Load ()
+// Desc : Reads data from a text file and initializes the game with the last
+//		coordinates of the planes (before the moment of save)
+//-----------------------------------------------------------------------------
+bool CGameWorld::Load(const char* szFileName)
+{
+	ifstream fin(szFileName);
+	if (!fin) return false;
+
+	double p1x, p2x;
+	int p1l, p2l;
+	double p1y, p2y;
+
+	string stuff;
+
+	fin >> stuff >> p1x >> p1y;
+	fin >> stuff >> p2x >> p2y;
+
+	m_Players[0].Velocity() = Vec2(0, 0);
+	m_Players[0].Position() = Vec2(p1x, p1y);
+
+	m_Players[1].Velocity() = Vec2(0, 0);
+	m_Players[1].Position() = Vec2(p2x, p2y);
+
+	fin >> stuff >> p1l;
+	fin >> stuff >> p2l;
+
+	m_Players[0].lives = p1l;
+	m_Players[1].lives = p2l;
+	SavePositions();
+
+	fin.close();
+	return true;
+}
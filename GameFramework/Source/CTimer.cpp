@@ -38,7 +38,8 @@ CTimer::CTimer()
 	} // End If No Hardware
 
 	// Clear any needed values
-	m_SampleCount		= 0;
+	m_TimeElapsed		= 0.0f;
+	m_FrameTimeElapsed	= 0.0f;
 	m_FrameRate			= 0;
 	m_FPSFrameCount		= 0;
 	m_FPSTimeElapsed	= 0.0f;
@@ -56,7 +57,8 @@ CTimer::~CTimer()
 // Name : Tick () 
 // Desc : Function which signals that frame has advanced
 // Note : You can specify a number of frames per second to lock the frame rate
-//			to. This will simply soak up the remaining time to hit that target.
+//			to. The remaining time is slept away, only the last fraction of
+//			a millisecond is spun (see FramePacer).
 //-----------------------------------------------------------------------------
 void CTimer::Tick( float fLockFPS )
 {
@@ -82,46 +84,37 @@ void CTimer::Tick( float fLockFPS )
 	//if ( fLockFPS == 0.0f ) fLockFPS = (1.0f / GetTimeElapsed()) + 20.0f;
 	
 	// Should we lock the frame rate ?
-	if ( fLockFPS > 0.0f )
+	if ( fLockFPS > 0.0f && fTimeElapsed < (1.0f / fLockFPS) )
 	{
-		while ( fTimeElapsed < (1.0f / fLockFPS))
+		m_Pacer.waitUntil( FramePacer::now() + (1.0f / fLockFPS) - fTimeElapsed );
+
+		// Read the time we woke up at
+		if ( m_PerfHardware ) 
+		{
+			// Query high-resolution performance hardware
+			QueryPerformanceCounter((LARGE_INTEGER*)&m_CurrentTime);
+		} 
+		else 
 		{
-			// Is performance hardware available?
-			if ( m_PerfHardware ) 
-			{
-				// Query high-resolution performance hardware
-				QueryPerformanceCounter((LARGE_INTEGER*)&m_CurrentTime);
-			} 
-			else 
-			{
-				// Fall back to less accurate timer
-				m_CurrentTime = timeGetTime();
-
-			} // End If no hardware available
-
-			// Calculate elapsed time in seconds
-			fTimeElapsed = (m_CurrentTime - m_LastTime) * m_TimeScale;
-
-		} // End While
+			// Fall back to less accurate timer
+			m_CurrentTime = timeGetTime();
+
+		} // End If no hardware available
+
+		// Calculate elapsed time in seconds
+		fTimeElapsed = (m_CurrentTime - m_LastTime) * m_TimeScale;
 	} // End If
 
 	// Save current frame time
 	m_LastTime = m_CurrentTime;
+	m_FrameTimeElapsed = fTimeElapsed;
 
-	// Filter out values wildly different from current average
-	if ( fabsf(fTimeElapsed - m_TimeElapsed) < 1.0f  )
-	{
-		// Wrap FIFO frame time buffer.
-		memmove( &m_FrameTime[1], m_FrameTime, (MAX_SAMPLE_COUNT - 1) * sizeof(float) );
-		m_FrameTime[ 0 ] = fTimeElapsed;
-		if ( m_SampleCount < MAX_SAMPLE_COUNT ) m_SampleCount++;
-
-	} // End if
-	
+	// Every frame goes in the histogram, the slow ones are the point
+	m_Profiler.endFrame( fTimeElapsed );
 
 	// Calculate Frame Rate
 	m_FPSFrameCount++;
-	m_FPSTimeElapsed += m_TimeElapsed;
+	m_FPSTimeElapsed += fTimeElapsed;
 	if ( m_FPSTimeElapsed > 1.0f) 
 	{
 		m_FrameRate			= m_FPSFrameCount;
@@ -129,11 +122,8 @@ void CTimer::Tick( float fLockFPS )
 		m_FPSTimeElapsed	= 0.0f;
 	} // End If Second Elapsed
 
-	// Count up the new average elapsed time
-	m_TimeElapsed = 0.0f;
-	for ( ULONG i = 0; i < m_SampleCount; i++ ) m_TimeElapsed += m_FrameTime[ i ];
-	if ( m_SampleCount > 0 ) m_TimeElapsed /= m_SampleCount;
-
+	// Average over the rolling window
+	m_TimeElapsed = (float)m_Profiler.window( FrameProfiler::PHASE_FRAME ).mean();
 }
 
 //-----------------------------------------------------------------------------
@@ -158,9 +148,20 @@ unsigned long CTimer::GetFrameRate( LPTSTR lpszString, size_t size ) const
 
 //-----------------------------------------------------------------------------
 // Name : GetTimeElapsed () 
-// Desc : Returns the amount of time elapsed since the last frame (Seconds)
+// Desc : Returns the amount of time elapsed since the last frame (Seconds),
+//		averaged over the last few seconds.
 //-----------------------------------------------------------------------------
 float CTimer::GetTimeElapsed() const
 {
 	return m_TimeElapsed;
 }
+
+//-----------------------------------------------------------------------------
+// Name : GetFrameTime () 
+// Desc : Returns the time the last frame took (Seconds), as measured. The
+//		fixed step simulation needs every second of it.
+//-----------------------------------------------------------------------------
+float CTimer::GetFrameTime() const
+{
+	return m_FrameTimeElapsed;
+}
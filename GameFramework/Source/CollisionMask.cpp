@@ -0,0 +1,119 @@
+// CollisionMask.cpp
+// Pixel exact hit tests on packed rows of bits.
+#include "CollisionMask.h"
+#include "Surface.h"
+
+namespace
+{
+	// The 64 bits of a row starting at pixel start, which may be left of
+	// the row or past its end; pixels outside of it are clear.
+	inline uint64_t bitsFrom(const uint64_t *row, int words, int start)
+	{
+		if( start < 0 )
+			return start > -64 ? row[0] << -start : 0;
+
+		int w = start >> 6;
+		int s = start & 63;
+		if( w >= words )
+			return 0;
+
+		uint64_t bits = row[w] >> s;
+		if( s && w + 1 < words )
+			bits |= row[w + 1] << (64 - s);
+		return bits;
+	}
+
+	int bitCount(uint64_t bits)
+	{
+		int n = 0;
+		for( ; bits; bits &= bits - 1 )
+			++n;
+		return n;
+	}
+}
+
+void CollisionMask::create(int width, int height)
+{
+	if( width <= 0 || height <= 0 )
+	{
+		clear();
+		return;
+	}
+
+	mWidth = width;
+	mHeight = height;
+	mWordsPerRow = (width + 63) / 64;
+	mBits.assign((size_t)mWordsPerRow * height, 0);
+}
+
+void CollisionMask::clear()
+{
+	mWidth = mHeight = mWordsPerRow = 0;
+	mBits.clear();
+}
+
+void CollisionMask::buildFromMask(const Surface &mask)
+{
+	create(mask.width(), mask.height());
+
+	for( int y = 0; y < mHeight; ++y )
+	{
+		const uint32_t *src = mask.row(y);
+		for( int x = 0; x < mWidth; ++x )
+			if( (src[x] & 0x00FFFFFF) != 0x00FFFFFF )
+				set(x, y);
+	}
+}
+
+void CollisionMask::buildFromKey(const Surface &image, uint32_t key)
+{
+	create(image.width(), image.height());
+
+	for( int y = 0; y < mHeight; ++y )
+	{
+		const uint32_t *src = image.row(y);
+		for( int x = 0; x < mWidth; ++x )
+			if( src[x] != key )
+				set(x, y);
+	}
+}
+
+int CollisionMask::count() const
+{
+	int n = 0;
+	for( size_t i = 0; i < mBits.size(); ++i )
+		n += bitCount(mBits[i]);
+	return n;
+}
+
+bool CollisionMask::overlap(const CollisionMask &a, int ax, int ay, const CollisionMask &b, int bx, int by)
+{
+	// The rows and the columns of a both cover.
+	int top = ay > by ? ay : by;
+	int bottom = ay + a.mHeight < by + b.mHeight ? ay + a.mHeight : by + b.mHeight;
+	int left = ax > bx ? ax : bx;
+	int right = ax + a.mWidth < bx + b.mWidth ? ax + a.mWidth : bx + b.mWidth;
+	if( top >= bottom || left >= right )
+		return false;
+
+	// Words of a holding those columns, and the pixel of b lined up with
+	// the first pixel of a.
+	int firstWord = (left - ax) >> 6;
+	int lastWord = (right - ax - 1) >> 6;
+	int shift = ax - bx;
+
+	for( int y = top; y < bottom; ++y )
+	{
+		const uint64_t *rowA = a.row(y - ay);
+		const uint64_t *rowB = b.row(y - by);
+
+		// Pixels of a outside b meet clear bits of b, no edge masks needed.
+		for( int w = firstWord; w <= lastWord; ++w )
+		{
+			if( rowA[w] & bitsFrom(rowB, b.mWordsPerRow, w * 64 + shift) )
+				return true;
+		}
+	}
+
+	return false;
+}
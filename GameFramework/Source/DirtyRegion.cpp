@@ -0,0 +1,147 @@
+// DirtyRegion.cpp
+// The parts of a frame that changed.
+#include "DirtyRegion.h"
+
+namespace
+{
+	// Extra pixels a merge may cost, for rectangles that touch or nearly so.
+	const long MERGE_SLACK = 256;
+
+	long rectArea(const RECT &rc)
+	{
+		return (long)(rc.right - rc.left) * (rc.bottom - rc.top);
+	}
+
+	RECT rectUnion(const RECT &a, const RECT &b)
+	{
+		RECT rc;
+		rc.left = a.left < b.left ? a.left : b.left;
+		rc.top = a.top < b.top ? a.top : b.top;
+		rc.right = a.right > b.right ? a.right : b.right;
+		rc.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+		return rc;
+	}
+
+	bool rectsOverlap(const RECT &a, const RECT &b)
+	{
+		return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+	}
+}
+
+DirtyRegion::DirtyRegion()
+	: mWidth(0), mHeight(0), mArea(0), mFullThreshold(0.5f), mFull(false)
+{
+}
+
+void DirtyRegion::setBounds(int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+
+	// One spare for the rectangle being inserted, so adding never allocates.
+	mRects.reserve(MAX_RECTS + 1);
+	clear();
+}
+
+void DirtyRegion::add(int x, int y, int w, int h)
+{
+	if( mFull )
+		return;
+
+	RECT rc;
+	rc.left = x < 0 ? 0 : x;
+	rc.top = y < 0 ? 0 : y;
+	rc.right = x + w > mWidth ? mWidth : x + w;
+	rc.bottom = y + h > mHeight ? mHeight : y + h;
+
+	if( rc.left >= rc.right || rc.top >= rc.bottom )
+		return;
+
+	insert(rc);
+
+	if( mArea > (long)(mFullThreshold * mWidth * mHeight) )
+		addAll();
+}
+
+void DirtyRegion::add(const DirtyRegion &other)
+{
+	if( other.mFull )
+	{
+		addAll();
+		return;
+	}
+
+	for( size_t i = 0; i < other.mRects.size() && !mFull; ++i )
+	{
+		const RECT &rc = other.mRects[i];
+		add(rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top);
+	}
+}
+
+void DirtyRegion::addAll()
+{
+	mRects.clear();
+	mFull = mWidth > 0 && mHeight > 0;
+
+	if( mFull )
+	{
+		RECT rc = { 0, 0, mWidth, mHeight };
+		mRects.push_back(rc);
+	}
+
+	mArea = (long)mWidth * mHeight;
+}
+
+void DirtyRegion::clear()
+{
+	mRects.clear();
+	mArea = 0;
+	mFull = false;
+}
+
+void DirtyRegion::insert(RECT rc)
+{
+	// Absorb every rectangle rc overlaps or sits right next to. The union
+	// can reach rectangles that were apart, so start over after a merge.
+	for( size_t i = 0; i < mRects.size(); )
+	{
+		RECT merged = rectUnion(rc, mRects[i]);
+
+		if( rectsOverlap(rc, mRects[i]) || rectArea(merged) <= rectArea(rc) + rectArea(mRects[i]) + MERGE_SLACK )
+		{
+			mArea -= rectArea(mRects[i]);
+			mRects[i] = mRects.back();
+			mRects.pop_back();
+			rc = merged;
+			i = 0;
+		}
+		else
+			++i;
+	}
+
+	if( mRects.size() < MAX_RECTS )
+	{
+		mRects.push_back(rc);
+		mArea += rectArea(rc);
+		return;
+	}
+
+	// Too many rectangles, merge rc with the one that grows the least.
+	size_t best = 0;
+	long bestCost = 0;
+	for( size_t i = 0; i < mRects.size(); ++i )
+	{
+		long cost = rectArea(rectUnion(rc, mRects[i])) - rectArea(mRects[i]);
+		if( i == 0 || cost < bestCost )
+		{
+			best = i;
+			bestCost = cost;
+		}
+	}
+
+	RECT merged = rectUnion(rc, mRects[best]);
+	mArea -= rectArea(mRects[best]);
+	mRects[best] = mRects.back();
+	mRects.pop_back();
+	insert(merged);
+}
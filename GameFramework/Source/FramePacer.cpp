@@ -0,0 +1,136 @@
+// FramePacer.cpp
+// Sleeps, then spins, until the next frame.
+#include "FramePacer.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")
+#endif
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define PACER_PAUSE() _mm_pause()
+#else
+#define PACER_PAUSE()
+#endif
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace
+{
+	// The margin stays in this range, in seconds.
+	const double MIN_MARGIN = 0.0002;
+	const double MAX_MARGIN = 0.004;
+
+	// Spun on top of the last overshoot, and the share of the distance to
+	// it the margin shrinks by after a sleep that was on time.
+	const double MARGIN_SLACK = 0.0001;
+	const double MARGIN_DECAY = 0.05;
+}
+
+FramePacer::FramePacer() : mMargin(0.002), mMaxOvershoot(0), mSleeps(0)
+{
+#ifdef _WIN32
+	// Windows 10 1803 and later sleep to the 0.5 ms, older ones to the
+	// timer period, which is brought down to 1 ms.
+	mTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if( !mTimer )
+		timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if( mTimer )
+		CloseHandle(mTimer);
+	else
+		timeEndPeriod(1);
+#endif
+}
+
+double FramePacer::now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FramePacer::waitUntil(double deadline)
+{
+	double start = now();
+	double sleep = deadline - start - mMargin;
+
+	if( sleep > 0 )
+	{
+		sleepFor(sleep);
+		adaptMargin(now() - start - sleep);
+	}
+
+	spinUntil(deadline);
+}
+
+void FramePacer::sleepUntil(double deadline)
+{
+	double start = now();
+	if( deadline > start )
+		sleepFor(deadline - start);
+}
+
+void FramePacer::spinUntil(double deadline)
+{
+	while( now() < deadline )
+		PACER_PAUSE();
+}
+
+void FramePacer::sleepFor(double seconds)
+{
+	++mSleeps;
+
+#ifdef _WIN32
+	if( mTimer )
+	{
+		// Relative due times are negative, in 100 ns units.
+		LARGE_INTEGER due;
+		due.QuadPart = -(LONGLONG)(seconds * 1e7);
+		if( SetWaitableTimer(mTimer, &due, 0, NULL, NULL, FALSE) )
+		{
+			WaitForSingleObject(mTimer, INFINITE);
+			return;
+		}
+	}
+
+	Sleep((DWORD)(seconds * 1000.0));
+#else
+	timespec request;
+	request.tv_sec = (time_t)seconds;
+	request.tv_nsec = (long)((seconds - (double)request.tv_sec) * 1e9);
+
+	// Signals cut the sleep short, finish it.
+	timespec remaining;
+	while( clock_nanosleep(CLOCK_MONOTONIC, 0, &request, &remaining) == EINTR )
+		request = remaining;
+#endif
+}
+
+void FramePacer::adaptMargin(double overshoot)
+{
+	if( overshoot > mMaxOvershoot )
+		mMaxOvershoot = overshoot;
+
+	double target = overshoot + MARGIN_SLACK;
+	if( target > mMargin )
+		mMargin = target;
+	else
+		mMargin += (target - mMargin) * MARGIN_DECAY;
+
+	if( mMargin < MIN_MARGIN ) mMargin = MIN_MARGIN;
+	if( mMargin > MAX_MARGIN ) mMargin = MAX_MARGIN;
+}
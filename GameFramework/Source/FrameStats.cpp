@@ -0,0 +1,221 @@
+// FrameStats.cpp
+// Frame time histograms and the per phase profiler.
+#include "FrameStats.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	double profilerNow()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+FrameHistogram::FrameHistogram()
+{
+	clear();
+}
+
+void FrameHistogram::clear()
+{
+	memset(mCounts, 0, sizeof(mCounts));
+	mCount = 0;
+	mSum = 0;
+	mMax = 0;
+}
+
+int FrameHistogram::bucketOf(double seconds)
+{
+	double us = seconds * 1e6;
+	if( !(us >= 0) )
+		return 0;
+	if( us >= 4294967295.0 )
+		return BUCKET_COUNT - 1;
+
+	// Below SUB_BUCKETS every microsecond has a bucket, above it the top
+	// four bits after the leading one pick the bucket in the octave.
+	uint32_t v = (uint32_t)us;
+	if( v < SUB_BUCKETS )
+		return (int)v;
+
+	int top = 31;
+	while( !(v & (1u << top)) )
+		--top;
+
+	int shift = top - 4;
+	return SUB_BUCKETS + shift * SUB_BUCKETS + (int)((v >> shift) - SUB_BUCKETS);
+}
+
+double FrameHistogram::bucketLow(int i)
+{
+	if( i < SUB_BUCKETS )
+		return i * 1e-6;
+
+	int shift = (i - SUB_BUCKETS) / SUB_BUCKETS;
+	int sub = (i - SUB_BUCKETS) % SUB_BUCKETS;
+	return (double)((uint64_t)(SUB_BUCKETS + sub) << shift) * 1e-6;
+}
+
+double FrameHistogram::bucketHigh(int i)
+{
+	return i + 1 < BUCKET_COUNT ? bucketLow(i + 1) : bucketLow(i) * 2;
+}
+
+void FrameHistogram::add(double seconds)
+{
+	++mCounts[bucketOf(seconds)];
+	++mCount;
+	mSum += seconds;
+	if( seconds > mMax )
+		mMax = seconds;
+}
+
+void FrameHistogram::add(const FrameHistogram &rhs)
+{
+	for( int i = 0; i < BUCKET_COUNT; ++i )
+		mCounts[i] += rhs.mCounts[i];
+
+	mCount += rhs.mCount;
+	mSum += rhs.mSum;
+	if( rhs.mMax > mMax )
+		mMax = rhs.mMax;
+}
+
+double FrameHistogram::percentile(double p) const
+{
+	if( !mCount )
+		return 0.0;
+
+	// Rank of the sample, 1 based, the largest one for p = 100.
+	uint32_t rank = (uint32_t)ceil(p / 100.0 * mCount);
+	if( rank < 1 ) rank = 1;
+	if( rank >= mCount )
+		return mMax;
+
+	uint32_t seen = 0;
+	for( int i = 0; i < BUCKET_COUNT; ++i )
+	{
+		seen += mCounts[i];
+		if( seen >= rank )
+		{
+			// Middle of the bucket, never past the largest sample.
+			double t = (bucketLow(i) + bucketHigh(i)) * 0.5;
+			return t < mMax ? t : mMax;
+		}
+	}
+
+	return mMax;
+}
+
+const double FrameProfiler::SLICE_TIME = 0.5;
+
+FrameProfiler::FrameProfiler()
+{
+	clear();
+}
+
+void FrameProfiler::clear()
+{
+	for( int p = 0; p < PHASE_COUNT; ++p )
+	{
+		for( int s = 0; s < WINDOW_SLICES; ++s )
+			mSlices[p][s].clear();
+
+		mTotal[p].clear();
+		mWindowValid[p] = false;
+		mPhaseStart[p] = 0;
+	}
+
+	mSlice = 0;
+	mSliceTime = 0;
+}
+
+void FrameProfiler::begin(Phase phase)
+{
+	mPhaseStart[phase] = profilerNow();
+}
+
+void FrameProfiler::end(Phase phase)
+{
+	record(phase, profilerNow() - mPhaseStart[phase]);
+}
+
+void FrameProfiler::record(Phase phase, double seconds)
+{
+	mSlices[phase][mSlice].add(seconds);
+	mTotal[phase].add(seconds);
+	mWindowValid[phase] = false;
+}
+
+void FrameProfiler::endFrame(double frameSeconds)
+{
+	record(PHASE_FRAME, frameSeconds);
+
+	// Start a new slice, dropping the oldest one.
+	mSliceTime += frameSeconds;
+	if( mSliceTime >= SLICE_TIME )
+	{
+		mSliceTime = 0;
+		mSlice = (mSlice + 1) % WINDOW_SLICES;
+
+		for( int p = 0; p < PHASE_COUNT; ++p )
+		{
+			mSlices[p][mSlice].clear();
+			mWindowValid[p] = false;
+		}
+	}
+}
+
+const FrameHistogram& FrameProfiler::window(Phase phase) const
+{
+	if( !mWindowValid[phase] )
+	{
+		mWindow[phase].clear();
+		for( int s = 0; s < WINDOW_SLICES; ++s )
+			mWindow[phase].add(mSlices[phase][s]);
+		mWindowValid[phase] = true;
+	}
+
+	return mWindow[phase];
+}
+
+const char* FrameProfiler::phaseName(Phase phase)
+{
+	switch( phase )
+	{
+	case PHASE_FRAME:		return "frame";
+	case PHASE_INPUT:		return "input";
+	case PHASE_SIMULATION:	return "simulation";
+	case PHASE_DRAW:		return "draw";
+	case PHASE_PRESENT:		return "present";
+	default:				return "unknown";
+	}
+}
+
+bool FrameProfiler::writeCsv(const char *szFileName) const
+{
+	FILE *f = fopen(szFileName, "w");
+	if( !f )
+		return false;
+
+	fprintf(f, "phase,range,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+
+	for( int p = 0; p < PHASE_COUNT; ++p )
+	{
+		const FrameHistogram *ranges[2] = { &window((Phase)p), &mTotal[p] };
+		const char *names[2] = { "window", "total" };
+
+		for( int r = 0; r < 2; ++r )
+		{
+			const FrameHistogram &h = *ranges[r];
+			fprintf(f, "%s,%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f\n", phaseName((Phase)p), names[r], h.count(),
+					h.mean() * 1000.0, h.percentile(50) * 1000.0, h.percentile(95) * 1000.0,
+					h.percentile(99) * 1000.0, h.maximum() * 1000.0);
+		}
+	}
+
+	return fclose(f) == 0;
+}
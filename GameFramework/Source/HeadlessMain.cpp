@@ -0,0 +1,286 @@
+//-----------------------------------------------------------------------------
+// File: HeadlessMain.cpp
+//
+// Desc: Headless driver entry point. Runs matches of the simulation with
+//	   scripted inputs and no window, display or message pump, as fast as
+//	   the CPU allows, then prints a short report.
+//
+//	   With -render every step is also drawn into an off-screen back
+//	   buffer, and written to a file of raw frames with -output. -csv
+//	   writes the frame time percentiles of every phase. -audio mixes the
+//	   sounds of the run in step with it, into a WAV file or nowhere
+//	   (null), and reports the mixer time per block; -music streams a WAV
+//	   file under them, looping.
+//
+//	   Usage: Headless [-frames N] [-dt seconds] [-seed N] [-render] [-output file] [-threads N] [-csv file]
+//			  [-audio file|null] [-music file]
+//			  Headless -bench name [-iterations N]
+//
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Headless Driver Includes
+//-----------------------------------------------------------------------------
+#include "CGameWorld.h"
+#include "CGameRenderer.h"
+#include "CGameAudio.h"
+#include "Benchmarks.h"
+#include "FrameStats.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// Name : CBotInput (Class)
+// Desc : Deterministic scripted input, holds a random direction for a while
+//		and fires / turns now and then.
+//-----------------------------------------------------------------------------
+class CBotInput
+{
+public:
+	CBotInput(unsigned int uSeed) : m_uState(uSeed ? uSeed : 1) { }
+
+	void Generate(SWorldInput& Input, unsigned long ulStep)
+	{
+		for (int i = 0; i < CGameWorld::PLAYER_COUNT; i++)
+		{
+			SPlayerInput& in = Input.Players[i];
+
+			// Keep a direction for 30 steps, like a player holding a key
+			if (ulStep % 30 == 0) m_ulDirection[i] = 1UL << (Next() % 5);
+
+			in.ulDirection	= m_ulDirection[i] & 0xF;
+			in.bFire		= (Next() % 8) == 0;
+			in.bRotateLeft	= (Next() % 240) == 0;
+			in.bRotateRight	= (Next() % 240) == 0;
+			in.bExplode		= false;
+		}
+	}
+
+private:
+	unsigned int Next()
+	{
+		// xorshift32
+		m_uState ^= m_uState << 13;
+		m_uState ^= m_uState >> 17;
+		m_uState ^= m_uState << 5;
+		return m_uState;
+	}
+
+	unsigned int	m_uState;
+	unsigned long	m_ulDirection[CGameWorld::PLAYER_COUNT];
+};
+
+//-----------------------------------------------------------------------------
+// Name : main() (Application Entry Point)
+// Desc : Entry point for the headless driver.
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	unsigned long	ulFrames	= 100000;
+	float			fStep		= CGameWorld::STEP_TIME;
+	unsigned int	uSeed		= 1;
+	const char*		szBench		= NULL;
+	unsigned long	ulIterations = 200;
+	bool			bRender		= false;
+	const char*		szOutput	= NULL;
+	int				iThreads	= 1;
+	const char*		szCsv		= NULL;
+	const char*		szAudio		= NULL;
+	const char*		szMusic		= NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-frames") && i + 1 < argc)	ulFrames = strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "-dt") && i + 1 < argc)	fStep = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "-seed") && i + 1 < argc)	uSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "-bench") && i + 1 < argc)	szBench = argv[++i];
+		else if (!strcmp(argv[i], "-iterations") && i + 1 < argc) ulIterations = strtoul(argv[++i], NULL, 10);
+		else if (!strcmp(argv[i], "-render"))					bRender = true;
+		else if (!strcmp(argv[i], "-output") && i + 1 < argc)	{ szOutput = argv[++i]; bRender = true; }
+		else if (!strcmp(argv[i], "-threads") && i + 1 < argc)	iThreads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-csv") && i + 1 < argc)		szCsv = argv[++i];
+		else if (!strcmp(argv[i], "-audio") && i + 1 < argc)	szAudio = argv[++i];
+		else if (!strcmp(argv[i], "-music") && i + 1 < argc)	szMusic = argv[++i];
+		else
+		{
+			printf("Usage: %s [-frames N] [-dt seconds] [-seed N] [-render] [-output file] [-threads N] [-csv file]\n", argv[0]);
+			printf("       %*s [-audio file|null] [-music file]\n", (int)strlen(argv[0]), "");
+			printf("       %s -bench name [-iterations N]\n", argv[0]);
+			ListBenchmarks();
+			return 1;
+		}
+	}
+
+	if (szBench)
+		return RunBenchmark(szBench, ulIterations) ? 0 : 1;
+
+	CGameWorld		World;
+	CBotInput		Bot(uSeed);
+	SWorldInput		Input;
+	unsigned long	ulMatches = 0;
+	unsigned long	ulWins[CGameWorld::PLAYER_COUNT] = { 0, 0 };
+
+	// Collision grid totals, averaged per step in the report
+	double			dBoxes = 0, dOccupied = 0, dLayerPairs = 0, dTested = 0, dFound = 0;
+	int				iMaxCell = 0;
+
+	// Off-screen rendering, the size of the maximized game window
+	CGameRenderer	Renderer;
+	BackBuffer*		pBBuffer = NULL;
+	FrameProfiler	Profiler;
+	unsigned long	ulCommands = 0, ulBatches = 0;
+
+	if (bRender)
+	{
+		if (!Renderer.Load())
+		{
+			printf("Cannot load the game images, run from the GameFramework folder\n");
+			return 1;
+		}
+		Renderer.ApplySpriteSizes(World);
+		Renderer.SetRenderThreads(iThreads);
+		World.Reset();
+
+		PresentTarget* pTarget = NULL;
+		if (szOutput)
+		{
+			FilePresentTarget* pFile = new FilePresentTarget(szOutput);
+			if (!pFile->isOpen())
+			{
+				printf("Cannot write %s\n", szOutput);
+				delete pFile;
+				return 1;
+			}
+			pTarget = pFile;
+		}
+		else
+			pTarget = new NullPresentTarget();
+
+		pBBuffer = new BackBuffer(1440, 900, pTarget);
+	}
+
+	// Sound mixed on this thread, as much as each step lasts
+	CGameAudio		Audio;
+	if (szAudio)
+	{
+		AudioOutput* pOutput = strcmp(szAudio, "null") ? (AudioOutput*)new WavFileAudioOutput(szAudio)
+													   : (AudioOutput*)new NullAudioOutput(false);
+		if (!Audio.Load(pOutput, false))
+		{
+			printf("Cannot write %s\n", szAudio);
+			return 1;
+		}
+		if (szMusic && !Audio.PlayMusic(szMusic))
+		{
+			printf("Cannot stream %s\n", szMusic);
+			return 1;
+		}
+	}
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	for (unsigned long ulFrame = 0; ulFrame < ulFrames; ulFrame++)
+	{
+		std::chrono::steady_clock::time_point FrameStart = std::chrono::steady_clock::now();
+
+		Profiler.begin(FrameProfiler::PHASE_INPUT);
+		Bot.Generate(Input, ulFrame);
+		Profiler.end(FrameProfiler::PHASE_INPUT);
+
+		Profiler.begin(FrameProfiler::PHASE_SIMULATION);
+		World.Step(Input, fStep);
+		Profiler.end(FrameProfiler::PHASE_SIMULATION);
+
+		const BroadphaseStats& Collision = World.CollisionStats();
+		dBoxes += Collision.boxes;
+		dOccupied += Collision.occupiedCells;
+		dLayerPairs += Collision.layerPairs;
+		dTested += Collision.pairsTested;
+		dFound += Collision.pairsFound;
+		if (Collision.maxCellEntries > iMaxCell) iMaxCell = Collision.maxCellEntries;
+
+		if (szAudio)
+		{
+			Audio.PlayEvents(World);
+			Audio.Render(fStep);
+		}
+
+		if (pBBuffer)
+		{
+			Profiler.begin(FrameProfiler::PHASE_DRAW);
+			Renderer.Update(fStep);
+			Renderer.Draw(World, *pBBuffer);
+			Profiler.end(FrameProfiler::PHASE_DRAW);
+
+			Profiler.begin(FrameProfiler::PHASE_PRESENT);
+			pBBuffer->present();
+			Profiler.end(FrameProfiler::PHASE_PRESENT);
+
+			ulCommands += (unsigned long)Renderer.Queue().drawnCount();
+			ulBatches += (unsigned long)Renderer.Queue().batchCount();
+		}
+
+		Profiler.endFrame(std::chrono::duration<double>(std::chrono::steady_clock::now() - FrameStart).count());
+
+		// Start a new match as soon as one is decided
+		if (World.IsGameOver())
+		{
+			ulWins[World.Winner()]++;
+			ulMatches++;
+			World.Reset();
+		}
+	}
+
+	double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	printf("frames    : %lu\n", ulFrames);
+	printf("matches   : %lu (player 1: %lu, player 2: %lu)\n", ulMatches, ulWins[0], ulWins[1]);
+	printf("wall time : %.3f s\n", dSeconds);
+	printf("speed     : %.0f frames/s\n", dSeconds > 0 ? ulFrames / dSeconds : 0.0);
+	printf("lives     : %d - %d\n", World.Player(1).lives, World.Player(0).lives);
+	printf("collision : %.1f boxes, %.1f/%d cells used, %d boxes in the fullest, %.1f layer pairs, %.2f pairs tested, %.3f found per step\n",
+		   dBoxes / ulFrames, dOccupied / ulFrames, World.CollisionStats().cells, iMaxCell, dLayerPairs / ulFrames,
+		   dTested / ulFrames, dFound / ulFrames);
+
+	if (pBBuffer)
+	{
+		const BackBuffer::Stats& Stats = pBBuffer->stats();
+		double dRenderMean = Profiler.total(FrameProfiler::PHASE_DRAW).mean() + Profiler.total(FrameProfiler::PHASE_PRESENT).mean();
+		printf("render    : %.3f ms/frame, %.1f sprites in %.1f batches per frame\n", dRenderMean * 1000.0,
+			   (double)ulCommands / ulFrames, (double)ulBatches / ulFrames);
+		printf("pixels    : %llu cleared, %llu presented per frame, %lu/%lu full frames\n",
+			   Stats.totalCleared / Stats.frames, Stats.totalPresented / Stats.frames, Stats.fullFrames, Stats.frames);
+		delete pBBuffer;
+	}
+
+	if (szAudio)
+	{
+		Audio.Release();
+		AudioStats Stats = Audio.Engine().stats();
+		const FrameHistogram& Mix = Stats.mixTimes;
+		printf("audio     : %lu blocks of %.0f ms, mix p50 %.1f us, p99 %.1f us, max %.1f us (p99 %.2f%% of a block), %d voices at most\n",
+			   Stats.blocks, AudioEngine::blockSeconds() * 1000.0, Mix.percentile(50) * 1e6, Mix.percentile(99) * 1e6,
+			   Mix.maximum() * 1e6, Mix.percentile(99) / AudioEngine::blockSeconds() * 100.0, Stats.peakVoices);
+		printf("            %lu requests applied, %d queued at most, %lu overflowed, %lu stream underruns\n",
+			   Stats.commands, Audio.Engine().peakCommandDepth(), Audio.Engine().commandOverflows(), Stats.underruns);
+	}
+
+	// Frame time percentiles per phase, in microseconds
+	for (int i = 0; i < FrameProfiler::PHASE_COUNT; i++)
+	{
+		const FrameHistogram& Times = Profiler.total((FrameProfiler::Phase)i);
+		if (!Times.count()) continue;
+		printf("%-10s: p50 %8.1f us, p95 %8.1f us, p99 %8.1f us, max %8.1f us\n", FrameProfiler::phaseName((FrameProfiler::Phase)i),
+			   Times.percentile(50) * 1e6, Times.percentile(95) * 1e6, Times.percentile(99) * 1e6, Times.maximum() * 1e6);
+	}
+
+	if (szCsv && !Profiler.writeCsv(szCsv))
+	{
+		printf("Cannot write %s\n", szCsv);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,266 @@
+// ImageCache.cpp
+// Decoded sprite images, loaded once per file and shared.
+#include "ImageCache.h"
+#include "MappedFile.h"
+#include "Vec2.h"
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+	std::string makeRotationKey(const std::string &imageKey, int count)
+	{
+		char szCount[16];
+		sprintf(szCount, "@%d", count);
+		return imageKey + szCount;
+	}
+}
+
+size_t SpriteImage::bytes() const
+{
+	return ((size_t)image.width() * image.height() + (size_t)mask.width() * mask.height()) * sizeof(uint32_t) +
+		   spans.spanCount() * sizeof(SpanList::Span) + (spans.height() + 1) * sizeof(int) + collision.bytes();
+}
+
+const ImageHandle& RotationSet::frame(double radians) const
+{
+	// Round to the nearest step, angles wrap all the way round.
+	int n = (int)frames.size();
+	int i = (int)floor(radians * n / (2 * PI) + 0.5) % n;
+	return frames[i < 0 ? i + n : i];
+}
+
+size_t RotationSet::bytes() const
+{
+	size_t total = 0;
+	for( size_t i = 0; i < frames.size(); ++i )
+		total += frames[i]->bytes();
+	return total;
+}
+
+void bakeRotation(const SpriteImage &source, double radians, SpriteImage &frame)
+{
+	int w = source.image.width();
+	int h = source.image.height();
+
+	// Bounding box of the turned image, the epsilon keeps a quarter turn
+	// of w x h at exactly h x w.
+	double c = fabs(cos(radians));
+	double s = fabs(sin(radians));
+	int frameWidth = (int)ceil(w * c + h * s - 1e-6);
+	int frameHeight = (int)ceil(w * s + h * c - 1e-6);
+
+	frame.image.create(frameWidth, frameHeight);
+	frame.mask.create(frameWidth, frameHeight);
+	frame.transparentColor = 0;
+	frame.spans.clear();
+
+	// Each frame pixel takes the source pixel under its center once turned
+	// back: turning the screen axes gives the source step per frame pixel.
+	Vec2 stepX(1.0, 0.0), stepY(0.0, 1.0);
+	stepX.Rotate(radians);
+	stepY.Rotate(radians);
+
+	Vec2 corner(0.5 - frameWidth / 2.0, 0.5 - frameHeight / 2.0);
+	corner.Rotate(radians);
+	corner += Vec2(w / 2.0, h / 2.0);
+
+	for( int y = 0; y < frameHeight; ++y )
+	{
+		uint32_t *img = frame.image.row(y);
+		uint32_t *mask = frame.mask.row(y);
+
+		for( int x = 0; x < frameWidth; ++x )
+		{
+			Vec2 p = corner + stepX * x + stepY * y;
+			int sx = (int)floor(p.x);
+			int sy = (int)floor(p.y);
+
+			img[x] = 0xFF000000u;
+			mask[x] = 0xFFFFFFFFu;
+
+			if( sx < 0 || sy < 0 || sx >= w || sy >= h )
+				continue;
+
+			uint32_t pixel = source.image.row(sy)[sx];
+			if( source.masked() )
+			{
+				img[x] = pixel;
+				mask[x] = source.mask.row(sy)[sx];
+			}
+			else if( pixel != source.transparentColor )
+			{
+				img[x] = pixel;
+				mask[x] = 0xFF000000u;
+			}
+		}
+	}
+
+	frame.collision.buildFromMask(frame.mask);
+}
+
+ImageCache::ImageCache() : mHits(0), mMisses(0), mResidentBytes(0), mNextId(0)
+{
+}
+
+ImageHandle ImageCache::load(const char *szImageFile, const char *szMaskFile)
+{
+	std::string key = makeFileKey(szImageFile) + "|" + makeFileKey(szMaskFile);
+
+	ImageHandle cached = find(key);
+	if( cached )
+		return cached;
+
+	std::shared_ptr<SpriteImage> image = std::make_shared<SpriteImage>();
+	if( !loadSurfaceFromFile(szImageFile, image->image) || !loadSurfaceFromFile(szMaskFile, image->mask) )
+		return ImageHandle();
+
+	// Image and Mask should be the same dimensions, drawing reads both
+	// over the size of the image.
+	if( image->image.width() != image->mask.width() || image->image.height() != image->mask.height() )
+		return ImageHandle();
+	image->collision.buildFromMask(image->mask);
+
+	return insert(key, image);
+}
+
+ImageHandle ImageCache::load(const char *szImageFile, COLORREF crTransparentColor)
+{
+	char szColor[16];
+	sprintf(szColor, "#%06lx", (unsigned long)crTransparentColor & 0xFFFFFF);
+	std::string key = makeFileKey(szImageFile) + szColor;
+
+	ImageHandle cached = find(key);
+	if( cached )
+		return cached;
+
+	std::shared_ptr<SpriteImage> image = std::make_shared<SpriteImage>();
+	if( !loadSurfaceFromFile(szImageFile, image->image) )
+		return ImageHandle();
+
+	// Find the opaque runs once, drawing only copies them.
+	image->transparentColor = colorRefToPixel(crTransparentColor);
+	image->spans.build(image->image, image->transparentColor);
+	image->collision.buildFromKey(image->image, image->transparentColor);
+
+	return insert(key, image);
+}
+
+RotationHandle ImageCache::loadRotations(const char *szImageFile, const char *szMaskFile, int count)
+{
+	std::string key = makeRotationKey(makeFileKey(szImageFile) + "|" + makeFileKey(szMaskFile), count);
+
+	RotationHandle cached = findRotations(key);
+	if( cached )
+		return cached;
+
+	ImageHandle image = load(szImageFile, szMaskFile);
+	if( !image )
+		return RotationHandle();
+
+	return bakeRotations(key, *image, count);
+}
+
+RotationHandle ImageCache::loadRotations(const char *szImageFile, COLORREF crTransparentColor, int count)
+{
+	char szColor[16];
+	sprintf(szColor, "#%06lx", (unsigned long)crTransparentColor & 0xFFFFFF);
+	std::string key = makeRotationKey(makeFileKey(szImageFile) + szColor, count);
+
+	RotationHandle cached = findRotations(key);
+	if( cached )
+		return cached;
+
+	ImageHandle image = load(szImageFile, crTransparentColor);
+	if( !image )
+		return RotationHandle();
+
+	return bakeRotations(key, *image, count);
+}
+
+void ImageCache::purge()
+{
+	std::map<std::string, ImageHandle>::iterator it = mImages.begin();
+	while( it != mImages.end() )
+	{
+		if( it->second.use_count() == 1 )
+		{
+			mResidentBytes -= it->second->bytes();
+			mImages.erase(it++);
+		}
+		else
+			++it;
+	}
+
+	std::map<std::string, RotationHandle>::iterator rot = mRotations.begin();
+	while( rot != mRotations.end() )
+	{
+		if( rot->second.use_count() == 1 )
+		{
+			mResidentBytes -= rot->second->bytes();
+			mRotations.erase(rot++);
+		}
+		else
+			++rot;
+	}
+}
+
+void ImageCache::clear()
+{
+	// Sprites still holding handles keep their images alive.
+	mImages.clear();
+	mRotations.clear();
+	mResidentBytes = 0;
+}
+
+ImageHandle ImageCache::find(const std::string &key)
+{
+	std::map<std::string, ImageHandle>::const_iterator it = mImages.find(key);
+	if( it == mImages.end() )
+		return ImageHandle();
+
+	++mHits;
+	return it->second;
+}
+
+ImageHandle ImageCache::insert(const std::string &key, const std::shared_ptr<SpriteImage> &image)
+{
+	++mMisses;
+	image->id = ++mNextId;
+	mResidentBytes += image->bytes();
+	mImages[key] = image;
+	return image;
+}
+
+RotationHandle ImageCache::findRotations(const std::string &key)
+{
+	std::map<std::string, RotationHandle>::const_iterator it = mRotations.find(key);
+	if( it == mRotations.end() )
+		return RotationHandle();
+
+	++mHits;
+	return it->second;
+}
+
+RotationHandle ImageCache::bakeRotations(const std::string &key, const SpriteImage &source, int count)
+{
+	std::shared_ptr<RotationSet> rotations = std::make_shared<RotationSet>();
+	if( count < 1 )
+		count = 1;
+
+	// Every frame is an image of its own, so the render queue batches the
+	// sprites showing the same heading.
+	for( int i = 0; i < count; ++i )
+	{
+		std::shared_ptr<SpriteImage> frame = std::make_shared<SpriteImage>();
+		if( !source.image.empty() )
+			bakeRotation(source, 2 * PI * i / count, *frame);
+		frame->id = ++mNextId;
+		rotations->frames.push_back(frame);
+	}
+
+	++mMisses;
+	mResidentBytes += rotations->bytes();
+	mRotations[key] = rotations;
+	return rotations;
+}
@@ -2,8 +2,7 @@
 // by Mihai Popescu
 // March 2009
 #include "ImageFile.h"
-
-extern HINSTANCE g_hInst;
+#include "BmpFile.h"
 
 
 CImageFile::CImageFile() : height(m_biInfo.biHeight), width(m_biInfo.biWidth)
@@ -15,9 +14,6 @@ CImageFile::CImageFile() : height(m_biInfo.biHeight), width(m_biInfo.biWidth)
 
 bool CImageFile::LoadBitmapFromFile(const char *szFileName, HDC hdc)
 {
-	BYTE *pData;
-	HDC mdc = CreateCompatibleDC(hdc);
-
 	strcpy_s(m_szFileName, MAX_PATH, szFileName);
 
 	// release previously loaded file data
@@ -33,53 +29,27 @@ bool CImageFile::LoadBitmapFromFile(const char *szFileName, HDC hdc)
 		m_hBMP = 0;
 	}
 
-	// Loads the image.
-	m_hBMP = (HBITMAP)LoadImage(g_hInst, szFileName, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);	
-
-	if(!m_hBMP)
+	// Maps the file and reads its headers.
+	BmpFile bmp;
+	if(!bmp.open(szFileName))
 		return false;
 
-	ZeroMemory(&m_biInfo, sizeof(BITMAPINFO));
-	m_biInfo.biSize=sizeof(BITMAPINFOHEADER);
-
-	// send NULL to bits to get the bitmap info
-	GetDIBits(mdc, m_hBMP, 0, 0, NULL, (BITMAPINFO*)&m_biInfo, DIB_RGB_COLORS);
-
-	pData = new BYTE[m_biInfo.biSizeImage];
+	// Describe the image as the 32 bit bottom-up DIB that Paint hands to GDI
+	ZeroMemory(&m_biInfo, sizeof(BITMAPINFOHEADER));
+	m_biInfo.biSize = sizeof(BITMAPINFOHEADER);
+	m_biInfo.biWidth = bmp.width();
+	m_biInfo.biHeight = bmp.height();
+	m_biInfo.biPlanes = 1;
+	m_biInfo.biBitCount = 32;
+	m_biInfo.biCompression = BI_RGB;
+	m_biInfo.biSizeImage = width * height * sizeof(RGBQUAD);
 
-	// read the bitmap data
-	// NOTE: We use this method to access the bitmap bits in order to modify them
-	// applying different filters or other image processing algorithms in real time 
+	// Convert the rows straight from the file into the RGB image we keep.
+	// NOTE: We keep the bits ourselves in order to modify them applying
+	// different filters or other image processing algorithms in real time
 	// such as blur effect (denoising) or other convolutions.
-	GetDIBits(mdc, m_hBMP, 0, height, pData, (BITMAPINFO*)&m_biInfo, DIB_RGB_COLORS);
-
 	m_pRGB = new RGBQUAD[width * height];
-
-	// Fill RGB image on 32 bit in order to display it
-	if(m_biInfo.biBitCount == 24)
-	{
-		int size = width * height;
-		unsigned char *data = pData;
-		RGBQUAD *c = m_pRGB;
-
-		for(int i=0;i<size;i++)
-		{
-			c->rgbBlue = *data++;
-			c->rgbGreen = *data++;
-			c->rgbRed = *data++;
-			c->rgbReserved = 0;
-			c++;
-		}
-	}
-
-	m_biInfo.biBitCount = 32;
-
-	DeleteObject(m_hBMP);
-	m_hBMP = 0;
-
-	DeleteDC(mdc);
-
-	delete[] pData;
+	bmp.decode((uint32_t*)m_pRGB, width, false, 0);
 
 	return true;
 }
@@ -108,6 +78,32 @@ void CImageFile::Paint(HDC hdc, int x, int y)
 	DeleteDC(mdc);
 }
 
+void CImageFile::Paint(Surface &target, int x, int y)
+{
+	if(!m_pRGB)
+		return;
+
+	// Clip against the target edges
+	int srcX = 0, srcY = 0, w = width, h = height;
+
+	if(x < 0) { srcX = -x; w += x; x = 0; }
+	if(y < 0) { srcY = -y; h += y; y = 0; }
+	if(x + w > target.width()) w = target.width() - x;
+	if(y + h > target.height()) h = target.height() - y;
+
+	if(w <= 0 || h <= 0)
+		return;
+
+	// The DIB rows are stored bottom-up, the surface is top-down
+	for(int j = 0; j < h; j++)
+	{
+		const RGBQUAD *src = m_pRGB + (height - 1 - (srcY + j)) * width + srcX;
+		uint32_t *dst = target.row(y + j) + x;
+
+		for(int i = 0; i < w; i++)
+			dst[i] = 0xFF000000u | *(const uint32_t*)&src[i];
+	}
+}
 
 CImageFile::~CImageFile(void)
 {
@@ -0,0 +1,144 @@
+// MappedFile.cpp
+// Read only file mapping, Win32 and POSIX.
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : mData(0), mSize(0)
+#ifdef _WIN32
+	, mFile(INVALID_HANDLE_VALUE), mMapping(0)
+#else
+	, mFile(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char *szFileName)
+{
+	close();
+
+	mFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if( mFile == INVALID_HANDLE_VALUE )
+		return false;
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx(mFile, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > (size_t)-1 )
+	{
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if( mMapping )
+		mData = (const uint8_t*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if( !mData )
+	{
+		close();
+		return false;
+	}
+
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if( mData )
+		UnmapViewOfFile(mData);
+	if( mMapping )
+		CloseHandle(mMapping);
+	if( mFile != INVALID_HANDLE_VALUE )
+		CloseHandle(mFile);
+
+	mData = 0;
+	mSize = 0;
+	mMapping = 0;
+	mFile = INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::prefetch(size_t, size_t) const
+{
+	// Opened for a sequential scan, the cache manager already reads ahead
+}
+#else
+bool MappedFile::open(const char *szFileName)
+{
+	close();
+
+	mFile = ::open(szFileName, O_RDONLY);
+	if( mFile < 0 )
+		return false;
+
+	struct stat info;
+	if( fstat(mFile, &info) != 0 || info.st_size <= 0 )
+	{
+		close();
+		return false;
+	}
+
+	void *data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if( data == MAP_FAILED )
+	{
+		close();
+		return false;
+	}
+
+	mData = (const uint8_t*)data;
+	mSize = (size_t)info.st_size;
+	madvise(data, mSize, MADV_SEQUENTIAL);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if( mData )
+		munmap((void*)mData, mSize);
+	if( mFile >= 0 )
+		::close(mFile);
+
+	mData = 0;
+	mSize = 0;
+	mFile = -1;
+}
+
+void MappedFile::prefetch(size_t offset, size_t bytes) const
+{
+	if( !mData || offset >= mSize )
+		return;
+	if( bytes > mSize - offset )
+		bytes = mSize - offset;
+
+	// madvise wants a page aligned start
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = offset - offset % page;
+	madvise((void*)(mData + start), offset + bytes - start, MADV_WILLNEED);
+}
+#endif
+
+std::string makeFileKey(const char *szFileName)
+{
+	std::string key(szFileName ? szFileName : "");
+#ifdef _WIN32
+	for( size_t i = 0; i < key.size(); ++i )
+	{
+		if( key[i] >= 'A' && key[i] <= 'Z' )
+			key[i] = key[i] - 'A' + 'a';
+		else if( key[i] == '\\' )
+			key[i] = '/';
+	}
+#endif
+	return key;
+}
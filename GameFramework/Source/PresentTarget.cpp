@@ -0,0 +1,148 @@
+// PresentTarget.cpp
+// Where BackBuffer::present() sends a finished frame.
+#include "PresentTarget.h"
+
+void NullPresentTarget::present(const Surface&)
+{
+	++mFrameCount;
+}
+
+FilePresentTarget::FilePresentTarget(const char *szFileName)
+{
+	mpFile = fopen(szFileName, "wb");
+}
+
+FilePresentTarget::~FilePresentTarget()
+{
+	if( mpFile )
+		fclose(mpFile);
+}
+
+void FilePresentTarget::present(const Surface &surface)
+{
+	if( !mpFile )
+		return;
+
+	for( int y = 0; y < surface.height(); ++y )
+		fwrite(surface.row(y), sizeof(uint32_t), surface.width(), mpFile);
+
+	fflush(mpFile);
+	++mFrameCount;
+}
+
+#ifdef _WIN32
+
+GdiPresentTarget::GdiPresentTarget(HWND hWnd)
+	: mhWnd(hWnd), mhDC(0), mhSurface(0), mhOldObject(0)
+{
+}
+
+GdiPresentTarget::~GdiPresentTarget()
+{
+	if( mhDC )
+	{
+		SelectObject(mhDC, mhOldObject);
+		DeleteDC(mhDC);
+	}
+	DeleteObject(mhSurface);
+}
+
+bool GdiPresentTarget::createSurface(Surface &surface, int width, int height)
+{
+	// Get a handle to the device context associated with
+	// the window.
+	HDC hWndDC = GetDC(mhWnd);
+
+	// Create system memory device context that is compatible
+	// with the window one.
+	mhDC = CreateCompatibleDC(hWndDC);
+
+	// Done with window DC.
+	ReleaseDC(mhWnd, hWndDC);
+
+	// Create a top-down 32 bpp DIB section, its bits are the
+	// surface the game renders into.
+	BITMAPINFO bmi;
+	ZeroMemory(&bmi, sizeof(BITMAPINFO));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = width;
+	bmi.bmiHeader.biHeight = -height;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	void *pBits = 0;
+	mhSurface = CreateDIBSection(mhDC, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
+	if( !mhSurface || !pBits )
+	{
+		// Nothing was selected into the DC, let go of both.
+		if( mhSurface )
+			DeleteObject(mhSurface);
+		mhSurface = 0;
+		DeleteDC(mhDC);
+		mhDC = 0;
+		return false;
+	}
+
+	mhOldObject = (HBITMAP)SelectObject(mhDC, mhSurface);
+
+	// 32 bpp rows are always DWORD aligned, so the pitch is the width.
+	surface.attach((uint32_t*)pBits, width, height, width);
+	return true;
+}
+
+void GdiPresentTarget::present(const Surface &surface)
+{
+	// Get a handle to the device context associated with
+	// the window.
+	HDC hWndDC = GetDC(mhWnd);
+
+	// Copy the backbuffer contents over to the
+	// window client area.
+	if( mhSurface )
+		BitBlt(hWndDC, 0, 0, surface.width(), surface.height(), mhDC, 0, 0, SRCCOPY);
+	else
+	{
+		// The surface is not ours, hand its rows to GDI directly.
+		BITMAPINFO bmi;
+		ZeroMemory(&bmi, sizeof(BITMAPINFO));
+		bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		bmi.bmiHeader.biWidth = surface.pitch();
+		bmi.bmiHeader.biHeight = -surface.height();
+		bmi.bmiHeader.biPlanes = 1;
+		bmi.bmiHeader.biBitCount = 32;
+		bmi.bmiHeader.biCompression = BI_RGB;
+
+		SetDIBitsToDevice(hWndDC, 0, 0, surface.width(), surface.height(), 0, 0, 0, surface.height(),
+						  surface.pixels(), &bmi, DIB_RGB_COLORS);
+	}
+
+	// Always free window DC when done.
+	ReleaseDC(mhWnd, hWndDC);
+
+	++mFrameCount;
+}
+
+void GdiPresentTarget::present(const Surface &surface, const DirtyRegion &region)
+{
+	// Only our own DIB section can be blitted in pieces.
+	if( region.isFull() || !mhSurface )
+	{
+		present(surface);
+		return;
+	}
+
+	HDC hWndDC = GetDC(mhWnd);
+
+	for( int i = 0; i < region.count(); ++i )
+	{
+		const RECT &rc = region.rect(i);
+		BitBlt(hWndDC, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, mhDC, rc.left, rc.top, SRCCOPY);
+	}
+
+	ReleaseDC(mhWnd, hWndDC);
+
+	++mFrameCount;
+}
+
+#endif // _WIN32
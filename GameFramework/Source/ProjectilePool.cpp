@@ -0,0 +1,107 @@
+// ProjectilePool.cpp
+// Structure of arrays store of the shots in flight.
+#include "ProjectilePool.h"
+#include <string.h>
+
+ProjectilePool::ProjectilePool(int capacity) : mSize(0), mDropped(0)
+{
+	if( capacity < 1 )
+		capacity = 1;
+
+	// Allocated once, spawning never allocates.
+	mX.resize(capacity);
+	mY.resize(capacity);
+	mPrevX.resize(capacity);
+	mPrevY.resize(capacity);
+	mVX.resize(capacity);
+	mVY.resize(capacity);
+	mLifetime.resize(capacity);
+	mOwner.resize(capacity);
+	mImage.resize(capacity);
+}
+
+int ProjectilePool::spawn(float x, float y, float vx, float vy, float lifetime, Owner owner, unsigned short image)
+{
+	if( full() )
+	{
+		++mDropped;
+		return -1;
+	}
+
+	int i = mSize++;
+	mX[i] = mPrevX[i] = x;
+	mY[i] = mPrevY[i] = y;
+	mVX[i] = vx;
+	mVY[i] = vy;
+	mLifetime[i] = lifetime;
+	mOwner[i] = (unsigned char)owner;
+	mImage[i] = image;
+	return i;
+}
+
+void ProjectilePool::remove(int i)
+{
+	int last = --mSize;
+	if( i == last )
+		return;
+
+	mX[i] = mX[last];
+	mY[i] = mY[last];
+	mPrevX[i] = mPrevX[last];
+	mPrevY[i] = mPrevY[last];
+	mVX[i] = mVX[last];
+	mVY[i] = mVY[last];
+	mLifetime[i] = mLifetime[last];
+	mOwner[i] = mOwner[last];
+	mImage[i] = mImage[last];
+}
+
+void ProjectilePool::clear()
+{
+	mSize = 0;
+}
+
+void ProjectilePool::update(float dt)
+{
+	// Separate arrays and no branches, each loop vectorizes.
+	float *x = mX.data();
+	float *y = mY.data();
+	float *life = mLifetime.data();
+	const float *vx = mVX.data();
+	const float *vy = mVY.data();
+	int n = mSize;
+
+	for( int i = 0; i < n; ++i )
+		x[i] += vx[i] * dt;
+	for( int i = 0; i < n; ++i )
+		y[i] += vy[i] * dt;
+	for( int i = 0; i < n; ++i )
+		life[i] -= dt;
+}
+
+int ProjectilePool::cull(float left, float top, float right, float bottom)
+{
+	int removed = 0;
+
+	for( int i = 0; i < mSize; )
+	{
+		if( mLifetime[i] <= 0 || mX[i] < left || mX[i] > right || mY[i] < top || mY[i] > bottom )
+		{
+			remove(i);
+			++removed;
+		}
+		else
+			++i;
+	}
+
+	return removed;
+}
+
+void ProjectilePool::savePositions()
+{
+	if( mSize == 0 )
+		return;
+
+	memcpy(mPrevX.data(), mX.data(), mSize * sizeof(float));
+	memcpy(mPrevY.data(), mY.data(), mSize * sizeof(float));
+}
@@ -0,0 +1,112 @@
+// RenderQueue.cpp
+// Retained list of the sprites to draw in a frame.
+#include "RenderQueue.h"
+#include <algorithm>
+
+namespace
+{
+	bool commandLess(const RenderCommand &a, const RenderCommand &b)
+	{
+		if( a.layer != b.layer )
+			return a.layer < b.layer;
+		if( a.image->id != b.image->id )
+			return a.image->id < b.image->id;
+		return a.order < b.order;
+	}
+}
+
+RenderQueue::RenderQueue() : mDrawn(0), mCulled(0), mBatches(0)
+{
+	// Room for a busy frame, so queueing does not allocate.
+	mCommands.reserve(256);
+}
+
+void RenderQueue::add(const ImageHandle &image, const Vec2 &position, int layer)
+{
+	add(image, position, layer, 0, 0, image->image.width(), image->image.height());
+}
+
+void RenderQueue::add(const ImageHandle &image, const Vec2 &position, int layer,
+					  int srcX, int srcY, int w, int h)
+{
+	RenderCommand cmd;
+	cmd.image = image.get();
+	cmd.layer = layer;
+
+	// Same rounding as Sprite::draw.
+	cmd.x = (int)position.x - (w / 2);
+	cmd.y = (int)position.y - (h / 2);
+	cmd.srcX = srcX;
+	cmd.srcY = srcY;
+	cmd.w = w;
+	cmd.h = h;
+	cmd.order = (unsigned int)mCommands.size();
+
+	mCommands.push_back(cmd);
+}
+
+void RenderQueue::sort(int width, int height)
+{
+	// Drop what lies entirely off screen.
+	size_t kept = 0;
+	for( size_t i = 0; i < mCommands.size(); ++i )
+	{
+		const RenderCommand &cmd = mCommands[i];
+		if( cmd.x >= width || cmd.y >= height || cmd.x + cmd.w <= 0 || cmd.y + cmd.h <= 0 )
+			continue;
+
+		mCommands[kept++] = cmd;
+	}
+
+	mDrawn = kept;
+	mCulled = mCommands.size() - kept;
+	mCommands.resize(kept);
+
+	std::sort(mCommands.begin(), mCommands.end(), commandLess);
+
+	mBatches = 0;
+	for( size_t i = 0; i < mCommands.size(); ++i )
+	{
+		if( i == 0 || mCommands[i].image != mCommands[i - 1].image || mCommands[i].layer != mCommands[i - 1].layer )
+			++mBatches;
+	}
+}
+
+void RenderQueue::submit(BackBuffer &backBuffer)
+{
+	sort(backBuffer.width(), backBuffer.height());
+
+	Surface &target = backBuffer.getSurface();
+
+	for( size_t first = 0; first < mCommands.size(); )
+	{
+		// A batch is a run of commands of one image in one layer, they
+		// all go through the same blitter reading the same pixels.
+		const SpriteImage &image = *mCommands[first].image;
+		int layer = mCommands[first].layer;
+
+		size_t last = first + 1;
+		while( last < mCommands.size() && mCommands[last].image == &image && mCommands[last].layer == layer )
+			++last;
+
+		for( size_t i = first; i < last; ++i )
+		{
+			const RenderCommand &cmd = mCommands[i];
+			backBuffer.markDrawn(cmd.x, cmd.y, cmd.w, cmd.h);
+
+			if( image.masked() )
+				blitMasked(target, cmd.x, cmd.y, image.image, image.mask, cmd.srcX, cmd.srcY, cmd.w, cmd.h);
+			else
+				blitSpans(target, cmd.x, cmd.y, image.image, image.spans, cmd.srcX, cmd.srcY, cmd.w, cmd.h);
+		}
+
+		first = last;
+	}
+
+	clear();
+}
+
+void RenderQueue::clear()
+{
+	mCommands.clear();
+}
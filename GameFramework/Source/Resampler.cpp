@@ -0,0 +1,273 @@
+// Resampler.cpp
+// Polyphase windowed sinc sample rate conversion.
+#include "Resampler.h"
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RESAMPLE_X86 1
+#include <emmintrin.h>
+#endif
+
+typedef void (*ResampleFn)(const float *padded, const float *filters, uint64_t up, uint64_t down,
+						   uint64_t &pos, uint64_t &frac, size_t frames, float *out, int stride);
+
+namespace
+{
+	const int HALF_TAPS = Resampler::HALF_TAPS;
+
+	// Kaiser window shape, about 75 dB down past the transition band
+	const double KAISER_BETA = 7.5;
+
+	// Where the filter starts to roll off, as a share of the lower of the
+	// two Nyquist rates. The filter needs the rest to fall off.
+	const double PASSBAND = 0.92;
+
+	const double PI = 3.14159265358979323846;
+
+	// Zeroth order modified Bessel function of the first kind.
+	double besselI0(double x)
+	{
+		double sum = 1, term = 1, q = x * x / 4;
+		for( int k = 1; k < 32; ++k )
+		{
+			term *= q / ((double)k * k);
+			sum += term;
+			if( term < sum * 1e-12 )
+				break;
+		}
+		return sum;
+	}
+
+	// The step between output frames is whole input frames and rest / up
+	// of one; pos and frac say where the next output frame sits, pos from
+	// HALF_TAPS frames into padded.
+	inline void advance(uint64_t &pos, uint64_t &frac, uint64_t whole, uint64_t rest, uint64_t up)
+	{
+		pos += whole;
+		frac += rest;
+		if( frac >= up )
+		{
+			frac -= up;
+			++pos;
+		}
+	}
+
+	void resampleScalar(const float *padded, const float *filters, uint64_t up, uint64_t down,
+						uint64_t &pos, uint64_t &frac, size_t frames, float *out, int stride)
+	{
+		const uint64_t whole = down / up, rest = down % up;
+		const double phaseScale = (double)Resampler::PHASES / up;
+
+		for( size_t n = 0; n < frames; ++n )
+		{
+			double phase = frac * phaseScale;
+			int k = (int)phase;
+			float blend = (float)(phase - k);
+
+			// The taps run from HALF_TAPS - 1 frames before pos to HALF_TAPS
+			// after, padded holds HALF_TAPS frames of silence first
+			const float *x = padded + pos + 1;
+			const float *f0 = filters + k * Resampler::TAPS;
+			const float *f1 = f0 + Resampler::TAPS;
+
+			float sum0 = 0, sum1 = 0;
+			for( int j = 0; j < Resampler::TAPS; ++j )
+			{
+				sum0 += x[j] * f0[j];
+				sum1 += x[j] * f1[j];
+			}
+
+			out[n * stride] = sum0 + (sum1 - sum0) * blend;
+			advance(pos, frac, whole, rest, up);
+		}
+	}
+
+#ifdef RESAMPLE_X86
+	inline float horizontalSum(__m128 v)
+	{
+		v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+		v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+		return _mm_cvtss_f32(v);
+	}
+
+	// Four taps per instruction, both filters of the pair at once.
+	void resampleSSE2(const float *padded, const float *filters, uint64_t up, uint64_t down,
+					  uint64_t &pos, uint64_t &frac, size_t frames, float *out, int stride)
+	{
+		const uint64_t whole = down / up, rest = down % up;
+		const double phaseScale = (double)Resampler::PHASES / up;
+
+		for( size_t n = 0; n < frames; ++n )
+		{
+			double phase = frac * phaseScale;
+			int k = (int)phase;
+			float blend = (float)(phase - k);
+
+			const float *x = padded + pos + 1;
+			const float *f0 = filters + k * Resampler::TAPS;
+			const float *f1 = f0 + Resampler::TAPS;
+
+			__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+			for( int j = 0; j < Resampler::TAPS; j += 4 )
+			{
+				__m128 v = _mm_loadu_ps(x + j);
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(v, _mm_loadu_ps(f0 + j)));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(v, _mm_loadu_ps(f1 + j)));
+			}
+
+			float s0 = horizontalSum(sum0), s1 = horizontalSum(sum1);
+			out[n * stride] = s0 + (s1 - s0) * blend;
+			advance(pos, frac, whole, rest, up);
+		}
+	}
+#endif // RESAMPLE_X86
+
+	uint64_t greatestCommonDivisor(uint64_t a, uint64_t b)
+	{
+		while( b )
+		{
+			uint64_t t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	ResampleFn gResample = 0;
+	ResampleKernel gKernel = RESAMPLE_SCALAR;
+
+	ResampleFn resampleFn()
+	{
+		if( !gResample )
+		{
+			if( isResampleKernelSupported(RESAMPLE_SSE2) )
+				setResampleKernel(RESAMPLE_SSE2);
+			else
+				setResampleKernel(RESAMPLE_SCALAR);
+		}
+
+		return gResample;
+	}
+}
+
+Resampler::Resampler(int inputRate, int outputRate)
+	: mInputRate(inputRate > 0 ? inputRate : 1), mOutputRate(outputRate > 0 ? outputRate : 1)
+{
+	uint64_t divisor = greatestCommonDivisor((uint64_t)mInputRate, (uint64_t)mOutputRate);
+	mUp = mOutputRate / divisor;
+	mDown = mInputRate / divisor;
+
+	// Cut at the lower Nyquist rate, measured in input frames
+	double cutoff = PASSBAND * (mOutputRate < mInputRate ? (double)mOutputRate / mInputRate : 1.0);
+	double windowScale = 1.0 / besselI0(KAISER_BETA);
+
+	// Row k is the filter for an output frame k / PHASES of the way past
+	// an input frame, tap j sits HALF_TAPS - 1 - j frames before it. The
+	// last row equals the first one moved by a frame, it closes the blend.
+	mFilters.resize((PHASES + 1) * TAPS);
+	for( int k = 0; k <= PHASES; ++k )
+	{
+		float *row = &mFilters[k * TAPS];
+		double sum = 0;
+		for( int j = 0; j < TAPS; ++j )
+		{
+			double d = (double)k / PHASES + HALF_TAPS - 1 - j;
+			double x = d / HALF_TAPS;
+			double window = x <= -1 || x >= 1 ? 0 : besselI0(KAISER_BETA * sqrt(1 - x * x)) * windowScale;
+			double sinc = d == 0 ? 1 : sin(PI * cutoff * d) / (PI * cutoff * d);
+			row[j] = (float)(cutoff * sinc * window);
+			sum += row[j];
+		}
+
+		// Every row passes a constant level through unchanged
+		for( int j = 0; j < TAPS; ++j )
+			row[j] = (float)(row[j] / sum);
+	}
+}
+
+size_t Resampler::outputFrames(size_t frames) const
+{
+	// Every output frame whose place falls inside the input
+	return (size_t)((frames * mUp + mDown - 1) / mDown);
+}
+
+void Resampler::process(const float *in, size_t frames, int channels, float *out) const
+{
+	ResampleFn resample = resampleFn();
+	size_t count = outputFrames(frames);
+
+	// One channel at a time, with silence on both sides for the taps
+	// reaching past the ends
+	std::vector<float> padded(frames + TAPS, 0.0f);
+	for( int c = 0; c < channels; ++c )
+	{
+		for( size_t i = 0; i < frames; ++i )
+			padded[HALF_TAPS + i] = in[i * channels + c];
+
+		uint64_t pos = 0, frac = 0;
+		resample(padded.data(), mFilters.data(), mUp, mDown, pos, frac, count, out + c, channels);
+	}
+}
+
+size_t Resampler::available(const ResamplePosition &position, size_t paddedFrames) const
+{
+	// The taps of an output frame at pos reach frame pos + TAPS of padded
+	if( paddedFrames < position.frame + TAPS + 1 )
+		return 0;
+
+	uint64_t end = (paddedFrames - TAPS - position.frame) * mUp;
+	return (size_t)((end - position.fraction + mDown - 1) / mDown);
+}
+
+void Resampler::run(const float *padded, ResamplePosition &position, size_t count, float *out, int stride) const
+{
+	resampleFn()(padded, mFilters.data(), mUp, mDown, position.frame, position.fraction, count, out, stride);
+}
+
+bool isResampleKernelSupported(ResampleKernel kernel)
+{
+	switch( kernel )
+	{
+	case RESAMPLE_SCALAR:
+		return true;
+#ifdef RESAMPLE_X86
+	case RESAMPLE_SSE2:
+		// Every CPU that runs this game has SSE2.
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+void setResampleKernel(ResampleKernel kernel)
+{
+	if( !isResampleKernelSupported(kernel) )
+		kernel = RESAMPLE_SCALAR;
+
+	switch( kernel )
+	{
+#ifdef RESAMPLE_X86
+	case RESAMPLE_SSE2:	gResample = resampleSSE2; break;
+#endif
+	default:			gResample = resampleScalar; break;
+	}
+
+	gKernel = kernel;
+}
+
+ResampleKernel getResampleKernel()
+{
+	resampleFn();
+	return gKernel;
+}
+
+const char* getResampleKernelName(ResampleKernel kernel)
+{
+	switch( kernel )
+	{
+	case RESAMPLE_SCALAR:	return "scalar";
+	case RESAMPLE_SSE2:		return "sse2";
+	default:				return "unknown";
+	}
+}
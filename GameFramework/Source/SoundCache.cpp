@@ -0,0 +1,91 @@
+// SoundCache.cpp
+// Decoded sounds, loaded once per file and shared.
+#include "SoundCache.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+#include "Resampler.h"
+
+namespace
+{
+	// Keeps the first two of more channels.
+	void keepFrontPair(std::vector<float> &samples, int &channels)
+	{
+		if( channels <= 2 )
+			return;
+
+		size_t frames = samples.size() / channels;
+		for( size_t i = 0; i < frames; ++i )
+		{
+			samples[i * 2] = samples[i * channels];
+			samples[i * 2 + 1] = samples[i * channels + 1];
+		}
+		samples.resize(frames * 2);
+		channels = 2;
+	}
+}
+
+SoundCache::SoundCache(int sampleRate) : mSampleRate(sampleRate), mHits(0), mMisses(0), mResidentBytes(0)
+{
+}
+
+SoundHandle SoundCache::load(const char *szFileName)
+{
+	std::string key = makeFileKey(szFileName);
+
+	std::map<std::string, SoundHandle>::const_iterator it = mSounds.find(key);
+	if( it != mSounds.end() )
+	{
+		++mHits;
+		return it->second;
+	}
+
+	std::shared_ptr<Sound> sound = std::make_shared<Sound>();
+	WavFormat format;
+	if( szFileName && loadWav(szFileName, format, sound->samples) )
+	{
+		sound->sampleRate = format.sampleRate;
+		sound->channels = format.channels;
+		if( mSampleRate )
+			keepFrontPair(sound->samples, sound->channels);
+
+		// Converted once here rather than by every voice playing it
+		if( mSampleRate && format.sampleRate != mSampleRate )
+		{
+			Resampler resampler(format.sampleRate, mSampleRate);
+			size_t frames = sound->frames();
+			std::vector<float> converted(resampler.outputFrames(frames) * sound->channels);
+			resampler.process(sound->samples.data(), frames, sound->channels, converted.data());
+			sound->samples.swap(converted);
+			sound->sampleRate = mSampleRate;
+		}
+	}
+	else
+		sound->samples.clear();
+
+	++mMisses;
+	mResidentBytes += sound->bytes();
+	mSounds[key] = sound;
+	return sound;
+}
+
+void SoundCache::purge()
+{
+	std::map<std::string, SoundHandle>::iterator it = mSounds.begin();
+	while( it != mSounds.end() )
+	{
+		if( it->second.use_count() == 1 )
+		{
+			mResidentBytes -= it->second->bytes();
+			mSounds.erase(it++);
+		}
+		else
+			++it;
+	}
+}
+
+void SoundCache::clear()
+{
+	// Voices still holding handles keep their sounds alive.
+	mSounds.clear();
+	mResidentBytes = 0;
+}
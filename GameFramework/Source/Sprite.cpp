@@ -1,61 +1,13 @@
 #include "Sprite.h"
 
-extern HINSTANCE g_hInst;
-
-Sprite::Sprite(int imageID, int maskID)
-{
-	// Load the bitmap resources.
-	mhImage = LoadBitmap(g_hInst, MAKEINTRESOURCE(imageID));
-	mhMask = LoadBitmap(g_hInst, MAKEINTRESOURCE(maskID));
-
-	// Get the BITMAP structure for each of the bitmaps.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
-	GetObject(mhMask, sizeof(BITMAP), &mMaskBM);
-
-	// Image and Mask should be the same dimensions.
-	assert(mImageBM.bmWidth == mMaskBM.bmWidth);
-	assert(mImageBM.bmHeight == mMaskBM.bmHeight);	
-
-	mcTransparentColor = 0;
-	mhSpriteDC = 0;
-}
-
-Sprite::Sprite(const char *szImageFile, const char *szMaskFile)
-{
-	mhImage = (HBITMAP)LoadImage(g_hInst, szImageFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-	mhMask = (HBITMAP)LoadImage(g_hInst, szMaskFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-
-	// Get the BITMAP structure for each of the bitmaps.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
-	GetObject(mhMask, sizeof(BITMAP), &mMaskBM);
-
-	// Image and Mask should be the same dimensions.
-	assert(mImageBM.bmWidth == mMaskBM.bmWidth);
-	assert(mImageBM.bmHeight == mMaskBM.bmHeight);
-
-	mcTransparentColor = 0;
-	mhSpriteDC = 0;
-}
-
-Sprite::Sprite(const char *szImageFile, COLORREF crTransparentColor)
+Sprite::Sprite(const ImageHandle &image) : mpImage(image)
 {
-	mhImage = (HBITMAP)LoadImage(g_hInst, szImageFile, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION | LR_LOADFROMFILE);
-
-	mhMask = 0;
-	mhSpriteDC = 0;
-	mcTransparentColor = crTransparentColor;
-
-	// Get the BITMAP structure for the bitmap.
-	GetObject(mhImage, sizeof(BITMAP), &mImageBM);
+	assert(mpImage);
+	mpBackBuffer = 0;
 }
 
 Sprite::~Sprite()
 {
-	// Free the resources we created in the constructor.
-	DeleteObject(mhImage);
-	DeleteObject(mhMask);
-
-	DeleteDC(mhSpriteDC);
 }
 
 void Sprite::update(float dt)
@@ -66,19 +18,20 @@ void Sprite::update(float dt)
 	// Update bounding rectangle/circle
 }
 
-void Sprite::setBackBuffer(const BackBuffer *pBackBuffer)
+void Sprite::setImage(const ImageHandle &image)
+{
+	assert(image);
+	mpImage = image;
+}
+
+void Sprite::setBackBuffer(BackBuffer *pBackBuffer)
 {
 	mpBackBuffer = pBackBuffer;
-	if(mpBackBuffer)
-	{
-		DeleteDC(mhSpriteDC);
-		mhSpriteDC = CreateCompatibleDC(mpBackBuffer->getDC());
-	}
 }
 
 void Sprite::draw()
 {
-	if( mhMask != 0 )
+	if( mpImage->masked() )
 		drawMask();
 	else
 		drawTransparent();
@@ -89,10 +42,8 @@ void Sprite::drawMask()
 	if( mpBackBuffer == NULL )
 		return;
 
-	HDC hBackBufferDC = mpBackBuffer->getDC();
-
-	// The position BitBlt wants is not the sprite's center
-	// position; rather, it wants the upper-left position,
+	// The position we draw at is not the sprite's center
+	// position; rather, it is the upper-left position,
 	// so compute that.
 	int w = width();
 	int h = height();
@@ -101,28 +52,7 @@ void Sprite::drawMask()
 	int x = (int)mPosition.x - (w / 2);
 	int y = (int)mPosition.y - (h / 2);
 
-	// Note: For this masking technique to work, it is assumed
-	// the backbuffer bitmap has been cleared to some
-	// non-zero value.
-	// Select the mask bitmap.
-	HGDIOBJ oldObj = SelectObject(mhSpriteDC, mhMask);
-
-	// Draw the mask to the backbuffer with SRCAND. This
-	// only draws the black pixels in the mask to the backbuffer,
-	// thereby marking the pixels we want to draw the sprite
-	// image onto.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, 0, 0, SRCAND);
-
-	// Now select the image bitmap.
-	SelectObject(mhSpriteDC, mhImage);
-
-	// Draw the image to the backbuffer with SRCPAINT. This
-	// will only draw the image onto the pixels that where previously
-	// marked black by the mask.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, 0, 0, SRCPAINT);
-
-	// Restore the original bitmap object.
-	SelectObject(mhSpriteDC, oldObj);
+	composite(x, y, 0, 0, w, h);
 }
 
 void Sprite::drawTransparent()
@@ -130,8 +60,6 @@ void Sprite::drawTransparent()
 	if( mpBackBuffer == NULL )
 		return;
 
-	HDC hBackBuffer = mpBackBuffer->getDC();
-
 	int w = width();
 	int h = height();
 
@@ -139,48 +67,38 @@ void Sprite::drawTransparent()
 	int x = (int)mPosition.x - (w / 2);
 	int y = (int)mPosition.y - (h / 2);
 
-	COLORREF crOldBack = SetBkColor(hBackBuffer, RGB(255, 255, 255));
-	COLORREF crOldText = SetTextColor(hBackBuffer, RGB(0, 0, 0));
-	HDC dcImage, dcTrans;
-
-	// Create two memory dcs for the image and the mask
-	dcImage=CreateCompatibleDC(hBackBuffer);
-	dcTrans=CreateCompatibleDC(hBackBuffer);
-
-	// Select the image into the appropriate dc
-	SelectObject(dcImage, mhImage);
-
-	// Create the mask bitmap
-	BITMAP bitmap;
-	GetObject(mhImage, sizeof(BITMAP), &bitmap);
-	HBITMAP bitmapTrans = CreateBitmap(bitmap.bmWidth, bitmap.bmHeight, 1, 1, NULL);
+	composite(x, y, 0, 0, w, h);
+}
 
-	// Select the mask bitmap into the appropriate dc
-	SelectObject(dcTrans, bitmapTrans);
+void Sprite::composite(int x, int y, int srcX, int srcY, int w, int h)
+{
+	Surface &target = mpBackBuffer->getSurface();
 
-	// Build mask based on transparent color
-	SetBkColor(dcImage, mcTransparentColor);
-	BitBlt(dcTrans, 0, 0, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCCOPY);
+	const SpriteImage &image = *mpImage;
 
-	// Do the work - True Mask method - cool if not actual display
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCINVERT);
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcTrans, 0, 0, SRCAND);
-	BitBlt(hBackBuffer, x, y, bitmap.bmWidth, bitmap.bmHeight, dcImage, 0, 0, SRCINVERT);
+	// Whatever the sprite covers has to be presented now and repaired
+	// in the next frame.
+	mpBackBuffer->markDrawn(x, y, w, h);
 
-	// free memory	
-	DeleteDC(dcImage);
-	DeleteDC(dcTrans);
-	DeleteObject(bitmapTrans);
+	if( image.masked() )
+	{
+		// The mask is black where the sprite is and white around it,
+		// the image is black around the sprite. The blitter ANDs the
+		// mask in to cut a hole and ORs the image into it in one pass.
+		// For this to work, it is assumed the backbuffer has been
+		// cleared to some non-zero value.
+		blitMasked(target, x, y, image.image, image.mask, srcX, srcY, w, h);
+		return;
+	}
 
-	// Restore settings
-	SetBkColor(hBackBuffer, crOldBack);
-	SetTextColor(hBackBuffer, crOldText);
+	// Copy the runs of pixels that are not the transparent color.
+	blitSpans(target, x, y, image.image, image.spans, srcX, srcY, w, h);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-AnimatedSprite::AnimatedSprite(const char *szImageFile, const char *szMaskFile, const RECT& rcFirstFrame, int iFrameCount) 
-			: Sprite (szImageFile, szMaskFile)
+AnimatedSprite::AnimatedSprite(const ImageHandle &image, const RECT& rcFirstFrame, int iFrameCount) 
+			: Sprite (image)
 {
 	mptFrameCrop.x = rcFirstFrame.left;
 	mptFrameCrop.y = rcFirstFrame.top;
@@ -204,38 +122,15 @@ void AnimatedSprite::draw()
 	if( mpBackBuffer == NULL )
 		return;
 
-	// The position BitBlt wants is not the sprite's center
-	// position; rather, it wants the upper-left position,
+	// The position we draw at is not the sprite's center
+	// position; rather, it is the upper-left position,
 	// so compute that.
 	int w = miFrameWidth;
 	int h = miFrameHeight;
 
-	HDC hBackBufferDC = mpBackBuffer->getDC();
-
 	// Upper-left corner.
 	int x = (int)mPosition.x - (w / 2);
 	int y = (int)mPosition.y - (h / 2);
 
-	// Note: For this masking technique to work, it is assumed
-	// the backbuffer bitmap has been cleared to some
-	// non-zero value.
-	// Select the mask bitmap.
-	HGDIOBJ oldObj = SelectObject(mhSpriteDC, mhMask);
-
-	// Draw the mask to the backbuffer with SRCAND. This
-	// only draws the black pixels in the mask to the backbuffer,
-	// thereby marking the pixels we want to draw the sprite
-	// image onto.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, mptFrameCrop.x, mptFrameCrop.y, SRCAND);
-
-	// Now select the image bitmap.
-	SelectObject(mhSpriteDC, mhImage);
-
-	// Draw the image to the backbuffer with SRCPAINT. This
-	// will only draw the image onto the pixels that where previously
-	// marked black by the mask.
-	BitBlt(hBackBufferDC, x, y, w, h, mhSpriteDC, mptFrameCrop.x, mptFrameCrop.y, SRCPAINT);
-
-	// Restore the original bitmap object.
-	SelectObject(mhSpriteDC, oldObj);
+	composite(x, y, mptFrameCrop.x, mptFrameCrop.y, w, h);
 }
\ No newline at end of file
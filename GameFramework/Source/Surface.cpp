@@ -0,0 +1,109 @@
+// Surface.cpp
+// 32-bit pixel surface in system memory.
+#include "Surface.h"
+#include "BmpFile.h"
+#include <algorithm>
+
+Surface::Surface() : mpPixels(0), mWidth(0), mHeight(0), mPitch(0)
+{
+}
+
+Surface::Surface(int width, int height) : mpPixels(0), mWidth(0), mHeight(0), mPitch(0)
+{
+	create(width, height);
+}
+
+Surface::~Surface()
+{
+	release();
+}
+
+bool Surface::create(int width, int height)
+{
+	release();
+
+	if( width <= 0 || height <= 0 )
+		return false;
+
+	mStorage.resize((size_t)width * height);
+	mpPixels = &mStorage[0];
+	mWidth = width;
+	mHeight = height;
+	mPitch = width;
+	return true;
+}
+
+void Surface::attach(uint32_t *pPixels, int width, int height, int pitch)
+{
+	release();
+
+	mpPixels = pPixels;
+	mWidth = width;
+	mHeight = height;
+	mPitch = pitch;
+}
+
+void Surface::release()
+{
+	std::vector<uint32_t>().swap(mStorage);
+	mpPixels = 0;
+	mWidth = mHeight = mPitch = 0;
+}
+
+void Surface::clear(uint32_t color)
+{
+	for( int y = 0; y < mHeight; ++y )
+		std::fill(row(y), row(y) + mWidth, color);
+}
+
+#ifdef _WIN32
+
+bool loadSurfaceFromBitmap(HBITMAP hBitmap, Surface &surface)
+{
+	BITMAP bm;
+	if( !hBitmap || !GetObject(hBitmap, sizeof(BITMAP), &bm) )
+		return false;
+
+	if( !surface.create(bm.bmWidth, bm.bmHeight) )
+		return false;
+
+	// Ask GDI for 32 bpp top-down rows, it converts from whatever depth
+	// the bitmap has (1 bpp masks, 8 bpp palettes, 24 bpp images).
+	BITMAPINFO bmi;
+	ZeroMemory(&bmi, sizeof(BITMAPINFO));
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = bm.bmWidth;
+	bmi.bmiHeader.biHeight = -bm.bmHeight;
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	HDC hdc = GetDC(NULL);
+	int lines = GetDIBits(hdc, hBitmap, 0, bm.bmHeight, surface.pixels(), &bmi, DIB_RGB_COLORS);
+	ReleaseDC(NULL, hdc);
+
+	if( lines != bm.bmHeight )
+	{
+		surface.release();
+		return false;
+	}
+
+	// GDI leaves the alpha byte at zero, make every pixel opaque.
+	uint32_t *p = surface.pixels();
+	for( size_t i = 0, n = (size_t)bm.bmWidth * bm.bmHeight; i < n; ++i )
+		p[i] |= 0xFF000000u;
+
+	return true;
+}
+
+#endif // _WIN32
+
+bool loadSurfaceFromFile(const char *szFileName, Surface &surface)
+{
+	BmpFile bmp;
+	if( !bmp.open(szFileName) || !surface.create(bmp.width(), bmp.height()) )
+		return false;
+
+	bmp.decode(surface.pixels(), surface.pitch(), true, 0xFF);
+	return true;
+}
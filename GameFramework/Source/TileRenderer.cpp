@@ -0,0 +1,190 @@
+// TileRenderer.cpp
+// Draws a RenderQueue with several threads, one screen tile at a time.
+#include "TileRenderer.h"
+#include "Blitter.h"
+
+TileRenderer::TileRenderer(int threadCount)
+	: mFrame(0), mBusy(0), mQuit(false), mNextTile(0),
+	  mpQueue(0), mpTarget(0), mTilesX(0), mTilesY(0)
+{
+	setThreadCount(threadCount);
+}
+
+TileRenderer::~TileRenderer()
+{
+	stopWorkers();
+}
+
+void TileRenderer::setThreadCount(int threadCount)
+{
+	if( threadCount < 1 )
+		threadCount = 1;
+	if( threadCount > MAX_THREADS )
+		threadCount = MAX_THREADS;
+
+	if( threadCount == this->threadCount() )
+		return;
+
+	stopWorkers();
+	startWorkers(threadCount - 1);
+}
+
+int TileRenderer::hardwareThreads()
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count ? (int)count : 1;
+}
+
+void TileRenderer::submit(RenderQueue &queue, BackBuffer &backBuffer)
+{
+	Surface &target = backBuffer.getSurface();
+	queue.sort(target.width(), target.height());
+
+	// Pick the blit kernel now, the workers must not race to do it.
+	getBlitKernel();
+
+	int tilesX = (target.width() + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (target.height() + TILE_SIZE - 1) / TILE_SIZE;
+	if( tilesX != mTilesX || tilesY != mTilesY )
+	{
+		mTilesX = tilesX;
+		mTilesY = tilesY;
+		mBins.resize(tilesX * tilesY);
+	}
+
+	// The bins keep their memory from frame to frame.
+	for( size_t i = 0; i < mBins.size(); ++i )
+		mBins[i].clear();
+
+	for( size_t i = 0; i < queue.size(); ++i )
+	{
+		const RenderCommand &cmd = queue.command(i);
+		backBuffer.markDrawn(cmd.x, cmd.y, cmd.w, cmd.h);
+
+		// Sorted commands are on screen, clamp to the frame anyway.
+		int left = cmd.x < 0 ? 0 : cmd.x / TILE_SIZE;
+		int top = cmd.y < 0 ? 0 : cmd.y / TILE_SIZE;
+		int right = (cmd.x + cmd.w - 1) / TILE_SIZE;
+		int bottom = (cmd.y + cmd.h - 1) / TILE_SIZE;
+		if( right >= tilesX ) right = tilesX - 1;
+		if( bottom >= tilesY ) bottom = tilesY - 1;
+
+		for( int ty = top; ty <= bottom; ++ty )
+			for( int tx = left; tx <= right; ++tx )
+				mBins[ty * tilesX + tx].push_back((unsigned int)i);
+	}
+
+	mpQueue = &queue;
+	mpTarget = &target;
+	mNextTile = 0;
+
+	if( mWorkers.empty() )
+		drawTiles();
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBusy = (int)mWorkers.size();
+			++mFrame;
+		}
+		mWake.notify_all();
+
+		// This thread draws tiles too, then waits for the others.
+		drawTiles();
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		while( mBusy > 0 )
+			mDone.wait(lock);
+	}
+
+	mpQueue = 0;
+	mpTarget = 0;
+	queue.clear();
+}
+
+void TileRenderer::startWorkers(int count)
+{
+	// New workers wait for the next frame, not one drawn before they
+	// started, or they would count themselves done with it.
+	unsigned long frame;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = false;
+		frame = mFrame;
+	}
+
+	for( int i = 0; i < count; ++i )
+		mWorkers.push_back(std::thread(&TileRenderer::workerMain, this, frame));
+}
+
+void TileRenderer::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+
+	for( size_t i = 0; i < mWorkers.size(); ++i )
+		mWorkers[i].join();
+
+	mWorkers.clear();
+}
+
+void TileRenderer::workerMain(unsigned long frame)
+{
+	for( ;; )
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while( !mQuit && mFrame == frame )
+				mWake.wait(lock);
+
+			if( mQuit )
+				return;
+
+			frame = mFrame;
+		}
+
+		drawTiles();
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if( --mBusy == 0 )
+			mDone.notify_one();
+	}
+}
+
+void TileRenderer::drawTiles()
+{
+	int count = mTilesX * mTilesY;
+
+	for( int tile = mNextTile++; tile < count; tile = mNextTile++ )
+		drawTile(tile);
+}
+
+void TileRenderer::drawTile(int tile)
+{
+	const std::vector<unsigned int> &bin = mBins[tile];
+	if( bin.empty() )
+		return;
+
+	int tileX = (tile % mTilesX) * TILE_SIZE;
+	int tileY = (tile / mTilesX) * TILE_SIZE;
+	int tileW = mpTarget->width() - tileX < TILE_SIZE ? mpTarget->width() - tileX : TILE_SIZE;
+	int tileH = mpTarget->height() - tileY < TILE_SIZE ? mpTarget->height() - tileY : TILE_SIZE;
+
+	// A view of the tile, the blitters clip to it.
+	Surface view;
+	view.attach(mpTarget->row(tileY) + tileX, tileW, tileH, mpTarget->pitch());
+
+	for( size_t i = 0; i < bin.size(); ++i )
+	{
+		const RenderCommand &cmd = mpQueue->command(bin[i]);
+		const SpriteImage &image = *cmd.image;
+
+		if( image.masked() )
+			blitMasked(view, cmd.x - tileX, cmd.y - tileY, image.image, image.mask, cmd.srcX, cmd.srcY, cmd.w, cmd.h);
+		else
+			blitSpans(view, cmd.x - tileX, cmd.y - tileY, image.image, image.spans, cmd.srcX, cmd.srcY, cmd.w, cmd.h);
+	}
+}
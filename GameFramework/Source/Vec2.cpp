@@ -10,7 +10,7 @@
 // Vec2 Specific Includes
 //-----------------------------------------------------------------------------
 #include "Vec2.h"
-#include "main.h"
+#include <math.h>
 
 Vec2& Vec2::operator-()
 {
@@ -127,3 +127,8 @@ double PrincipleAngle(double radians)
 		return 2 * PI + result;
 	}
 }
+
+Vec2 Lerp(const Vec2& from, const Vec2& to, double t)
+{
+	return Vec2(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t);
+}
@@ -0,0 +1,300 @@
+// WavFile.cpp
+// RIFF WAVE reader, PCM, float and Microsoft ADPCM.
+#include "WavFile.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	const int FORMAT_PCM = 1;
+	const int FORMAT_MSADPCM = 2;
+	const int FORMAT_FLOAT = 3;
+	const int FORMAT_EXTENSIBLE = 0xFFFE;
+
+	// How the step size of an ADPCM channel follows the last nibble.
+	const int ADPCM_ADAPTATION[16] =
+	{
+		230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230
+	};
+
+	inline uint16_t read16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+	inline uint32_t read32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+	bool parseFormat(const uint8_t *p, size_t size, WavFormat &format)
+	{
+		if( size < 16 )
+			return false;
+
+		int tag = read16(p);
+		format.channels = read16(p + 2);
+		format.sampleRate = (int)read32(p + 4);
+		format.blockAlign = read16(p + 12);
+		format.bitsPerSample = read16(p + 14);
+		format.framesPerBlock = 1;
+		format.coefCount = 0;
+
+		// The extensible header names the real format in its sub format GUID.
+		// Only what the chunk holds counts as extra bytes, a 16 or 17 byte
+		// chunk has none
+		size_t extra = size >= 18 ? read16(p + 16) : 0;
+		if( 18 + extra > size )
+			extra = size > 18 ? size - 18 : 0;
+		if( tag == FORMAT_EXTENSIBLE && extra >= 22 )
+			tag = read16(p + 24);
+
+		if( format.channels < 1 || format.sampleRate < 1 || format.blockAlign < 1 )
+			return false;
+
+		switch( tag )
+		{
+		case FORMAT_PCM:
+			format.encoding = WAV_PCM;
+			if( format.bitsPerSample != 8 && format.bitsPerSample != 16 && format.bitsPerSample != 24 && format.bitsPerSample != 32 )
+				return false;
+			return format.blockAlign >= format.channels * format.bitsPerSample / 8;
+
+		case FORMAT_FLOAT:
+			format.encoding = WAV_FLOAT;
+			return format.bitsPerSample == 32 && format.blockAlign >= format.channels * 4;
+
+		case FORMAT_MSADPCM:
+			{
+				// Frames per block and the coefficient table follow the size
+				if( extra < 4 || format.channels > 2 )
+					return false;
+
+				format.encoding = WAV_MSADPCM;
+				format.framesPerBlock = read16(p + 18);
+				format.coefCount = read16(p + 20);
+				if( format.coefCount < 1 || format.coefCount > WavFormat::MAX_ADPCM_COEFS || 4 + 4 * (size_t)format.coefCount > extra )
+					return false;
+
+				for( int i = 0; i < format.coefCount; ++i )
+				{
+					format.coef1[i] = (int16_t)read16(p + 22 + i * 4);
+					format.coef2[i] = (int16_t)read16(p + 24 + i * 4);
+				}
+
+				// A block holds its header, then a nibble per sample past the
+				// two the header gives
+				int header = 7 * format.channels;
+				return format.blockAlign > header &&
+					   format.framesPerBlock >= 2 && format.framesPerBlock <= 2 + (format.blockAlign - header) * 2 / format.channels;
+			}
+
+		default:
+			return false;
+		}
+	}
+
+	inline int clamp16(int v)
+	{
+		return v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+	}
+
+	// Decodes one ADPCM block of size bytes into at most framesPerBlock
+	// frames. Returns the frames written.
+	size_t decodeAdpcmBlock(const WavFormat &format, const uint8_t *p, size_t size, float *out)
+	{
+		const int channels = format.channels;
+		if( size < (size_t)(7 * channels) )
+			return 0;
+
+		int coef1[2], coef2[2], delta[2], sample1[2], sample2[2];
+		for( int c = 0; c < channels; ++c )
+		{
+			int predictor = p[c];
+			if( predictor >= format.coefCount )
+				predictor = 0;
+			coef1[c] = format.coef1[predictor];
+			coef2[c] = format.coef2[predictor];
+			delta[c] = (int16_t)read16(p + channels + c * 2);
+			sample1[c] = (int16_t)read16(p + channels * 3 + c * 2);
+			sample2[c] = (int16_t)read16(p + channels * 5 + c * 2);
+		}
+
+		// The header holds the first two frames, oldest second
+		const float scale = 1.0f / 32768.0f;
+		for( int c = 0; c < channels; ++c )
+		{
+			out[c] = sample2[c] * scale;
+			out[channels + c] = sample1[c] * scale;
+		}
+
+		size_t frames = 2 + (size - 7 * channels) * 2 / channels;
+		if( frames > (size_t)format.framesPerBlock )
+			frames = format.framesPerBlock;
+
+		// Nibbles follow high one first, channels taking turns
+		const uint8_t *nibbles = p + 7 * channels;
+		size_t count = (frames - 2) * channels;
+		float *dst = out + 2 * channels;
+		for( size_t i = 0; i < count; ++i )
+		{
+			int c = (int)(i % channels);
+			int nibble = (i & 1) ? nibbles[i >> 1] & 15 : nibbles[i >> 1] >> 4;
+			int signedNibble = nibble >= 8 ? nibble - 16 : nibble;
+
+			int predicted = (sample1[c] * coef1[c] + sample2[c] * coef2[c]) >> 8;
+			int sample = clamp16(predicted + signedNibble * delta[c]);
+			sample2[c] = sample1[c];
+			sample1[c] = sample;
+
+			delta[c] = (ADPCM_ADAPTATION[nibble] * delta[c]) >> 8;
+			if( delta[c] < 16 )
+				delta[c] = 16;
+
+			*dst++ = sample * scale;
+		}
+
+		return frames;
+	}
+}
+
+bool parseWav(const uint8_t *data, size_t size, WavInfo &info)
+{
+	if( size < 12 || memcmp(data, "RIFF", 4) || memcmp(data + 8, "WAVE", 4) )
+		return false;
+
+	bool haveFormat = false, haveData = false;
+	size_t factFrames = 0;
+	bool haveFact = false;
+	size_t pos = 12;
+	while( pos + 8 <= size )
+	{
+		const uint8_t *chunk = data + pos;
+		size_t chunkSize = read32(chunk + 4);
+		size_t available = size - pos - 8;
+
+		if( !memcmp(chunk, "fmt ", 4) )
+		{
+			if( !parseFormat(chunk + 8, chunkSize < available ? chunkSize : available, info.format) )
+				return false;
+			haveFormat = true;
+		}
+		else if( !memcmp(chunk, "fact", 4) && chunkSize >= 4 && available >= 4 )
+		{
+			factFrames = read32(chunk + 8);
+			haveFact = true;
+		}
+		else if( !memcmp(chunk, "data", 4) )
+		{
+			// Files cut short keep what they hold
+			info.dataOffset = pos + 8;
+			info.dataSize = chunkSize < available ? chunkSize : available;
+			haveData = true;
+		}
+
+		if( chunkSize > available )
+			break;
+		pos += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	if( !haveFormat || !haveData )
+		return false;
+
+	// The last ADPCM block may end on padding, the fact chunk counts the
+	// frames really there
+	info.frames = wavFrames(info.format, info.dataSize);
+	if( haveFact && info.format.encoding == WAV_MSADPCM && factFrames < info.frames )
+		info.frames = factFrames;
+	return true;
+}
+
+size_t wavFrames(const WavFormat &format, size_t size)
+{
+	size_t blocks = size / format.blockAlign;
+	size_t frames = blocks * format.framesPerBlock;
+
+	size_t rest = size % format.blockAlign;
+	if( format.encoding == WAV_MSADPCM && rest >= (size_t)(7 * format.channels) )
+	{
+		size_t partial = 2 + (rest - 7 * format.channels) * 2 / format.channels;
+		frames += partial < (size_t)format.framesPerBlock ? partial : format.framesPerBlock;
+	}
+
+	return frames;
+}
+
+size_t decodeWav(const WavFormat &format, const uint8_t *bytes, size_t size, float *out)
+{
+	const int channels = format.channels;
+	const size_t stride = format.blockAlign;
+
+	if( format.encoding == WAV_MSADPCM )
+	{
+		size_t frames = 0;
+		for( size_t pos = 0; pos < size; pos += stride )
+		{
+			size_t block = size - pos < stride ? size - pos : stride;
+			frames += decodeAdpcmBlock(format, bytes + pos, block, out + frames * channels);
+		}
+		return frames;
+	}
+
+	size_t frames = size / stride;
+	float *dst = out;
+	for( size_t f = 0; f < frames; ++f )
+	{
+		const uint8_t *p = bytes + f * stride;
+		for( int c = 0; c < channels; ++c )
+		{
+			switch( format.bitsPerSample )
+			{
+			case 8:
+				// 8 bit samples are unsigned
+				*dst++ = (p[0] - 128) * (1.0f / 128.0f);
+				p += 1;
+				break;
+			case 16:
+				*dst++ = (int16_t)read16(p) * (1.0f / 32768.0f);
+				p += 2;
+				break;
+			case 24:
+				*dst++ = (int32_t)((uint32_t)(p[0] << 8 | p[1] << 16 | (uint32_t)p[2] << 24)) * (1.0f / 2147483648.0f);
+				p += 3;
+				break;
+			default:
+				if( format.encoding == WAV_FLOAT )
+				{
+					uint32_t bits = read32(p);
+					memcpy(dst++, &bits, sizeof(float));
+				}
+				else
+					*dst++ = (int32_t)read32(p) * (1.0f / 2147483648.0f);
+				p += 4;
+				break;
+			}
+		}
+	}
+
+	return frames;
+}
+
+bool loadWav(const char *szFileName, WavFormat &format, std::vector<float> &samples)
+{
+	FILE *f = fopen(szFileName, "rb");
+	if( !f )
+		return false;
+
+	std::vector<uint8_t> file;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if( size > 0 )
+	{
+		file.resize((size_t)size);
+		file.resize(fread(file.data(), 1, file.size(), f));
+	}
+	fclose(f);
+
+	WavInfo info;
+	if( !parseWav(file.data(), file.size(), info) )
+		return false;
+
+	format = info.format;
+	samples.resize(wavFrames(format, info.dataSize) * format.channels);
+	size_t frames = decodeWav(format, file.data() + info.dataOffset, info.dataSize, samples.data());
+	samples.resize((frames < info.frames ? frames : info.frames) * format.channels);
+	return true;
+}